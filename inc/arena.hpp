@@ -0,0 +1,193 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ */
+/*! \file arena.hpp
+ *  \brief Arena allocation for AST nodes and types.
+ */
+
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace backend {
+
+/*!
+  \addtogroup utilities
+  @{
+*/
+
+class ast_arena;
+
+namespace detail {
+//An arena installed on a thread, and the part of one of its blocks
+//which that thread carves objects from
+struct arena_binding {
+    ast_arena* m_arena;
+    const std::shared_ptr<ast_arena>* m_owner;
+    char* m_current;
+    std::size_t m_remaining;
+    std::size_t m_allocated;
+};
+}
+
+//! A bump allocator for the objects created during one compilation
+/*! Objects are carved out of large contiguous blocks and are never
+  freed individually.  Every object allocated from an arena holds a
+  reference to it, so the blocks are all released together once the
+  last such object dies.
+
+  Each thread on which the arena is installed by an \ref arena_scope
+  carves from a block of its own, so allocating takes no lock.  The
+  lock is only taken to get a new block.
+*/
+class ast_arena
+    : public std::enable_shared_from_this<ast_arena> {
+private:
+    mutable std::mutex m_mutex;
+    std::vector<char*> m_blocks;
+    //Unused parts of blocks, left by scopes which have ended
+    std::vector<std::pair<char*, std::size_t> > m_spare;
+    //Carved from by threads on which the arena isn't installed
+    detail::arena_binding m_unbound;
+    const std::size_t m_block_size;
+    std::size_t m_allocated;
+    //Allocates once b is exhausted.  Called with the lock held.
+    void* refill(detail::arena_binding& b,
+                 std::size_t bytes, std::size_t alignment);
+    //Takes back what a scope did not use
+    void release(detail::arena_binding& b);
+    friend class arena_scope;
+public:
+    //! Constructor
+    /*! \param block_size Size in bytes of each block.  Requests
+      larger than this get a block of their own.
+    */
+    ast_arena(std::size_t block_size = 64 * 1024);
+    ~ast_arena();
+    //! Allocates \p bytes aligned to \p alignment
+    void* allocate(std::size_t bytes, std::size_t alignment);
+    //! Number of bytes handed out so far
+    /*! Bytes handed out within an \ref arena_scope are counted
+      once the scope ends, or its thread needs a new block.
+    */
+    std::size_t allocated() const;
+    //! Number of blocks obtained from the heap so far
+    std::size_t blocks() const;
+};
+
+//! Standard allocator interface to an \ref ast_arena
+/*! Deallocation does nothing; the memory is reclaimed when the
+  arena is destroyed.
+*/
+template<typename T>
+class arena_allocator {
+private:
+    std::shared_ptr<ast_arena> m_arena;
+    template<typename U> friend class arena_allocator;
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    template<typename U>
+    struct rebind {
+        typedef arena_allocator<U> other;
+    };
+
+    arena_allocator(const std::shared_ptr<ast_arena>& a)
+        : m_arena(a) {}
+    template<typename U>
+    arena_allocator(const arena_allocator<U>& o)
+        : m_arena(o.m_arena) {}
+
+    pointer allocate(size_type n, const void* = 0) {
+        return static_cast<pointer>(
+            m_arena->allocate(n * sizeof(T),
+                              std::alignment_of<T>::value));
+    }
+    void deallocate(pointer, size_type) {}
+    size_type max_size() const {
+        return std::size_t(-1) / sizeof(T);
+    }
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new((void*)p) U(std::forward<Args>(args)...);
+    }
+    template<typename U>
+    void destroy(U* p) {
+        p->~U();
+    }
+    template<typename U>
+    bool operator==(const arena_allocator<U>& o) const {
+        return m_arena == o.m_arena;
+    }
+    template<typename U>
+    bool operator!=(const arena_allocator<U>& o) const {
+        return m_arena != o.m_arena;
+    }
+};
+
+//! Installs an arena for the current thread
+/*! While an \p arena_scope is alive, \ref make_node allocates from
+  its arena on this thread.  Scopes nest; destroying a scope
+  reinstates the arena which was current before it.
+*/
+class arena_scope {
+private:
+    std::shared_ptr<ast_arena> m_owner;
+    detail::arena_binding m_previous;
+public:
+    arena_scope(ast_arena* a);
+    ~arena_scope();
+};
+
+namespace detail {
+//Gets the arena installed on this thread, or null if there is none
+ast_arena* current_arena();
+//Gets the reference to the current arena which objects allocated
+//from it share, or null if there is none
+const std::shared_ptr<ast_arena>* current_owner();
+}
+
+//! Creates a shared object, in the current arena if there is one
+/*! AST nodes and types should be created with this rather than
+  with \p std::make_shared, so that compilations run with an arena
+  allocate them contiguously.
+*/
+template<typename T, typename... Args>
+std::shared_ptr<T> make_node(Args&&... args) {
+    const std::shared_ptr<ast_arena>* a = detail::current_owner();
+    if (a) {
+        return std::allocate_shared<T>(
+            arena_allocator<T>(*a),
+            std::forward<Args>(args)...);
+    }
+    return std::make_shared<T>(std::forward<Args>(args)...);
+}
+
+/*!
+  @}
+*/
+
+}
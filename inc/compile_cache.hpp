@@ -0,0 +1,120 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ */
+/*! \file compile_cache.hpp
+ *  \brief A persistent cache of compilation results.
+ */
+
+#pragma once
+#include <string>
+#include "statement.hpp"
+#include "prelude/runtime/tags.h"
+
+namespace backend {
+
+/*!
+  \addtogroup utilities
+  @{
+*/
+
+//! A content addressed, on-disk cache of compilation results
+/*! Entries are keyed by a \ref backend::structural_hash
+  "structural hash" of the input \ref backend::suite "suite",
+  combined with the entry point and the backend system tag.  Each
+  key may hold several artifacts, distinguished by suffix: the
+  compiler stores generated C++ under ".cpp", and callers may store
+  binaries built from it under suffixes of their own choosing.
+
+  Since keys are 64 bit hashes, the canonical serialization they are
+  hashed from is stored next to the artifacts of each key, under
+  ".key".  Lookups return an artifact only if the serialization
+  matches, so inputs whose keys collide are never confused.
+
+  Files are written to a temporary file in the cache directory and
+  renamed into place, so concurrent processes sharing a cache
+  directory never observe a partially written file.
+*/
+class compile_cache {
+private:
+    std::string m_dir;
+public:
+    //! Constructor
+    /*! \param dir The directory holding the cache. It is created
+      on first store if it does not exist.
+    */
+    compile_cache(const std::string& dir = default_dir());
+
+    //! The default cache directory
+    /*! This is the value of the environment variable
+      COPPERHEAD_CACHE_DIR if it is set, and
+      $HOME/.copperhead/cache otherwise.
+    */
+    static std::string default_dir();
+
+    //! Computes the canonical serialization of a compilation
+    /*! \param n The input suite.
+        \param entry_point The name of the entry point function.
+        \param t The backend system tag.
+        \return A string which is equal for two compilations exactly
+        when their inputs have the same structure.
+    */
+    std::string canonical(const suite& n,
+                          const std::string& entry_point,
+                          const copperhead::system_variant& t) const;
+
+    //! Computes the key for a canonical serialization
+    /*! \return A hexadecimal string.
+    */
+    std::string key(const std::string& canonical) const;
+
+    //! Computes the key for a compilation
+    std::string key(const suite& n,
+                    const std::string& entry_point,
+                    const copperhead::system_variant& t) const;
+
+    //! The path where an artifact is stored
+    std::string path(const std::string& key,
+                     const std::string& suffix) const;
+
+    //! Loads an artifact
+    /*! \param canonical The canonical serialization of the
+      compilation the artifact was produced by.
+      \return true if the artifact was found, and was stored for
+      the same serialization, in which case \p contents holds it.
+    */
+    bool lookup(const std::string& canonical,
+                const std::string& suffix,
+                std::string& contents) const;
+
+    //! Stores an artifact
+    /*! \return true if the artifact was written.  Failing to write
+      to the cache is not an error: it only costs a recompilation
+      later.  Artifacts are not written when another serialization
+      with the same key already owns it.
+    */
+    bool store(const std::string& canonical,
+               const std::string& suffix,
+               const std::string& contents) const;
+
+    //! Gets the cache directory
+    const std::string& dir() const;
+};
+
+/*!
+  @}
+*/
+
+}
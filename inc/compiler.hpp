@@ -23,6 +23,7 @@
 #include <string>
 #include "node.hpp"
 #include "functorize.hpp"
+#include "fuse_reductions.hpp"
 #include "type_convert.hpp"
 #include "allocate.hpp"
 #include "wrap.hpp"
@@ -31,13 +32,24 @@
 #include "cpp_printer.hpp"
 #include "typedefify.hpp"
 #include "phase_analyze.hpp"
+#include "fuse.hpp"
 #include "find_includes.hpp"
 #include "tuple_break.hpp"
 #include "dereference.hpp"
 #include "containerize.hpp"
+#include "recycle.hpp"
+#include "plan_memory.hpp"
+#include "schedule.hpp"
 #include "prune.hpp"
 #include "iterizer.hpp"
 #include "backend_translate.hpp"
+#include "segment.hpp"
+#include "pass_profile.hpp"
+#include "compile_cache.hpp"
+#include "hash_cons.hpp"
+#include "arena.hpp"
+#include "thread_pool.hpp"
+#include "procedure_cache.hpp"
 
 #include "prelude/runtime/tags.h"
 
@@ -91,6 +103,35 @@ private:
     /*! The registry used by the compiler.*/
     registry m_registry;
 
+    /*! Whether passes are profiled.*/
+    bool m_profiling;
+    /*! Pass profiles from the most recent compilation.*/
+    std::vector<pass_profile> m_profiles;
+
+    /*! Whether the AST is hash-consed between passes.*/
+    bool m_hash_consing;
+    /*! Whether nodes are allocated from a per-compilation arena.*/
+    bool m_arena;
+    /*! The threads running procedure local passes, or null if
+      passes run serially.*/
+    std::shared_ptr<thread_pool> m_pool;
+    /*! Whether lowered procedures are reused across compilations.*/
+    bool m_incremental;
+    /*! Lowered procedures from previous compilations.*/
+    procedure_cache m_procedures;
+    /*! Whether the entry point plans its memory up front.*/
+    bool m_memory_plan;
+    /*! Whether the entry point runs independent primitives
+      concurrently.*/
+    bool m_task_graph;
+    /*! Whether an asynchronous wrapper is added for the entry point.*/
+    bool m_async;
+    /*! Whether a batched wrapper is added for the entry point.*/
+    bool m_batch;
+
+    /*! The cache of generated code, or null if caching is disabled.*/
+    std::shared_ptr<compile_cache> m_cache;
+
 public:
     //! Constructor.
     /*!\param entry_point The name of the entry point function.
@@ -107,11 +148,140 @@ public:
        compiled.
     */
     std::shared_ptr<const suite> operator()(const suite &n);
+    //! Compiles a \ref backend::suite suite node to C++ source
+    /*! If a \ref backend::compile_cache "compile_cache" is in use,
+      the cache is consulted first, keyed on the structure of \p n,
+      the entry point and the target.  On a hit, the compiler passes
+      are skipped entirely.  On a miss, the generated code is stored
+      in the cache.
+      \param n The suite node containing the entire program to be
+      compiled.
+    */
+    std::string code(const suite &n);
     //! Gets the name of the entry point function
     const std::string& entry_point() const;
     //! Gets the \ref backend::registry "registry" used by the compiler
     const registry& reg() const;
     const copperhead::system_variant& target() const;
+    //! Enables or disables profiling of compiler passes
+    /*! When enabled, each call to \p operator() records the time
+      spent in each pass, and how many AST nodes each pass allocated
+      or shared with its input.  Profiling is enabled by default if
+      the environment variable COPPERHEAD_PROFILE_PASSES is set, in
+      which case profiles are also printed to std::cerr.
+    */
+    void set_profiling(bool p);
+    //! Gets the pass profiles from the most recent compilation
+    const std::vector<pass_profile>& profiles() const;
+    //! Enables or disables hash-consing of the AST between passes
+    /*! When enabled, the input and the output of every pass are
+      interned in a \ref backend::hash_cons "hash_cons" table which
+      lives for the duration of a compilation.  Structurally equal
+      subtrees, whether produced by the same pass or by different
+      passes, are then shared.  Hash-consing is enabled by default if
+      the environment variable COPPERHEAD_HASH_CONS is set.
+    */
+    void set_hash_consing(bool h);
+    //! Enables or disables arena allocation of the AST
+    /*! When enabled, each call to \p operator() creates an
+      \ref backend::ast_arena "ast_arena", and every node and type
+      built by the compiler passes is allocated from it.  The arena is
+      released all at once when the last of those nodes dies,
+      typically when the caller drops the compiled \p suite.  Arena
+      allocation is skipped while incremental recompilation is
+      enabled, since remembered procedures would keep their arenas
+      alive.  Arena allocation is enabled by default if the
+      environment variable COPPERHEAD_AST_ARENA is set.
+    */
+    void set_arena(bool a);
+    //! Enables or disables running passes on procedures in parallel
+    /*! When enabled, passes which rewrite each procedure
+      independently are run on all the procedures of the suite
+      concurrently, using a pool of \p threads threads, or one per
+      hardware thread if \p threads is zero.  Passes which gather
+      information across procedures still run serially.  Each
+      procedure is rewritten by its own copy of a pass.  These passes
+      keep no state from one procedure to the next, so the generated
+      code is the same as a serial compilation's.  Parallel passes are enabled by default if the
+      environment variable COPPERHEAD_PARALLEL_PASSES is set; its
+      value, if a number, gives the number of threads.
+    */
+    void set_parallel(bool p, std::size_t threads = 0);
+    //! Enables or disables incremental recompilation
+    /*! When enabled, the compiler remembers what each procedure was
+      lowered to.  A later call to \p operator() only runs the passes
+      on procedures which changed, or whose callees changed, along
+      with their callees, and splices the remembered results in for
+      the rest.  Passes which finish the program as a whole, like
+      \ref backend::find_includes "find_includes" and
+      \ref backend::prune "prune", always run on the entire program.
+      Remembered procedures keep the nodes they were built from alive.
+      Disabling incremental recompilation forgets them.  Incremental
+      recompilation is enabled by default if the environment variable
+      COPPERHEAD_INCREMENTAL is set.
+    */
+    void set_incremental(bool i);
+    //! Gets the lowered procedures remembered for reuse
+    const procedure_cache& procedures() const;
+    //! Enables or disables planning the memory of each invocation
+    /*! When enabled, the entry point computes the sizes of the
+      cuarrays it will allocate from the lengths of its arguments,
+      and makes a single allocation for all of them when it is
+      called, so what an invocation needs is known before it does
+      any work.  See \ref backend::plan_memory "plan_memory".
+      Entry points whose allocations can't be sized are compiled as
+      usual.  Memory planning is enabled by default if the environment
+      variable COPPERHEAD_MEMORY_PLAN is set.
+    */
+    void set_memory_plan(bool m);
+    //! Enables or disables running independent primitives concurrently
+    /*! When enabled, the entry point spawns its primitives onto the
+      runtime's worker threads and waits for each result only when it
+      is needed, so primitives which don't depend on each other run at
+      the same time.  See \ref backend::schedule "schedule".  The
+      number of worker threads is set by the environment variable
+      COPPERHEAD_TASK_THREADS when the program runs, and defaults to
+      one per hardware thread.  Concurrent primitives are enabled by
+      default if the environment variable COPPERHEAD_TASK_GRAPH is set
+      when compiling.
+    */
+    void set_task_graph(bool t);
+    //! Enables or disables the asynchronous entry point
+    /*! When enabled, the program also provides an asynchronous
+      wrapper for the entry point, named by prefixing the entry point
+      with "async".  It takes the same arguments, starts the entry
+      point on the runtime's worker threads, and returns a \p future
+      for its result without waiting for any work to finish.  Calling
+      \p get() on the future waits for the result, running other
+      queued work meanwhile, and rethrows anything the entry point
+      threw.  See \ref backend::wrap "wrap".  Entry points taking
+      more than nine arguments only get the blocking wrapper.  The
+      asynchronous entry point is enabled by default if the
+      environment variable COPPERHEAD_ASYNC is set.
+    */
+    void set_async(bool a);
+    //! Enables or disables the batched entry point
+    /*! When enabled, the program also provides a batched wrapper for
+      the entry point, named by prefixing the entry point with
+      "batch".  Each sequence argument is given as a nested
+      container, and the entry point runs once for each of its
+      segments, concurrently on the runtime's worker threads.  Scalar
+      arguments are shared by every run.  The results come back as one
+      container: flat if the entry point returns a scalar, nested if it
+      returns a sequence.  This amortizes the cost of a call over many
+      small inputs.  See \ref backend::wrap "wrap" for the entry
+      points which can be batched.  The batched entry point is enabled
+      by default if the environment variable COPPERHEAD_BATCH is set.
+    */
+    void set_batch(bool b);
+    //! Sets the cache consulted by \p code()
+    /*! Caching is enabled by default if the environment variable
+      COPPERHEAD_CACHE_DIR is set.  Passing a null pointer disables
+      caching.
+    */
+    void set_cache(const std::shared_ptr<compile_cache>& c);
+    //! Gets the cache consulted by \p code(), which may be null
+    const std::shared_ptr<compile_cache>& cache() const;
 };
 
 }
@@ -47,7 +47,7 @@ class containerize
 private:
     const std::string& m_entry_point;
     bool m_in_entry;
-    environment<std::string> m_decl_containers;
+    environment<symbol> m_decl_containers;
     std::shared_ptr<const expression> container_args(const expression&);
     result_type reassign(const bind& n);
 public:
@@ -37,7 +37,7 @@ class cpp_printer
 private:
     const copperhead::system_variant m_t;
     const std::string& entry;
-    environment<std::string> declared;
+    environment<symbol> declared;
     ctype::ctype_printer tp;
     bool m_in_rhs;
     bool m_in_struct;
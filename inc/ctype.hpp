@@ -20,6 +20,7 @@
 #include <boost/iterator/indirect_iterator.hpp>
 #include <memory>
 #include <iostream>
+#include "arena.hpp"
 
 namespace backend {
 
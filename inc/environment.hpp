@@ -17,8 +17,11 @@
 #pragma once
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <cassert>
+#include "symbol.hpp"
 
 namespace backend {
 
@@ -65,14 +68,34 @@ public:
     }
 };
 
+//Scopes are ordered containers, except for symbol keys, which hash
+//on their interned id
+template<typename key, typename value>
+struct environment_store {
+    typedef std::map<key, value> type;
+};
+
+template<typename key>
+struct environment_store<key, void> {
+    typedef std::set<key> type;
+};
+
+template<typename value>
+struct environment_store<symbol, value> {
+    typedef std::unordered_map<symbol, value> type;
+};
+
+template<>
+struct environment_store<symbol, void> {
+    typedef std::unordered_set<symbol> type;
+};
+
 }
 
 template<typename key, typename value=void>
 class environment
-    : public detail::environment_impl<key, value, std::map<key, value> > {};
-
-template<typename key>
-class environment<key, void>
-    : public detail::environment_impl<key, void, std::set<key> >{};
+    : public detail::environment_impl<
+    key, value,
+    typename detail::environment_store<key, value>::type> {};
 
 }
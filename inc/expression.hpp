@@ -25,6 +25,7 @@
 #include "type.hpp"
 #include "monotype.hpp"
 #include "ctype.hpp"
+#include "symbol.hpp"
 
 /*!
   \file   expression.hpp
@@ -123,7 +124,9 @@ public:
 //! AST node for identifiers.
 class name
     : public literal
-{   
+{
+protected:
+    const symbol m_sym;
 public:
 /*!   
   \param val The identifier text.
@@ -146,8 +149,10 @@ public:
     name(Derived& self, const std::string &val,
          const std::shared_ptr<const type_t>& type,
          const std::shared_ptr<const ctype::type_t>& ctype) :
-        literal(self, val, type, ctype) {}
-    
+        literal(self, val, type, ctype), m_sym(val) {}
+
+    //! Get the interned identifier of this name
+    const symbol& sym(void) const;
     /*! When we need to get at the pointer holding a name */
     std::shared_ptr<const name> ptr() const;
 
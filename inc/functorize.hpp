@@ -17,6 +17,7 @@
 #pragma once
 #include <string>
 #include <set>
+#include <unordered_map>
 #include <sstream>
 #include "rewriter.hpp"
 #include "utility/isinstance.hpp"
@@ -94,8 +95,8 @@ private:
     const std::string& m_entry_point;
     std::vector<result_type> m_additionals;
     const registry& m_reg;
-    std::map<std::string,
-             std::shared_ptr<const type_t> > m_fns;
+    std::unordered_map<symbol,
+                       std::shared_ptr<const type_t> > m_fns;
 
     std::shared_ptr<const expression> instantiate_fn(const name& n,
                                                      const type_t& t);
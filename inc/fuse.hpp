@@ -0,0 +1,67 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+#pragma once
+#include <unordered_map>
+#include <unordered_set>
+#include "node.hpp"
+#include "rewriter.hpp"
+#include "utility/snippets.hpp"
+
+namespace backend {
+
+/*!
+  \addtogroup rewriters
+  @{
+*/
+
+//! A rewrite pass which fuses producers into streaming consumers
+/*! \ref backend::phase_analyze "phase_analyze" materializes a
+ *  sequence with a phase boundary whenever a consumer's phase type
+ *  asks for a totally formed input.  Some of those consumers only
+ *  stream through their inputs with iterators, so a lazy sequence,
+ *  such as the result of a map, serves them just as well.
+ *
+ *  This pass removes a phase boundary when its result has exactly
+ *  one use, as an argument to a streaming primitive bound later in
+ *  the same suite, and the sequence it completes is bound only
+ *  once.  The consumer then reads the producer directly, which saves
+ *  an allocation and a round trip through memory.
+*/
+class fuse
+    : public rewriter<fuse>
+{
+private:
+    std::unordered_set<symbol> m_streaming;
+    std::unordered_map<symbol, int> m_uses;
+    std::unordered_map<symbol, int> m_binds;
+    std::unordered_map<symbol, std::shared_ptr<const name> > m_fused;
+    bool fusible(const bind& boundary,
+                 suite::const_iterator consumers,
+                 suite::const_iterator end);
+public:
+    fuse();
+    using rewriter<fuse>::operator();
+    result_type operator()(const procedure& n);
+    result_type operator()(const suite& n);
+    result_type operator()(const name& n);
+};
+
+/*!
+  @}
+*/
+
+}
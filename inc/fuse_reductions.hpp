@@ -0,0 +1,87 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "node.hpp"
+#include "rewriter.hpp"
+#include "utility/name_supply.hpp"
+#include "utility/snippets.hpp"
+
+namespace backend {
+
+/*!
+  \addtogroup rewriters
+  @{
+*/
+
+//! A rewrite pass which computes sibling reductions together
+/*! Programs often reduce several sequences of the same length, for
+ *  example
+ *  \code
+ *  s = reduce(op_add, x, 0)
+ *  m = reduce(op_max, x, 0)
+ *  q = reduce(op_add, map(op_mul, x, x), 0)
+ *  \endcode
+ *  Each reduction is a separate sweep over memory.  This pass gathers
+ *  up to four such reductions from a suite of the entry point into
+ *  a single reduction over their zipped inputs:
+ *  \code
+ *  reduction0 = reduce3(op_add, x, 0, op_max, x, 0, op_add, y, 0)
+ *  s = thrust::get<0>(reduction0)
+ *  m = thrust::get<1>(reduction0)
+ *  q = thrust::get<2>(reduction0)
+ *  \endcode
+ *  A \p sum joins as a reduction with \p op_add from zero.
+ *  Sequences are known to have the same length when they are the same
+ *  sequence, or are produced from the same sequence by maps.  The
+ *  fused reduction is placed at one of its members: a later reduction
+ *  joins either by moving up to it, if nothing it reads is bound in
+ *  between, or by the members moving down to the later reduction, if
+ *  nothing in between reads their results.
+ *
+ *  This pass runs after \ref backend::functorize "functorize", so the
+ *  reduction functions are already instantiated functor objects.
+*/
+class fuse_reductions
+    : public rewriter<fuse_reductions>
+{
+private:
+    const std::string& m_entry_point;
+    detail::name_supply m_supply;
+    std::unordered_map<symbol, symbol> m_sources;
+    symbol root(const symbol& s) const;
+    bool reduction(const statement& s) const;
+    result_type fused(
+        const std::vector<std::shared_ptr<const bind> >& reductions);
+public:
+    //! Constructor
+    /*! \param entry_point The name of the entry point procedure
+     */
+    fuse_reductions(const std::string& entry_point);
+    using rewriter<fuse_reductions>::operator();
+    result_type operator()(const procedure& n);
+    result_type operator()(const suite& n);
+};
+
+/*!
+  @}
+*/
+
+}
@@ -0,0 +1,123 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ */
+/*! \file hash_cons.hpp
+ *  \brief Sharing of structurally equal AST nodes and types.
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "node.hpp"
+#include "type.hpp"
+#include "ctype.hpp"
+
+namespace backend {
+
+namespace detail {
+
+//Identifies a node by its kind, its own fields, and the addresses of
+//its (already interned) children and types.
+struct cons_key {
+    int kind;
+    std::string text;
+    std::vector<const void*> parts;
+    std::size_t hash;
+    bool operator==(const cons_key& o) const;
+};
+
+struct cons_key_hash {
+    std::size_t operator()(const cons_key& k) const {
+        return k.hash;
+    }
+};
+
+}
+
+/*!
+  \addtogroup utilities
+  @{
+*/
+
+//! A hash-consing table for AST nodes and types
+/*! Interning a tree through a \p hash_cons returns a tree in
+  which structurally equal subtrees are the same object.  Interned
+  trees therefore compare structurally with pointer equality, and
+  their hashes are computed in time proportional to the arity of the
+  root rather than the size of the tree, since every child is
+  already unique.
+
+  Nodes are held weakly: an interned node lives only as long as some
+  tree refers to it.  Types and C++ implementation types are small
+  and few, so they are held for the lifetime of the table.
+*/
+class hash_cons {
+private:
+    typedef std::unordered_map<detail::cons_key,
+                               std::weak_ptr<const node>,
+                               detail::cons_key_hash> node_table;
+    node_table m_nodes;
+    std::size_t m_sweep_at;
+    std::unordered_map<std::string,
+                       std::shared_ptr<const type_t> > m_types;
+    std::unordered_map<std::string,
+                       std::shared_ptr<const ctype::type_t> > m_ctypes;
+    std::size_t m_hits;
+    std::size_t m_misses;
+
+    detail::cons_key key(const node& n);
+public:
+    hash_cons();
+
+    //! Interns an entire tree
+    /*! \param n The root of the tree.
+        \return A structurally equal tree, built from interned nodes.
+    */
+    std::shared_ptr<const node> operator()(const node& n);
+
+    //! Interns a single node whose children are already interned
+    std::shared_ptr<const node> intern(const std::shared_ptr<const node>& n);
+
+    //! Interns a type
+    std::shared_ptr<const type_t> intern(const std::shared_ptr<const type_t>& t);
+
+    //! Interns a C++ implementation type
+    std::shared_ptr<const ctype::type_t> intern(const std::shared_ptr<const ctype::type_t>& t);
+
+    //! Hashes a node whose children are already interned
+    std::size_t hash(const node& n);
+
+    //! Number of entries in the table
+    /*! This includes nodes which have died since the last sweep. */
+    std::size_t size() const;
+
+    //! Number of lookups which found an existing node
+    std::size_t hits() const;
+
+    //! Number of lookups which interned a new node
+    std::size_t misses() const;
+
+    //! Forgets nodes which are no longer alive
+    void sweep();
+};
+
+/*!
+  @}
+*/
+
+}
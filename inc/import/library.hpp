@@ -22,13 +22,27 @@
 #include <string>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <ostream>
 #include "builtins/phase.hpp"
 #include "type.hpp"
+#include "symbol.hpp"
 
 namespace backend {
 
-typedef std::tuple<const std::string, const iteration_structure> ident;
+typedef std::tuple<const symbol, const iteration_structure> ident;
+
+struct ident_hash {
+    std::size_t operator()(const ident& i) const {
+        return (std::size_t(std::get<0>(i).id()) << 2) ^
+            std::size_t(std::get<1>(i));
+    }
+};
+
+class fn_info;
+
+//! Functions known to a library or registry, hashed by interned name
+typedef std::unordered_map<ident, fn_info, ident_hash> fn_map;
 
 class fn_info {
     std::shared_ptr<const type_t> m_type;
@@ -55,7 +69,7 @@ public:
 
 struct library {
 private:
-    std::map<ident, fn_info> m_fns;
+    fn_map m_fns;
     std::map<std::string, std::string> m_fn_includes;
     std::set<std::string> m_includes;
     std::set<std::string> m_include_dirs;
@@ -63,7 +77,7 @@ private:
     std::set<std::string> m_link_dirs;
 
 public:
-    inline library(std::map<ident, fn_info> &&fns,
+    inline library(fn_map &&fns,
                    std::map<std::string, std::string> &&fn_includes=std::map<std::string, std::string>(),
                    std::set<std::string> &&includes=std::set<std::string>(),
                    std::set<std::string> &&include_dirs=std::set<std::string>(),
@@ -77,7 +91,7 @@ public:
           m_links(std::move(links)),
           m_link_dirs(std::move(link_dirs))
         {}
-    const std::map<ident, fn_info>& fns() const {
+    const fn_map& fns() const {
         return m_fns;
     }
     const std::map<std::string, std::string>& fn_includes() const {
@@ -100,7 +114,7 @@ public:
 
 struct registry {
 private:
-    std::map<ident, fn_info> m_fns;
+    fn_map m_fns;
     std::map<std::string, std::string> m_fn_includes;
     std::set<std::string> m_includes;
     std::set<std::string> m_include_dirs;
@@ -116,12 +130,12 @@ public:
         m_links.insert(links.begin(), links.end());
         const std::set<std::string>& link_dirs = l->link_dirs();
         m_link_dirs.insert(link_dirs.begin(), link_dirs.end());
-        const std::map<ident, fn_info>& fns = l->fns();
+        const fn_map& fns = l->fns();
         m_fns.insert(fns.begin(), fns.end());
         const std::map<std::string, std::string>& fn_includes = l->fn_includes();
         m_fn_includes.insert(fn_includes.begin(), fn_includes.end());
     }
-    const std::map<ident, fn_info>& fns() const {
+    const fn_map& fns() const {
         return m_fns;
     }
     const std::map<std::string, std::string>& fn_includes() const {
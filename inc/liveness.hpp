@@ -0,0 +1,121 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+/*! \file liveness.hpp
+ *  \brief Liveness of identifiers in a suite.
+ */
+
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "node.hpp"
+#include "rewriter.hpp"
+
+namespace backend {
+
+namespace detail {
+//Finds the identifiers a statement binds and the ones it reads
+class binding_finder
+    : public rewriter<binding_finder> {
+private:
+    std::unordered_set<symbol> m_bound;
+    std::unordered_set<symbol> m_read;
+    void bound(const expression& lhs);
+public:
+    using rewriter<binding_finder>::operator();
+
+    result_type operator()(const procedure& n);
+
+    result_type operator()(const bind& n);
+
+    result_type operator()(const name& n);
+
+    const std::unordered_set<symbol>& bound() const;
+
+    const std::unordered_set<symbol>& read() const;
+};
+}
+
+/*!
+  \addtogroup utilities
+  @{
+*/
+
+//! Computes when identifiers bound in a suite are last needed
+/*! The analysis considers the statements of one suite, typically the
+  body of the entry point, in order.  A statement nested in it, such
+  as a loop, counts as a single statement which binds and reads
+  everything its body does.
+
+  Identifiers which refer to C++ views, such as sequences built over
+  a cuarray or lazily transformed sequences, keep pointers into the
+  storage they were built from.  Such an identifier is said to hold
+  the identifiers its definition reads, and storage is live for as
+  long as anything holding it is.  Scalars hold nothing, and neither
+  does a cuarray newly returned by a function, which owns its
+  storage.
+*/
+class liveness {
+private:
+    std::vector<detail::binding_finder> m_stmts;
+    std::unordered_map<symbol, std::vector<symbol> > m_holders;
+    std::unordered_map<symbol, int> m_definitions;
+    std::unordered_map<symbol, int> m_binds;
+    std::unordered_set<symbol> m_fresh;
+    mutable std::unordered_map<symbol, int> m_last_uses;
+    int last_use(const symbol& s,
+                 std::unordered_set<symbol>& visiting) const;
+public:
+    //! Analyzes a suite
+    liveness(const suite& n);
+
+    //! Number of statements in the suite
+    std::size_t size() const;
+
+    //! Identifiers bound by statement \p i
+    const std::unordered_set<symbol>& bound(std::size_t i) const;
+
+    //! Identifiers read by statement \p i
+    const std::unordered_set<symbol>& read(std::size_t i) const;
+
+    //! Index of the last statement reading \p s or anything which holds it
+    /*! \return -1 if nothing reads \p s.
+     */
+    int last_use(const symbol& s) const;
+
+    //! Whether \p h holds \p s, directly or through other identifiers
+    bool holds(const symbol& h, const symbol& s) const;
+
+    //! Index of the statement of the suite which binds \p s
+    /*! \return -1 if \p s is not bound by a statement of the suite,
+      or is bound by more than one of them.
+     */
+    int definition(const symbol& s) const;
+
+    //! Whether \p s names a cuarray which nothing else refers to
+    /*! Such a cuarray is bound once, directly in the suite, to the
+      result of a function which allocates it, so once \p s is dead
+      its storage may be reused.
+    */
+    bool fresh(const symbol& s) const;
+};
+
+/*!
+  @}
+*/
+
+}
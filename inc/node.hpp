@@ -23,6 +23,7 @@
 #include <boost/iterator/indirect_iterator.hpp>
 #include <iostream>
 #include "utility/inspect.hpp"
+#include "arena.hpp"
 
 
 namespace backend
@@ -0,0 +1,81 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+/*! \file pass_profile.hpp
+ *  \brief Instrumentation for compiler passes.
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <iostream>
+#include <chrono>
+#include <unordered_set>
+#include "node.hpp"
+
+namespace backend {
+
+/*!
+  \addtogroup utilities
+  @{
+*/
+
+//! Measurements of one compiler pass
+struct pass_profile {
+    //! Name of the pass
+    std::string name;
+    //! Wall clock time spent in the pass, in seconds
+    double seconds;
+    //! Number of distinct AST nodes in the input to the pass
+    size_t nodes_in;
+    //! Number of distinct AST nodes in the output of the pass
+    size_t nodes_out;
+    //! Number of output nodes which were newly allocated by the pass
+    size_t allocated;
+    //! Number of output nodes shared with the input of the pass
+    size_t shared;
+};
+
+//! Records a \ref pass_profile for each pass of a compilation
+class pass_profiler {
+private:
+    std::vector<pass_profile> m_profiles;
+    std::unordered_set<const node*> m_input;
+    std::chrono::high_resolution_clock::time_point m_start;
+public:
+    //! Called before a pass runs
+    /*! \param name The name of the pass.
+        \param n The input to the pass.
+    */
+    void start(const std::string& name, const node& n);
+    //! Called after a pass runs
+    /*! \param n The output of the pass.
+     */
+    void finish(const node& n);
+    //! Gets the profiles recorded so far
+    const std::vector<pass_profile>& profiles() const;
+};
+
+//! Prints profiles as tab separated values, one pass per line
+/*! The first line is a header naming the columns.
+ */
+void print_profiles(std::ostream& o, const std::vector<pass_profile>& p);
+
+/*!
+  @}
+*/
+
+}
@@ -17,6 +17,8 @@
 #pragma once
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "node.hpp"
 #include "rewriter.hpp"
@@ -48,17 +50,17 @@ class phase_analyze
 private:
     const std::string m_entry_point;
     bool m_in_entry;
-    std::map<std::string, std::shared_ptr<const phase_t> > m_fns;
-    environment<std::string, completion> m_completions;
-    environment<std::string, std::shared_ptr<const name> > m_substitutions;
+    std::unordered_map<symbol, std::shared_ptr<const phase_t> > m_fns;
+    environment<symbol, completion> m_completions;
+    environment<symbol, std::shared_ptr<const name> > m_substitutions;
     std::vector<std::shared_ptr<const statement> > m_pre_boundaries;
     std::shared_ptr<const statement> m_post_boundary;
-    std::set<std::string> m_returns;
+    std::unordered_set<symbol> m_returns;
     completion m_result_completion;
     bool add_phase_boundary(const name& n, bool post=false);
     bool add_phase_boundary_tuple(const name& n, bool post=false);
     result_type make_tuple_analyze(const bind& n);
-    environment<std::string,
+    environment<symbol,
                 std::vector<std::shared_ptr<const literal> > > m_tuples;
     result_type form_suite(const std::shared_ptr<const statement>&);
 public:
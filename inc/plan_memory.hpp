@@ -0,0 +1,86 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+#pragma once
+#include <string>
+#include <unordered_map>
+#include "node.hpp"
+#include "rewriter.hpp"
+#include "liveness.hpp"
+#include "prelude/runtime/tags.h"
+
+namespace backend {
+
+/*!
+  \addtogroup rewriters
+  @{
+*/
+
+//! A rewrite pass which plans the memory of each invocation
+/*! Derives the size of every cuarray the entry point allocates from
+ *  the lengths of its arguments, and has the entry point reserve a
+ *  single \p frame for all of them before it does any work:
+ *  \code
+ *  frame0 = make_frame()
+ *  reserve<float>(frame0, ary_x)
+ *  reserve<int>(frame0, ary_x)
+ *  begin_frame(frame0, cuda_tag())
+ *  ...
+ *  \endcode
+ *  While the frame is current, the runtime carves cuarrays out of it
+ *  in order instead of going to the memory pool for each of them.
+ *  Results of the entry point are allocated with the frame paused,
+ *  so they don't keep it alive after the call.
+ *
+ *  A cuarray's size is known when it is produced by a primitive whose
+ *  result is as long as one of its inputs, or no longer, such as a
+ *  map, scan, sort, scatter or filter, of a sequence whose own size
+ *  is known, down to an argument.  If the size of any allocation is
+ *  unknown, or the entry point contains loops or conditionals, the
+ *  entry point is left unchanged.
+ *
+ *  This pass runs after \ref backend::recycle "recycle".
+*/
+class plan_memory
+    : public rewriter<plan_memory>
+{
+private:
+    const copperhead::system_variant& m_target;
+    const std::string& m_entry_point;
+    bool m_enabled;
+    std::unordered_map<symbol, std::shared_ptr<const name> > m_args;
+    std::shared_ptr<const name> length_source(const liveness& l,
+                                              const suite& n,
+                                              const symbol& s) const;
+public:
+    //! Constructor
+    /*! \param target The backend system tag
+        \param entry_point The name of the entry point procedure
+        \param enabled Whether to plan memory, otherwise the pass
+        does nothing
+     */
+    plan_memory(const copperhead::system_variant& target,
+                const std::string& entry_point,
+                bool enabled);
+    using rewriter<plan_memory>::operator();
+    result_type operator()(const procedure& n);
+};
+
+/*!
+  @}
+*/
+
+}
@@ -32,12 +32,12 @@ struct closure {
         : m_f(f),
           m_t(t) {}
 
-    __host__ __device__ result_type operator()() {
+    __host__ __device__ result_type operator()() const {
         return detail::apply_from_tuple(m_f, m_t);
     }
     
     template<typename T0>
-    __host__ __device__ result_type operator()(const T0& t0) {
+    __host__ __device__ result_type operator()(const T0& t0) const {
         return detail::apply_from_tuple(m_f,
                                         thrust::tuple_cat(
                                             thrust::make_tuple(t0),
@@ -45,7 +45,7 @@ struct closure {
     }
     template<typename T0, typename T1>
     __host__ __device__ result_type operator()(const T0& t0,
-                                               const T1& t1) {
+                                               const T1& t1) const {
         return detail::apply_from_tuple(m_f,
                                         thrust::tuple_cat(
                                             thrust::make_tuple(t0, t1),
@@ -55,7 +55,7 @@ struct closure {
     template<typename T0, typename T1, typename T2>
     __host__ __device__ result_type operator()(const T0& t0,
                                                const T1& t1,
-                                               const T2& t2) {
+                                               const T2& t2) const {
         return detail::apply_from_tuple(m_f,
                                         thrust::tuple_cat(
                                             thrust::make_tuple(t0, t1, t2),
@@ -66,7 +66,7 @@ struct closure {
     __host__ __device__ result_type operator()(const T0& t0,
                                                const T1& t1,
                                                const T2& t2,
-                                               const T3& t3) {
+                                               const T3& t3) const {
         return detail::apply_from_tuple(m_f,
                                         thrust::tuple_cat(
                                             thrust::make_tuple(t0, t1, t2, t3),
@@ -78,7 +78,7 @@ struct closure {
                                                const T1& t1,
                                                const T2& t2,
                                                const T3& t3,
-                                               const T4& t4) {
+                                               const T4& t4) const {
         return detail::apply_from_tuple(m_f,
                                         thrust::tuple_cat(
                                             thrust::make_tuple(t0, t1, t2, t3, t4),
@@ -92,7 +92,7 @@ struct closure {
                                                const T2& t2,
                                                const T3& t3,
                                                const T4& t4,
-                                               const T5& t5) {
+                                               const T5& t5) const {
         return detail::apply_from_tuple(m_f,
                                         thrust::tuple_cat(
                                             thrust::make_tuple(
@@ -109,7 +109,7 @@ struct closure {
                                                const T3& t3,
                                                const T4& t4,
                                                const T5& t5,
-                                               const T6& t6) {
+                                               const T6& t6) const {
         return detail::apply_from_tuple(m_f,
                                         thrust::tuple_cat(
                                             thrust::make_tuple(
@@ -127,7 +127,7 @@ struct closure {
                                                const T4& t4,
                                                const T5& t5,
                                                const T6& t6,
-                                               const T7& t7) {
+                                               const T7& t7) const {
         return detail::apply_from_tuple(m_f,
                                         thrust::tuple_cat(
                                             thrust::make_tuple(
@@ -146,7 +146,7 @@ struct closure {
                                                const T5& t5,
                                                const T6& t6,
                                                const T7& t7,
-                                               const T8& t8) {
+                                               const T8& t8) const {
         return detail::apply_from_tuple(m_f,
                                         thrust::tuple_cat(
                                             thrust::make_tuple(
@@ -166,7 +166,7 @@ struct closure {
                                                const T6& t6,
                                                const T7& t7,
                                                const T8& t8,
-                                               const T9& t9) {
+                                               const T9& t9) const {
         return detail::apply_from_tuple(m_f,
                                         thrust::tuple_cat(
                                             thrust::make_tuple(
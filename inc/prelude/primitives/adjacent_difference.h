@@ -18,7 +18,9 @@
 #include <prelude/runtime/make_cuarray.hpp>
 #include <prelude/runtime/make_sequence.hpp>
 #include <thrust/adjacent_difference.h>
+#include <thrust/functional.h>
 #include <prelude/runtime/tags.h>
+#include <prelude/runtime/task.hpp>
 
 namespace copperhead {
 
@@ -40,4 +42,15 @@ adjacent_difference(const F& fn, Seq& x) {
     return result_ary;
 }
 
+//The compiler declares adjacent_difference(x), the difference of
+//each element of x and the one before it
+template<typename Seq>
+boost::shared_ptr<cuarray>
+adjacent_difference(Seq& x) {
+    typedef typename Seq::value_type T;
+    return adjacent_difference(thrust::minus<T>(), x);
+}
+
+COPPERHEAD_TASK(adjacent_difference)
+
 }
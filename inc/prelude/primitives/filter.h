@@ -18,23 +18,33 @@
 
 #include <thrust/copy.h>
 #include <thrust/reduce.h>
+#include <thrust/transform_reduce.h>
+#include <thrust/functional.h>
 #include <prelude/runtime/make_cuarray.hpp>
 #include <prelude/runtime/make_sequence.hpp>
 #include <prelude/runtime/tags.h>
 #include <thrust/iterator/retag.h>
 #include <prelude/primitives/stored_sequence.h>
 #include <prelude/primitives/map.h>
+#include <prelude/runtime/task.hpp>
 
 #include <iostream>
 
+//Inputs with at least this many elements are filtered by counting
+//the result size first, which evaluates the predicate twice but
+//allocates only as much memory as the result needs.
+#ifndef COPPERHEAD_FILTER_COUNT_THRESHOLD
+#define COPPERHEAD_FILTER_COUNT_THRESHOLD (1 << 20)
+#endif
+
 namespace copperhead {
 
 namespace detail {
 
 struct counter {
-    typedef int result_type;
+    typedef size_t result_type;
     __host__ __device__
-    int operator()(const bool& x) const {
+    size_t operator()(const bool& x) const {
         if (x) {
             return 1;
         } else {
@@ -43,11 +53,10 @@ struct counter {
     }
 };
 
-}
-
+//Compacts into a cuarray as long as the input, then truncates it.
 template<typename F, typename Seq>
 sp_cuarray
-filter(const F& fn, Seq& x) {
+filter_compact(const F& fn, Seq& x) {
     typedef typename Seq::value_type T;
     typedef typename Seq::tag Tag;
     typedef typename detail::stored_sequence<Tag, T>::type sequence_type;
@@ -64,15 +73,54 @@ filter(const F& fn, Seq& x) {
                                     result.begin(),
                                     fn);
 
-    //XXX Decide if we want to keep this extraneous copy or add a shrink method to cuarray.
-    boost::shared_ptr<cuarray> compacted_ary = make_cuarray<T>(result_end - result.begin());
-    sequence_type compacted =
-        make_sequence<sequence_type>(compacted_ary,
+    //Truncate the result in place rather than copying it
+    result_ary->shrink(result_end - result.begin());
+    
+    return result_ary;
+}
+
+//Counts the elements which satisfy fn, then compacts into a
+//cuarray of exactly that size.
+template<typename F, typename Seq>
+sp_cuarray
+filter_count(const F& fn, Seq& x) {
+    typedef typename Seq::value_type T;
+    typedef typename Seq::tag Tag;
+    typedef typename detail::stored_sequence<Tag, T>::type sequence_type;
+
+    transformed_sequence<F, thrust::tuple<Seq> > flags = map1(fn, x);
+    size_t count = thrust::transform_reduce(flags.begin(),
+                                            flags.end(),
+                                            counter(),
+                                            size_t(0),
+                                            thrust::plus<size_t>());
+    
+    boost::shared_ptr<cuarray> result_ary = make_cuarray<T>(count);
+    sequence_type result =
+        make_sequence<sequence_type>(result_ary,
                                      Tag(),
                                      true);
-    thrust::copy(result.begin(), result_end, compacted.begin());
+   
+    thrust::copy_if(x.begin(),
+                    x.end(),
+                    result.begin(),
+                    fn);
     
-    return compacted_ary;
+    return result_ary;
 }
 
 }
+
+template<typename F, typename Seq>
+sp_cuarray
+filter(const F& fn, Seq& x) {
+    if (x.size() >= COPPERHEAD_FILTER_COUNT_THRESHOLD) {
+        return detail::filter_count(fn, x);
+    } else {
+        return detail::filter_compact(fn, x);
+    }
+}
+
+COPPERHEAD_TASK(filter)
+
+}
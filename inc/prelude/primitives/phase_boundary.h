@@ -22,6 +22,7 @@
 #include <thrust/tuple.h>
 
 #include <prelude/primitives/stored_sequence.h>
+#include <prelude/runtime/task.hpp>
 
 namespace copperhead {
 
@@ -157,4 +158,6 @@ typename Seq5, typename Seq6, typename Seq7, typename Seq8, typename Seq9>
     
 }
 
+COPPERHEAD_TASK(phase_boundary)
+
 }
@@ -17,6 +17,9 @@
 #pragma once
 
 #include <thrust/reduce.h>
+#include <thrust/tuple.h>
+#include <prelude/sequences/zipped_sequence.h>
+#include <prelude/runtime/task.hpp>
 
 namespace copperhead {
 
@@ -29,4 +32,147 @@ reduce(const F& fn, Seq& x, const typename F::result_type& p) {
                           fn);
 }
 
+namespace detail {
+
+//Combines the reduction functions of several sibling reductions
+//elementwise, so they can share one sweep over their inputs.
+//The functions are mutable, since the functors of the prelude and
+//of generated code are not callable through const references.
+
+template<typename F0,
+         typename F1>
+struct reduce_fn2 {
+    typedef thrust::tuple<typename F0::result_type,
+                          typename F1::result_type> result_type;
+    mutable F0 m_f0;
+    mutable F1 m_f1;
+    __host__ __device__
+    reduce_fn2(const F0& f0,
+               const F1& f1)
+        : m_f0(f0), m_f1(f1) {}
+    __host__ __device__
+    result_type operator()(const result_type& l, const result_type& r) const {
+        return result_type(
+            m_f0(thrust::get<0>(l), thrust::get<0>(r)),
+            m_f1(thrust::get<1>(l), thrust::get<1>(r)));
+    }
+};
+
+template<typename F0,
+         typename F1,
+         typename F2>
+struct reduce_fn3 {
+    typedef thrust::tuple<typename F0::result_type,
+                          typename F1::result_type,
+                          typename F2::result_type> result_type;
+    mutable F0 m_f0;
+    mutable F1 m_f1;
+    mutable F2 m_f2;
+    __host__ __device__
+    reduce_fn3(const F0& f0,
+               const F1& f1,
+               const F2& f2)
+        : m_f0(f0), m_f1(f1), m_f2(f2) {}
+    __host__ __device__
+    result_type operator()(const result_type& l, const result_type& r) const {
+        return result_type(
+            m_f0(thrust::get<0>(l), thrust::get<0>(r)),
+            m_f1(thrust::get<1>(l), thrust::get<1>(r)),
+            m_f2(thrust::get<2>(l), thrust::get<2>(r)));
+    }
+};
+
+template<typename F0,
+         typename F1,
+         typename F2,
+         typename F3>
+struct reduce_fn4 {
+    typedef thrust::tuple<typename F0::result_type,
+                          typename F1::result_type,
+                          typename F2::result_type,
+                          typename F3::result_type> result_type;
+    mutable F0 m_f0;
+    mutable F1 m_f1;
+    mutable F2 m_f2;
+    mutable F3 m_f3;
+    __host__ __device__
+    reduce_fn4(const F0& f0,
+               const F1& f1,
+               const F2& f2,
+               const F3& f3)
+        : m_f0(f0), m_f1(f1), m_f2(f2), m_f3(f3) {}
+    __host__ __device__
+    result_type operator()(const result_type& l, const result_type& r) const {
+        return result_type(
+            m_f0(thrust::get<0>(l), thrust::get<0>(r)),
+            m_f1(thrust::get<1>(l), thrust::get<1>(r)),
+            m_f2(thrust::get<2>(l), thrust::get<2>(r)),
+            m_f3(thrust::get<3>(l), thrust::get<3>(r)));
+    }
+};
+
+}
+
+//reduce2, reduce3 and reduce4 compute several reductions over
+//sequences of the same length in one pass, returning a tuple of
+//their results.  The compiler fuses sibling reductions into them.
+
+template<typename F0, typename Seq0,
+         typename F1, typename Seq1>
+thrust::tuple<typename F0::result_type,
+              typename F1::result_type>
+reduce2(const F0& fn0, Seq0& x0, const typename F0::result_type& p0,
+        const F1& fn1, Seq1& x1, const typename F1::result_type& p1) {
+    zipped_sequence<thrust::tuple<Seq0, Seq1> > x(
+        thrust::make_tuple(x0, x1));
+    return thrust::reduce(x.begin(),
+                          x.end(),
+                          thrust::make_tuple(p0, p1),
+                          detail::reduce_fn2<F0, F1>(
+                              fn0, fn1));
+}
+
+template<typename F0, typename Seq0,
+         typename F1, typename Seq1,
+         typename F2, typename Seq2>
+thrust::tuple<typename F0::result_type,
+              typename F1::result_type,
+              typename F2::result_type>
+reduce3(const F0& fn0, Seq0& x0, const typename F0::result_type& p0,
+        const F1& fn1, Seq1& x1, const typename F1::result_type& p1,
+        const F2& fn2, Seq2& x2, const typename F2::result_type& p2) {
+    zipped_sequence<thrust::tuple<Seq0, Seq1, Seq2> > x(
+        thrust::make_tuple(x0, x1, x2));
+    return thrust::reduce(x.begin(),
+                          x.end(),
+                          thrust::make_tuple(p0, p1, p2),
+                          detail::reduce_fn3<F0, F1, F2>(
+                              fn0, fn1, fn2));
+}
+
+template<typename F0, typename Seq0,
+         typename F1, typename Seq1,
+         typename F2, typename Seq2,
+         typename F3, typename Seq3>
+thrust::tuple<typename F0::result_type,
+              typename F1::result_type,
+              typename F2::result_type,
+              typename F3::result_type>
+reduce4(const F0& fn0, Seq0& x0, const typename F0::result_type& p0,
+        const F1& fn1, Seq1& x1, const typename F1::result_type& p1,
+        const F2& fn2, Seq2& x2, const typename F2::result_type& p2,
+        const F3& fn3, Seq3& x3, const typename F3::result_type& p3) {
+    zipped_sequence<thrust::tuple<Seq0, Seq1, Seq2, Seq3> > x(
+        thrust::make_tuple(x0, x1, x2, x3));
+    return thrust::reduce(x.begin(),
+                          x.end(),
+                          thrust::make_tuple(p0, p1, p2, p3),
+                          detail::reduce_fn4<F0, F1, F2, F3>(
+                              fn0, fn1, fn2, fn3));
+}
+
+COPPERHEAD_TASK(reduce)
+COPPERHEAD_TASK(sum)
+COPPERHEAD_TASK(reduce2)
+
 }
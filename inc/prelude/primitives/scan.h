@@ -24,6 +24,7 @@
 #include <prelude/runtime/tags.h>
 #include <thrust/iterator/retag.h>
 #include <prelude/primitives/stored_sequence.h>
+#include <prelude/runtime/task.hpp>
 
 namespace copperhead {
 
@@ -104,4 +105,45 @@ exclusive_rscan(const F& fn, const typename Seq::value_type& p, Seq& x) {
     return result_ary;
 }
 
+namespace detail {
+
+template<typename F, typename Seq>
+sp_cuarray
+scan_in_place(const F& fn, Seq& x, sp_cuarray& x_ary,
+              thrust::detail::true_type) {
+    thrust::inclusive_scan(x.begin(),
+                           x.end(),
+                           x.begin(),
+                           fn);
+    return x_ary;
+}
+
+//A scan which changes the element type can't reuse its input
+template<typename F, typename Seq>
+sp_cuarray
+scan_in_place(const F& fn, Seq& x, sp_cuarray& x_ary,
+              thrust::detail::false_type) {
+    return scan(fn, x);
+}
+
+}
+
+//Scans x, which must view all of x_ary, in its own storage, and
+//returns x_ary.  The compiler uses this when nothing reads x
+//afterwards.
+template<typename F, typename Seq>
+sp_cuarray
+scan_in_place(const F& fn, Seq& x, sp_cuarray& x_ary) {
+    return detail::scan_in_place(
+        fn, x, x_ary,
+        typename thrust::detail::is_same<
+            typename F::result_type,
+            typename Seq::value_type>::type());
+}
+
+COPPERHEAD_TASK(scan)
+COPPERHEAD_TASK(rscan)
+COPPERHEAD_TASK(exclusive_scan)
+COPPERHEAD_TASK(exclusive_rscan)
+
 }
@@ -23,6 +23,7 @@
 #include <thrust/iterator/retag.h>
 #include <prelude/primitives/stored_sequence.h>
 #include <thrust/iterator/permutation_iterator.h>
+#include <prelude/runtime/task.hpp>
 
 namespace copperhead {
 
@@ -73,4 +74,23 @@ scatter(const SeqX& x, const SeqI& i, const SeqD& d) {
 }
 
 
+//Scatters x into d, which must view all of d_ary, in d's own
+//storage, and returns d_ary.  The compiler uses this when nothing
+//reads d afterwards, saving the copy of d above.
+template<typename SeqX, typename SeqI, typename SeqD>
+sp_cuarray
+scatter_in_place(const SeqX& x, const SeqI& i, SeqD& d, sp_cuarray& d_ary) {
+    typedef typename SeqD::iterator_type ElementIterator;
+    typedef typename SeqI::iterator_type IndexIterator;
+    thrust::permutation_iterator<ElementIterator,
+                                 IndexIterator> pi(
+                                     d.begin(),
+                                     i.begin());
+    thrust::copy(x.begin(), x.end(), pi);
+    return d_ary;
+}
+
+COPPERHEAD_TASK(permute)
+COPPERHEAD_TASK(scatter)
+
 }
@@ -0,0 +1,303 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+#pragma once
+
+#include <thrust/scan.h>
+#include <thrust/reduce.h>
+#include <thrust/fill.h>
+#include <thrust/scatter.h>
+#include <thrust/transform.h>
+#include <thrust/for_each.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/reverse_iterator.h>
+#include <prelude/runtime/make_cuarray.hpp>
+#include <prelude/runtime/make_sequence.hpp>
+#include <prelude/runtime/tags.h>
+#include <prelude/primitives/stored_sequence.h>
+#include <prelude/runtime/task.hpp>
+
+//Segmented primitives map, scan or reduce every segment of a nested
+//sequence in one parallel pass.  The compiler uses them for maps
+//whose function maps, scans or reduces its argument, like
+//map(lambda xs: scan(f, xs), xss) or map(sum, xss).
+//Work is divided by element, not by segment, so a few very long
+//segments do not leave one thread with most of the work.
+
+namespace copperhead {
+
+namespace detail {
+
+//The segment of an element.  Keys are held in cuarrays, which hold
+//int64 but not size_t.
+typedef long segment_key;
+
+//Number of merge path steps each tile of merge_path_tile walks
+const size_t merge_path_tile_size = 256;
+
+//Writes the segment of every element of a nested sequence.
+//Finding the segments merges the ends of the segments with the
+//indices of the elements: a segment end is visited before every
+//element at or after it.  The merge path, with one step for every
+//segment and every element, is cut into tiles of equal length, so
+//each tile costs the same however the segment lengths are skewed.
+//A tile finds where it starts on the path by binary search of its
+//diagonal, then walks the path sequentially.  Elements are numbered
+//from the start of the first segment.
+struct merge_path_tile {
+    const size_t* m_d;
+    size_t m_n;
+    size_t m_l;
+    segment_key* m_keys;
+    __host__ __device__
+    merge_path_tile(const size_t* d, size_t n, size_t l, segment_key* keys)
+        : m_d(d), m_n(n), m_l(l), m_keys(keys) {}
+    //The end of segment i
+    __host__ __device__
+    size_t end(size_t i) const {
+        return m_d[i + 1] - m_d[0];
+    }
+    __host__ __device__
+    void operator()(const size_t& t) const {
+        size_t k = t * merge_path_tile_size;
+        //The number of segment ends before diagonal k
+        size_t lo = (k > m_l) ? k - m_l : 0;
+        size_t hi = (k < m_n) ? k : m_n;
+        while(lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (end(mid) <= k - mid - 1) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        size_t i = lo;
+        size_t j = k - lo;
+        size_t stop = k + merge_path_tile_size;
+        if (stop > m_n + m_l) {
+            stop = m_n + m_l;
+        }
+        for(; i + j < stop; ) {
+            if ((i < m_n) && ((j >= m_l) || (end(i) <= j))) {
+                i++;
+            } else {
+                m_keys[j] = i;
+                j++;
+            }
+        }
+    }
+};
+
+struct rebase {
+    typedef size_t result_type;
+    size_t m_b;
+    __host__ __device__
+    rebase(size_t b) : m_b(b) {}
+    __host__ __device__
+    size_t operator()(const size_t& x) const {
+        return x - m_b;
+    }
+};
+
+//Views of the elements of a nested sequence, from the start of its
+//first segment to the end of its last
+template<typename Tag, typename T>
+struct segment_data {
+    size_t m_b;
+    size_t m_l;
+    thrust::pointer<T, Tag> m_begin;
+    segment_data(const sequence<Tag, T, 1>& x) {
+        m_b = *thrust::pointer<size_t, Tag>(x.m_d.m_d);
+        m_l = *thrust::pointer<size_t, Tag>(x.m_d.m_d + x.size()) - m_b;
+        m_begin = thrust::pointer<T, Tag>(x.m_s.m_d + m_b);
+    }
+    thrust::pointer<T, Tag> begin() const {
+        return m_begin;
+    }
+    thrust::pointer<T, Tag> end() const {
+        return m_begin + m_l;
+    }
+};
+
+//Makes a nested cuarray shaped like x, and a view of it
+template<typename Tag, typename T, typename U>
+sp_cuarray make_segmented_like(const sequence<Tag, T, 1>& x,
+                               const segment_data<Tag, T>& data,
+                               sequence<Tag, U, 1>& result) {
+    sp_cuarray result_ary = make_nested_cuarray<U>(x.size(), data.m_l);
+    result = make_sequence<sequence<Tag, U, 1> >(result_ary, Tag(), true);
+    thrust::pointer<size_t, Tag> d(x.m_d.m_d);
+    thrust::transform(d, d + x.size() + 1,
+                      thrust::pointer<size_t, Tag>(result.m_d.m_d),
+                      rebase(data.m_b));
+    return result_ary;
+}
+
+//Keys which are equal exactly within each segment of x.  The
+//returned cuarray holds the keys.
+template<typename Tag, typename T>
+sp_cuarray segment_keys(const sequence<Tag, T, 1>& x,
+                        const segment_data<Tag, T>& data,
+                        thrust::pointer<segment_key, Tag>& keys) {
+    sp_cuarray keys_ary = make_cuarray<segment_key>(data.m_l);
+    keys = thrust::pointer<segment_key, Tag>(
+        make_sequence<sequence<Tag, segment_key, 0> >(keys_ary, Tag(),
+                                                      true).m_d);
+    size_t steps = x.size() + data.m_l;
+    size_t tiles = (steps + merge_path_tile_size - 1) / merge_path_tile_size;
+    thrust::for_each(thrust::counting_iterator<size_t, Tag>(0),
+                     thrust::counting_iterator<size_t, Tag>(tiles),
+                     merge_path_tile(x.m_d.m_d, x.size(), data.m_l,
+                                     keys.get()));
+    return keys_ary;
+}
+
+//Combines the prefix of a reduction with a segment's reduction
+template<typename F>
+struct prefix_with {
+    typedef typename F::result_type result_type;
+    F m_f;
+    result_type m_p;
+    __host__ __device__
+    prefix_with(const F& f, const result_type& p) : m_f(f), m_p(p) {}
+    __host__ __device__
+    result_type operator()(const result_type& x) {
+        return m_f(m_p, x);
+    }
+};
+
+}
+
+template<typename F, typename Tag, typename T>
+sp_cuarray
+segmented_map1(const F& fn, sequence<Tag, T, 1>& x) {
+    typedef typename F::result_type R;
+    detail::segment_data<Tag, T> data(x);
+    sequence<Tag, R, 1> result;
+    sp_cuarray result_ary = detail::make_segmented_like(x, data, result);
+    thrust::transform(data.begin(), data.end(),
+                      thrust::pointer<R, Tag>(result.m_s.m_d),
+                      fn);
+    return result_ary;
+}
+
+template<typename F, typename Tag, typename T>
+sp_cuarray
+segmented_scan(const F& fn, sequence<Tag, T, 1>& x) {
+    typedef typename F::result_type R;
+    detail::segment_data<Tag, T> data(x);
+    sequence<Tag, R, 1> result;
+    sp_cuarray result_ary = detail::make_segmented_like(x, data, result);
+    thrust::pointer<detail::segment_key, Tag> keys;
+    sp_cuarray keys_ary = detail::segment_keys(x, data, keys);
+    thrust::inclusive_scan_by_key(keys, keys + data.m_l,
+                                  data.begin(),
+                                  thrust::pointer<R, Tag>(result.m_s.m_d),
+                                  thrust::equal_to<detail::segment_key>(),
+                                  fn);
+    return result_ary;
+}
+
+template<typename F, typename Tag, typename T>
+sp_cuarray
+segmented_rscan(const F& fn, sequence<Tag, T, 1>& x) {
+    typedef typename F::result_type R;
+    detail::segment_data<Tag, T> data(x);
+    sequence<Tag, R, 1> result;
+    sp_cuarray result_ary = detail::make_segmented_like(x, data, result);
+    thrust::pointer<detail::segment_key, Tag> keys;
+    sp_cuarray keys_ary = detail::segment_keys(x, data, keys);
+    thrust::pointer<R, Tag> o(result.m_s.m_d);
+    thrust::inclusive_scan_by_key(
+        thrust::make_reverse_iterator(keys + data.m_l),
+        thrust::make_reverse_iterator(keys),
+        thrust::make_reverse_iterator(data.end()),
+        thrust::make_reverse_iterator(o + data.m_l),
+        thrust::equal_to<detail::segment_key>(),
+        fn);
+    return result_ary;
+}
+
+template<typename F, typename Tag, typename T>
+sp_cuarray
+segmented_exclusive_scan(const F& fn, const T& p, sequence<Tag, T, 1>& x) {
+    typedef typename F::result_type R;
+    detail::segment_data<Tag, T> data(x);
+    sequence<Tag, R, 1> result;
+    sp_cuarray result_ary = detail::make_segmented_like(x, data, result);
+    thrust::pointer<detail::segment_key, Tag> keys;
+    sp_cuarray keys_ary = detail::segment_keys(x, data, keys);
+    thrust::exclusive_scan_by_key(keys, keys + data.m_l,
+                                  data.begin(),
+                                  thrust::pointer<R, Tag>(result.m_s.m_d),
+                                  p,
+                                  thrust::equal_to<detail::segment_key>(),
+                                  fn);
+    return result_ary;
+}
+
+//Reduces every segment of x, starting from p.  Empty segments
+//reduce to p.
+template<typename F, typename Tag, typename T>
+sp_cuarray
+segmented_reduce(const F& fn, sequence<Tag, T, 1>& x,
+                 const typename F::result_type& p) {
+    typedef typename F::result_type R;
+    typedef typename detail::stored_sequence<Tag, R>::type sequence_type;
+    detail::segment_data<Tag, T> data(x);
+    size_t n = x.size();
+    sp_cuarray result_ary = make_cuarray<R>(n);
+    sequence_type result =
+        make_sequence<sequence_type>(result_ary, Tag(), true);
+    thrust::fill(result.begin(), result.end(), p);
+    //Only nonempty segments produce a reduction
+    sp_cuarray found_ary = make_cuarray<detail::segment_key>(n);
+    sp_cuarray sums_ary = make_cuarray<R>(n);
+    thrust::pointer<detail::segment_key, Tag> found_keys(
+        make_sequence<sequence<Tag, detail::segment_key, 0> >(
+            found_ary, Tag(), true).m_d);
+    thrust::pointer<R, Tag> sums(
+        make_sequence<sequence<Tag, R, 0> >(sums_ary, Tag(), true).m_d);
+    thrust::pointer<detail::segment_key, Tag> keys;
+    sp_cuarray keys_ary = detail::segment_keys(x, data, keys);
+    size_t found =
+        thrust::reduce_by_key(keys, keys + data.m_l,
+                              data.begin(),
+                              found_keys,
+                              sums,
+                              thrust::equal_to<detail::segment_key>(),
+                              fn).first - found_keys;
+    thrust::transform(sums, sums + found, sums,
+                      detail::prefix_with<F>(fn, p));
+    thrust::scatter(sums, sums + found, found_keys, result.begin());
+    return result_ary;
+}
+
+template<typename Tag, typename T>
+sp_cuarray
+segmented_sum(sequence<Tag, T, 1>& x) {
+    return segmented_reduce(thrust::plus<T>(), x, T(0));
+}
+
+COPPERHEAD_TASK(segmented_map1)
+COPPERHEAD_TASK(segmented_scan)
+COPPERHEAD_TASK(segmented_rscan)
+COPPERHEAD_TASK(segmented_exclusive_scan)
+COPPERHEAD_TASK(segmented_reduce)
+COPPERHEAD_TASK(segmented_sum)
+
+}
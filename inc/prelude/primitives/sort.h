@@ -22,6 +22,7 @@
 #include <prelude/runtime/make_cuarray.hpp>
 #include <prelude/runtime/make_sequence.hpp>
 #include <prelude/runtime/tags.h>
+#include <prelude/runtime/task.hpp>
 
 
 namespace copperhead {
@@ -90,4 +91,41 @@ sort(const fn_cmp_gt<typename Seq::value_type>& fn, Seq& x) {
     return result_ary;
 }
 
+//The _in_place variants sort x, which must view all of x_ary, in
+//its own storage, and return x_ary.  The compiler uses them when
+//nothing reads x afterwards, saving the copy above.
+
+template<typename F, typename Seq>
+sp_cuarray
+sort_in_place(const F& fn, Seq& x, sp_cuarray& x_ary) {
+    thrust::sort(x.begin(),
+                 x.end(),
+                 fn);
+    return x_ary;
+}
+
+template<typename Seq>
+sp_cuarray
+sort_in_place(const fn_cmp_lt<typename Seq::value_type>& fn, Seq& x,
+              sp_cuarray& x_ary) {
+    typedef typename Seq::value_type T;
+    thrust::sort(x.begin(),
+                 x.end(),
+                 thrust::less<T>());
+    return x_ary;
+}
+
+template<typename Seq>
+sp_cuarray
+sort_in_place(const fn_cmp_gt<typename Seq::value_type>& fn, Seq& x,
+              sp_cuarray& x_ary) {
+    typedef typename Seq::value_type T;
+    thrust::sort(x.begin(),
+                 x.end(),
+                 thrust::greater<T>());
+    return x_ary;
+}
+
+COPPERHEAD_TASK(sort)
+
 }
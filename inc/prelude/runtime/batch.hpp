@@ -0,0 +1,284 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <prelude/runtime/cuarray.hpp>
+#include <prelude/runtime/make_cuarray.hpp>
+#include <prelude/runtime/make_sequence.hpp>
+#include <prelude/runtime/task.hpp>
+
+namespace copperhead {
+
+namespace detail {
+
+//How an argument of a batched call reaches each invocation.
+//Anything but a cuarray given for a sequence parameter is passed to
+//every invocation unchanged.
+template<typename P, typename A>
+struct batch_arg {
+    A m_a;
+    batch_arg(const A& a) : m_a(a) {}
+    void count(size_t&, bool&) const {}
+    const A& operator[](size_t) const {
+        return m_a;
+    }
+};
+
+//A cuarray given for a sequence parameter holds one segment per
+//invocation.  Its nested view is built once, and invocation i sees
+//segment i.
+template<typename Tag, typename T>
+struct batch_arg<sequence<Tag, T, 0>, sp_cuarray> {
+    sequence<Tag, T, 1> m_a;
+    batch_arg(const sp_cuarray& a)
+        : m_a(make_sequence<sequence<Tag, T, 1> >(a, Tag(), false)) {}
+    void count(size_t& n, bool& found) const {
+        if (found && (n != m_a.size())) {
+            throw std::invalid_argument(
+                "Batched arguments must have the same number of segments");
+        }
+        n = m_a.size();
+        found = true;
+    }
+    sequence<Tag, T, 0> operator[](size_t i) const {
+        return m_a[i];
+    }
+};
+
+//Runs invocations [b, e) of a batched call, storing the result of
+//invocation i in m_p[i - b]
+template<typename R, typename P>
+struct batch_range {
+    boost::function<R(size_t)> m_f;
+    P m_p;
+    size_t m_b;
+    size_t m_e;
+    batch_range(const boost::function<R(size_t)>& f,
+                const P& p,
+                size_t b, size_t e)
+        : m_f(f), m_p(p), m_b(b), m_e(e) {}
+    void operator()() {
+        for(size_t i = m_b; i < m_e; i++) {
+            m_p[i - m_b] = m_f(i);
+        }
+    }
+};
+
+//Gathers the results of a batched call into one cuarray.
+//Scalar results become a flat cuarray.  Each group of invocations
+//writes its results straight into its own range of the cuarray.
+template<typename E, typename R>
+struct batch_results {
+    typedef sequence<cpp_tag, E, 0> part;
+    sp_cuarray m_a;
+    batch_results(size_t n) : m_a(make_cuarray<E>(n)) {}
+    //Views results [b, e).  Called for each group before any group
+    //runs, since it updates which ranges of the cuarray are valid.
+    part range(size_t b, size_t e) {
+        return make_sequence<part>(m_a, cpp_tag(), true, b, e);
+    }
+    sp_cuarray finish() {
+        return m_a;
+    }
+};
+
+//Sequence results become a nested cuarray, with one segment per
+//invocation.
+template<typename E>
+struct batch_results<E, sp_cuarray> {
+    typedef typename std::vector<sp_cuarray>::iterator part;
+    std::vector<sp_cuarray> m_r;
+    batch_results(size_t n) : m_r(n) {}
+    part range(size_t b, size_t) {
+        return m_r.begin() + b;
+    }
+    sp_cuarray finish() {
+        size_t total = 0;
+        for(size_t i = 0; i < m_r.size(); i++) {
+            total += m_r[i]->size();
+        }
+        sp_cuarray result = make_nested_cuarray<E>(m_r.size(), total);
+        sequence<cpp_tag, E, 1> s =
+            make_sequence<sequence<cpp_tag, E, 1> >(result, cpp_tag(), true);
+        size_t offset = 0;
+        for(size_t i = 0; i < m_r.size(); i++) {
+            s.m_d[i] = offset;
+            sequence<cpp_tag, E, 0> part =
+                make_sequence<sequence<cpp_tag, E, 0> >(m_r[i], cpp_tag(), false);
+            std::copy(part.m_d, part.m_d + part.size(), s.m_s.m_d + offset);
+            offset += part.size();
+        }
+        s.m_d[m_r.size()] = offset;
+        return result;
+    }
+};
+
+//Runs f(0) ... f(n-1), in groups on the runtime's worker threads,
+//and gathers their results
+template<typename E, typename R>
+sp_cuarray run_batch(const boost::function<R(size_t)>& f, size_t n) {
+    typedef batch_results<E, R> results_type;
+    results_type results(n);
+    //A few groups per worker balances uneven invocations without
+    //paying for a task per invocation
+    size_t groups = std::min(n, 4 * worker_count());
+    std::vector<boost::shared_ptr<task_state> > states;
+    for(size_t g = 0; g < groups; g++) {
+        size_t b = n * g / groups;
+        size_t e = n * (g + 1) / groups;
+        boost::shared_ptr<task_state> state(new task_state());
+        submit(state,
+               batch_range<R, typename results_type::part>(
+                   f, results.range(b, e), b, e));
+        states.push_back(state);
+    }
+    //Every group writes into results, so all must finish before an
+    //error leaves this frame
+    wait_all(states);
+    return results.finish();
+}
+
+template<typename R, typename P0, typename A0>
+struct batch_call1 {
+    R (*m_f)(P0);
+    batch_arg<P0, A0> m_a0;
+    batch_call1(R (*f)(P0), const A0& a0)
+        : m_f(f), m_a0(a0) {}
+    size_t count() const {
+        size_t n = 0;
+        bool found = false;
+        m_a0.count(n, found);
+        return n;
+    }
+    R operator()(size_t i) const {
+        return m_f(m_a0[i]);
+    }
+};
+
+template<typename R, typename P0, typename P1, typename A0, typename A1>
+struct batch_call2 {
+    R (*m_f)(P0, P1);
+    batch_arg<P0, A0> m_a0;
+    batch_arg<P1, A1> m_a1;
+    batch_call2(R (*f)(P0, P1), const A0& a0, const A1& a1)
+        : m_f(f), m_a0(a0), m_a1(a1) {}
+    size_t count() const {
+        size_t n = 0;
+        bool found = false;
+        m_a0.count(n, found);
+        m_a1.count(n, found);
+        return n;
+    }
+    R operator()(size_t i) const {
+        return m_f(m_a0[i], m_a1[i]);
+    }
+};
+
+template<typename R, typename P0, typename P1, typename P2,
+         typename A0, typename A1, typename A2>
+struct batch_call3 {
+    R (*m_f)(P0, P1, P2);
+    batch_arg<P0, A0> m_a0;
+    batch_arg<P1, A1> m_a1;
+    batch_arg<P2, A2> m_a2;
+    batch_call3(R (*f)(P0, P1, P2),
+                const A0& a0, const A1& a1, const A2& a2)
+        : m_f(f), m_a0(a0), m_a1(a1), m_a2(a2) {}
+    size_t count() const {
+        size_t n = 0;
+        bool found = false;
+        m_a0.count(n, found);
+        m_a1.count(n, found);
+        m_a2.count(n, found);
+        return n;
+    }
+    R operator()(size_t i) const {
+        return m_f(m_a0[i], m_a1[i], m_a2[i]);
+    }
+};
+
+template<typename R, typename P0, typename P1, typename P2, typename P3,
+         typename A0, typename A1, typename A2, typename A3>
+struct batch_call4 {
+    R (*m_f)(P0, P1, P2, P3);
+    batch_arg<P0, A0> m_a0;
+    batch_arg<P1, A1> m_a1;
+    batch_arg<P2, A2> m_a2;
+    batch_arg<P3, A3> m_a3;
+    batch_call4(R (*f)(P0, P1, P2, P3),
+                const A0& a0, const A1& a1, const A2& a2, const A3& a3)
+        : m_f(f), m_a0(a0), m_a1(a1), m_a2(a2), m_a3(a3) {}
+    size_t count() const {
+        size_t n = 0;
+        bool found = false;
+        m_a0.count(n, found);
+        m_a1.count(n, found);
+        m_a2.count(n, found);
+        m_a3.count(n, found);
+        return n;
+    }
+    R operator()(size_t i) const {
+        return m_f(m_a0[i], m_a1[i], m_a2[i], m_a3[i]);
+    }
+};
+
+}
+
+//batch<E>(f, a0, ...) calls f once per segment of its batched
+//arguments: the cuarrays given for sequence parameters of f, which
+//must be nested one level deeper than f expects and have the same
+//number of segments.  Other arguments are passed to every call.
+//Calls run concurrently on the runtime's worker threads.  The
+//results, whose elements are of type E, are returned as one cuarray:
+//flat if f returns a scalar, nested if it returns a sequence.
+
+template<typename E, typename R, typename P0, typename A0>
+sp_cuarray batch(R (*f)(P0), const A0& a0) {
+    detail::batch_call1<R, P0, A0> call(f, a0);
+    return detail::run_batch<E, R>(call, call.count());
+}
+
+template<typename E, typename R, typename P0, typename P1,
+         typename A0, typename A1>
+sp_cuarray batch(R (*f)(P0, P1), const A0& a0, const A1& a1) {
+    detail::batch_call2<R, P0, P1, A0, A1> call(f, a0, a1);
+    return detail::run_batch<E, R>(call, call.count());
+}
+
+template<typename E, typename R, typename P0, typename P1, typename P2,
+         typename A0, typename A1, typename A2>
+sp_cuarray batch(R (*f)(P0, P1, P2),
+                 const A0& a0, const A1& a1, const A2& a2) {
+    detail::batch_call3<R, P0, P1, P2, A0, A1, A2> call(f, a0, a1, a2);
+    return detail::run_batch<E, R>(call, call.count());
+}
+
+template<typename E, typename R, typename P0, typename P1, typename P2,
+         typename P3, typename A0, typename A1, typename A2, typename A3>
+sp_cuarray batch(R (*f)(P0, P1, P2, P3),
+                 const A0& a0, const A1& a1, const A2& a2, const A3& a3) {
+    detail::batch_call4<R, P0, P1, P2, P3, A0, A1, A2, A3> call(
+        f, a0, a1, a2, a3);
+    return detail::run_batch<E, R>(call, call.count());
+}
+
+}
@@ -20,6 +20,11 @@
 #include <cstddef>
 #include <prelude/runtime/mempool.hpp>
 
+#ifndef BOOST_SP_USE_SPINLOCK
+#define BOOST_SP_USE_SPINLOCK
+#endif
+#include <boost/shared_ptr.hpp>
+
 namespace copperhead {
 
 class chunk {
@@ -27,9 +32,21 @@ private:
     system_variant m_s;
     void* m_d;
     size_t m_r;
+    //False if m_d is owned by the caller
+    bool m_owned;
+    //Keeps externally owned memory alive while the chunk exists
+    boost::shared_ptr<void> m_keep;
 public:
     chunk(const system_variant &s,
           size_t r);
+    //Wraps r bytes of existing memory at d, in the memory space of s.
+    //The chunk never frees d.  If keep is given, the chunk holds a
+    //reference to it, so its deleter can release d once the chunk
+    //is destroyed; otherwise d must outlive the chunk.
+    chunk(const system_variant &s,
+          void* d,
+          size_t r,
+          const boost::shared_ptr<void>& keep=boost::shared_ptr<void>());
     ~chunk();
 private:
     //Not copyable
@@ -38,6 +55,11 @@ private:
     chunk& operator=(const chunk&);
 public:
     void copy_from(chunk& o);
+    //Copies bytes [b, e) of o into the same bytes of this chunk
+    void copy_from(chunk& o, size_t b, size_t e);
+    //Reduces the logical size of the chunk to r bytes.
+    //The underlying allocation is kept, so no data is moved.
+    void shrink(size_t r);
     void* ptr();
     size_t size() const;
     const system_variant& tag() const;
@@ -24,16 +24,36 @@
 #include <boost/scoped_ptr.hpp>
 #include <prelude/runtime/tags.h>
 
+#ifndef BOOST_SP_USE_SPINLOCK
 #define BOOST_SP_USE_SPINLOCK
+#endif
 #include <boost/shared_ptr.hpp>
 
 namespace copperhead {
 
+//Sorted, disjoint [begin, end) ranges of elements
+typedef std::vector<std::pair<size_t, size_t> > range_set;
+
+//For each memory space, the chunks holding the data,
+//and the ranges of elements whose copy in that space is out of date
 typedef std::map<system_variant,
                  std::pair<std::vector<boost::shared_ptr<chunk> >,
-                           bool> ,
+                           range_set> ,
                  system_variant_less> data_map;
 
+namespace detail {
+
+//Adds [b, e) to a range set, merging overlapping and adjacent ranges
+void add_range(range_set& s, size_t b, size_t e);
+
+//Removes [b, e) from a range set
+void remove_range(range_set& s, size_t b, size_t e);
+
+//Returns the parts of a range set which lie within [b, e)
+range_set intersect_range(const range_set& s, size_t b, size_t e);
+
+}
+
 //Forward declaration of PIMPL for hiding std::shared_ptr from NVCC
 class type_holder;
 
@@ -51,13 +71,31 @@ struct cuarray {
     ~cuarray();
     size_t size() const;
     void push_back_length(size_t);
+    //Truncates a flat cuarray to its first l elements, in place
+    void shrink(size_t l);
     void add_chunk(boost::shared_ptr<chunk> c,
                       const bool& v);
     std::vector<boost::shared_ptr<chunk> >& get_chunks(const system_variant& t, bool write);
+    //Only brings elements [b, e) up to date in the memory space of t,
+    //and if write is set, only invalidates those elements elsewhere.
+    //Ranges are tracked for flat cuarrays; for other cuarrays
+    //the whole cuarray is used.
+    std::vector<boost::shared_ptr<chunk> >& get_chunks(const system_variant& t, bool write,
+                                                       size_t b, size_t e);
     bool clean(const system_variant& t);
-    
+private:
+    bool ranged() const;
+    std::pair<size_t, size_t> whole() const;
+    std::pair<size_t, size_t> byte_range(const chunk& c,
+                                         const std::pair<size_t, size_t>& r) const;
 };
 
 typedef boost::shared_ptr<cuarray> sp_cuarray;
 
+//Drops a reference to a cuarray which the program no longer needs,
+//so its storage can go back to the memory pool right away
+inline void release(sp_cuarray& x) {
+    x.reset();
+}
+
 }
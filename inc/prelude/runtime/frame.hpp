@@ -0,0 +1,169 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <thrust/tuple.h>
+#include <prelude/runtime/chunk.hpp>
+#include <prelude/runtime/cuarray.hpp>
+#include <prelude/runtime/tags.h>
+
+#ifndef BOOST_SP_USE_SPINLOCK
+#define BOOST_SP_USE_SPINLOCK
+#endif
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+
+namespace copperhead {
+
+//Memory for the temporaries of one invocation of an entry point.
+//The compiler adds up the sizes of the temporaries, which it derives
+//from the lengths of the inputs, then begins the frame, which makes
+//a single allocation per memory space.  While the frame is current
+//on a thread, chunks that thread allocates are carved out of it in
+//order.  Once it is exhausted, chunks come from the memory pool as
+//usual, so a plan which underestimates is slower, never wrong.
+//Carved chunks keep the frame's memory alive, so temporaries may
+//outlive the frame.
+//Computations spawned while a frame is current run with it current
+//on their worker threads, so several threads may carve from one
+//frame.  Carving is synchronized behind PIMPL, hidden from NVCC.
+class frame
+    : public boost::enable_shared_from_this<frame> {
+private:
+    struct lock;
+    boost::shared_ptr<lock> m_lock;
+    size_t m_r;
+    //For each memory space, the allocation and the bytes carved from it
+    typedef std::map<system_variant,
+                     std::pair<boost::shared_ptr<chunk>, size_t>,
+                     system_variant_less> block_map;
+    block_map m_blocks;
+    //The frame which was current when this one began
+    frame* m_previous;
+    bool m_begun;
+    block_map::iterator block(const system_variant& t);
+public:
+    frame();
+    ~frame();
+private:
+    //Not copyable
+    frame(const frame&);
+    //Not assignable
+    frame& operator=(const frame&);
+public:
+    //Plans for r more bytes.  Must be called before begin().
+    void reserve(size_t r);
+    //Allocates the frame in the memory space of t, where the
+    //computation runs, and makes it current on the calling thread.
+    //Other memory spaces are allocated when first carved from.
+    void begin(const system_variant& t);
+    //Stops carving, so allocations which outlive the invocation,
+    //like its results, come from the memory pool
+    void pause();
+    //Resumes carving after pause()
+    void resume();
+    //Bytes planned per memory space
+    size_t size() const;
+    //Carves r bytes in the memory space of t.  Returns NULL if the
+    //frame has no room, otherwise sets keep to hold the memory alive.
+    void* carve(const system_variant& t, size_t r,
+                boost::shared_ptr<void>& keep);
+};
+
+typedef boost::shared_ptr<frame> sp_frame;
+
+namespace detail {
+
+//The frame carving on the calling thread, or NULL
+frame* current_frame();
+
+//Makes a frame, or none if f is NULL, current on the calling thread
+//until the scope ends
+class frame_scope {
+private:
+    frame* m_previous;
+    //Not copyable
+    frame_scope(const frame_scope&);
+    //Not assignable
+    frame_scope& operator=(const frame_scope&);
+public:
+    frame_scope(frame* f);
+    ~frame_scope();
+};
+
+//Number of chunks make_cuarray allocates for elements of type T
+template<typename T>
+struct chunk_count {
+    static const size_t value = 1;
+};
+
+template<typename HT, typename TT>
+struct chunk_count<thrust::detail::cons<HT, TT> > {
+    static const size_t value =
+        chunk_count<HT>::value + chunk_count<TT>::value;
+};
+
+template<typename T0,
+         typename T1,
+         typename T2,
+         typename T3,
+         typename T4,
+         typename T5,
+         typename T6,
+         typename T7,
+         typename T8,
+         typename T9>
+struct chunk_count<
+    thrust::tuple<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9> > {
+    typedef thrust::tuple<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9> tuple_type;
+    static const size_t value =
+        chunk_count<
+            thrust::detail::cons<
+                typename tuple_type::head_type,
+                typename tuple_type::tail_type> >::value;
+};
+
+template<>
+struct chunk_count<thrust::null_type> {
+    static const size_t value = 0;
+};
+
+//Carved chunks are aligned to this many bytes
+const size_t frame_alignment = 256;
+
+}
+
+sp_frame make_frame();
+
+//Plans for a temporary with elements of type T, as long as in
+template<typename T>
+void reserve(sp_frame& f, const sp_cuarray& in) {
+    f->reserve(in->size() * sizeof(T) +
+               detail::chunk_count<T>::value * detail::frame_alignment);
+}
+
+void begin_frame(sp_frame& f, const system_variant& t);
+
+void pause_frame(sp_frame& f);
+
+void resume_frame(sp_frame& f);
+
+}
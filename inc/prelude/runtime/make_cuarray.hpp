@@ -89,5 +89,55 @@ sp_cuarray make_cuarray(size_t s) {
     return r;
 }
 
+//Makes a nested cuarray of n segments holding l elements in all.
+//The descriptors are left for the caller to fill in.
+template<typename T>
+sp_cuarray make_nested_cuarray(size_t n, size_t l) {
+    type_holder* th = detail::make_type_holder();
+    detail::begin(th);
+    detail::begin(th);
+    detail::add_type(th, T());
+    detail::end_sequence(th);
+    detail::end_sequence(th);
+    detail::finalize_type(th);
+    sp_cuarray r(new cuarray(th));
+    r->push_back_length(n + 1);
+    r->push_back_length(l);
+    r->add_chunk(boost::shared_ptr<chunk>(new chunk(cpp_tag(), (n + 1) * sizeof(size_t))), true);
+    r->add_chunk(boost::shared_ptr<chunk>(new chunk(cpp_tag(), l * sizeof(T))), true);
+#ifdef CUDA_SUPPORT
+    r->add_chunk(boost::shared_ptr<chunk>(new chunk(cuda_tag(), (n + 1) * sizeof(size_t))), true);
+    r->add_chunk(boost::shared_ptr<chunk>(new chunk(cuda_tag(), l * sizeof(T))), true);
+#endif
+    return r;
+}
+
+//Makes a cuarray of s elements which uses existing memory at p,
+//in the memory space of t, without copying it.
+//See chunk for the meaning of keep.
+template<typename T>
+sp_cuarray make_cuarray(const system_variant& t, T* p, size_t s,
+                        const boost::shared_ptr<void>& keep=boost::shared_ptr<void>()) {
+    type_holder* th = detail::make_type_holder();
+    detail::begin(th);
+    sp_cuarray r(new cuarray(th));
+    r->push_back_length(s);
+    detail::add_type(th, T());
+    system_variant canonical = canonical_memory_tag(t);
+    r->add_chunk(boost::shared_ptr<chunk>(new chunk(canonical, p, s * sizeof(T), keep)), true);
+    //Other memory spaces are only allocated if the data migrates there
+    if (!system_variant_equal(canonical, cpp_tag())) {
+        r->add_chunk(boost::shared_ptr<chunk>(new chunk(cpp_tag(), s * sizeof(T))), false);
+    }
+#ifdef CUDA_SUPPORT
+    if (!system_variant_equal(canonical, cuda_tag())) {
+        r->add_chunk(boost::shared_ptr<chunk>(new chunk(cuda_tag(), s * sizeof(T))), false);
+    }
+#endif
+    detail::end_sequence(th);
+    detail::finalize_type(th);
+    return r;
+}
+
 
 }
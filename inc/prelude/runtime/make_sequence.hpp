@@ -120,6 +120,21 @@ S make_sequence(const sp_cuarray& in, system_variant t, bool write) {
     return detail::make_seq_impl<S>::fun(ci, li, r.m_o);
 }
 
+//Makes a sequence viewing elements [b, e) of a flat cuarray.
+//Only those elements are brought up to date in the memory space of t,
+//and if write is set, only those elements are invalidated elsewhere.
+template<typename S>
+S make_sequence(const sp_cuarray& in, system_variant t, bool write,
+                size_t b, size_t e) {
+    cuarray& r = *in;
+    assert(r.m_l.size() == 1);
+    std::vector<boost::shared_ptr<chunk> >& chunks = r.get_chunks(t, write, b, e);
+    typename std::vector<boost::shared_ptr<chunk> >::iterator ci = chunks.begin();
+    std::vector<size_t> l(1, e - b);
+    std::vector<size_t>::const_iterator li = l.begin();
+    return detail::make_seq_impl<S>::fun(ci, li, r.m_o + b);
+}
+
 namespace detail {
 
 template<typename S,
@@ -0,0 +1,57 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+
+#pragma once
+
+#include <string>
+#include <prelude/runtime/make_cuarray.hpp>
+
+namespace copperhead {
+
+namespace detail {
+
+//Maps r bytes of a file, starting at byte offset o, into memory.
+//The returned pointer unmaps the file when the last reference is released.
+//If writable is set, the file is created or extended as necessary,
+//and writes to the memory are carried through to the file.
+//Otherwise writes to the memory are private to this mapping.
+boost::shared_ptr<void> map_file(const std::string& path,
+                                 size_t o,
+                                 size_t r,
+                                 bool writable);
+
+}
+
+//Makes a cuarray of s elements stored in a file, starting at byte
+//offset o.  The file is paged in lazily as the cuarray is read.
+//Unless writable is set, writes to the cuarray leave the file as it was.
+template<typename T>
+sp_cuarray make_mapped_cuarray(const std::string& path,
+                               size_t s,
+                               size_t o=0,
+                               bool writable=false) {
+    boost::shared_ptr<void> mapping =
+        detail::map_file(path, o, s * sizeof(T), writable);
+    return make_cuarray<T>(cpp_tag(), static_cast<T*>(mapping.get()), s, mapping);
+}
+
+//Brings the cpp_tag copy of a cuarray up to date, and
+//flushes it to its file, if it is stored in one.
+//Throws std::runtime_error if the flush fails.
+void sync(const sp_cuarray& a);
+
+}
@@ -1,9 +1,53 @@
 #pragma once
+#include <cstddef>
+#include <vector>
+#include <iosfwd>
 #include <prelude/runtime/tags.h>
 #include <prelude/runtime/tag_malloc_and_free.h>
 
 namespace copperhead {
 
-void take_down();
+//A snapshot of the memory pool for one memory space.
+struct mempool_stats {
+    //Bytes in blocks currently handed out
+    size_t live_bytes;
+    //Bytes requested for blocks currently handed out.
+    //live_bytes - requested_bytes is lost to fragmentation.
+    size_t requested_bytes;
+    //Bytes in free blocks held by the pool for reuse
+    size_t cached_bytes;
+    //High water mark of live_bytes, sampled when memory is drawn
+    //from the system and when statistics are read
+    size_t peak_live_bytes;
+    //High water mark of live_bytes + cached_bytes
+    size_t peak_footprint_bytes;
+    //Allocations served from the cache
+    size_t hits;
+    //Allocations which required new memory from the system
+    size_t misses;
+    //Times the cache was emptied because an allocation failed
+    size_t flushes;
+    //histogram[i] counts requests for [2^i, 2^(i+1)) bytes
+    std::vector<size_t> histogram;
+};
+
+//Returns statistics for the memory space used by t
+mempool_stats get_stats(const system_variant& t);
+
+//Returns the least recently freed blocks in the memory space used by t
+//to the system, until at most bytes remain cached for reuse.
+void trim(const system_variant& t, size_t bytes=0);
+
+//Caps the bytes cached for reuse in the memory space used by t.
+//Once the cap is exceeded, the least recently freed blocks are returned
+//to the system.  By default the cache is unbounded.
+void set_cache_limit(const system_variant& t, size_t bytes);
+
+//Prints statistics for all memory spaces
+void print_stats(std::ostream& o);
+
+//Releases all memory held by the pool.
+//If print is true, statistics are printed to std::cerr first.
+void take_down(bool print=false);
 
 }
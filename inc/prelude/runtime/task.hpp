@@ -0,0 +1,269 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/bind/bind.hpp>
+
+#ifndef BOOST_SP_USE_SPINLOCK
+#define BOOST_SP_USE_SPINLOCK
+#endif
+#include <boost/shared_ptr.hpp>
+
+namespace copperhead {
+
+namespace detail {
+
+//Completion of a computation running on the runtime's worker
+//threads.  The synchronization is hidden from NVCC behind PIMPL.
+class task_state {
+private:
+    struct impl;
+    boost::shared_ptr<impl> m_impl;
+public:
+    task_state();
+    //Runs f, recording any exception it throws, then marks the task
+    //complete
+    void run(const boost::function<void()>& f);
+    //Blocks until the task is complete.  If it threw, rethrows.
+    void wait() const;
+    bool ready() const;
+};
+
+//Queues s->run(f) on the runtime's worker threads
+void submit(const boost::shared_ptr<task_state>& s,
+            const boost::function<void()>& f);
+
+//Waits for every task, then rethrows the first error any of them
+//threw, if one did
+void wait_all(const std::vector<boost::shared_ptr<task_state> >& s);
+
+//Number of the runtime's worker threads
+size_t worker_count();
+
+template<typename R>
+struct store_result {
+    boost::shared_ptr<R> m_r;
+    boost::function<R()> m_f;
+    store_result(const boost::shared_ptr<R>& r,
+                 const boost::function<R()>& f) : m_r(r), m_f(f) {}
+    void operator()() const {
+        *m_r = m_f();
+    }
+};
+
+}
+
+//The result of a computation running on the runtime's worker threads
+template<typename R>
+class future {
+private:
+    boost::shared_ptr<detail::task_state> m_state;
+    boost::shared_ptr<R> m_result;
+public:
+    future() {}
+    //Starts computing f()
+    explicit future(const boost::function<R()>& f)
+        : m_state(new detail::task_state()), m_result(new R()) {
+        detail::submit(m_state,
+                       detail::store_result<R>(m_result, f));
+    }
+    //Waits for the result.  If the computation threw, rethrows.
+    R get() const {
+        m_state->wait();
+        return *m_result;
+    }
+    bool ready() const {
+        return m_state->ready();
+    }
+};
+
+//Starts computing f(a0, ...) on the runtime's worker threads.
+//Arguments are copied, so views must outlive the computation.
+template<typename F, typename A0>
+future<typename F::result_type>
+spawn(const F& f, const A0& a0) {
+    return future<typename F::result_type>(
+        boost::bind(f, a0));
+}
+
+template<typename F, typename A0, typename A1>
+future<typename F::result_type>
+spawn(const F& f, const A0& a0, const A1& a1) {
+    return future<typename F::result_type>(
+        boost::bind(f, a0, a1));
+}
+
+template<typename F, typename A0, typename A1, typename A2>
+future<typename F::result_type>
+spawn(const F& f, const A0& a0, const A1& a1, const A2& a2) {
+    return future<typename F::result_type>(
+        boost::bind(f, a0, a1, a2));
+}
+
+template<typename F, typename A0, typename A1, typename A2, typename A3>
+future<typename F::result_type>
+spawn(const F& f, const A0& a0, const A1& a1, const A2& a2, const A3& a3) {
+    return future<typename F::result_type>(
+        boost::bind(f, a0, a1, a2, a3));
+}
+
+template<typename F, typename A0, typename A1, typename A2, typename A3,
+         typename A4>
+future<typename F::result_type>
+spawn(const F& f, const A0& a0, const A1& a1, const A2& a2, const A3& a3,
+      const A4& a4) {
+    return future<typename F::result_type>(
+        boost::bind(f, a0, a1, a2, a3, a4));
+}
+
+template<typename F, typename A0, typename A1, typename A2, typename A3,
+         typename A4, typename A5>
+future<typename F::result_type>
+spawn(const F& f, const A0& a0, const A1& a1, const A2& a2, const A3& a3,
+      const A4& a4, const A5& a5) {
+    return future<typename F::result_type>(
+        boost::bind(f, a0, a1, a2, a3, a4, a5));
+}
+
+//Starts calling a function on the runtime's worker threads.  These
+//overloads start entry points, which take up to nine arguments.
+template<typename R>
+future<R> spawn(R (*f)()) {
+    return future<R>(f);
+}
+
+template<typename R, typename P0, typename A0>
+future<R> spawn(R (*f)(P0), const A0& a0) {
+    return future<R>(boost::bind(f, a0));
+}
+
+template<typename R, typename P0, typename P1, typename A0, typename A1>
+future<R> spawn(R (*f)(P0, P1), const A0& a0, const A1& a1) {
+    return future<R>(boost::bind(f, a0, a1));
+}
+
+template<typename R, typename P0, typename P1, typename P2,
+         typename A0, typename A1, typename A2>
+future<R> spawn(R (*f)(P0, P1, P2),
+                const A0& a0, const A1& a1, const A2& a2) {
+    return future<R>(boost::bind(f, a0, a1, a2));
+}
+
+template<typename R, typename P0, typename P1, typename P2, typename P3,
+         typename A0, typename A1, typename A2, typename A3>
+future<R> spawn(R (*f)(P0, P1, P2, P3),
+                const A0& a0, const A1& a1, const A2& a2, const A3& a3) {
+    return future<R>(boost::bind(f, a0, a1, a2, a3));
+}
+
+template<typename R, typename P0, typename P1, typename P2, typename P3,
+         typename P4,
+         typename A0, typename A1, typename A2, typename A3,
+         typename A4>
+future<R> spawn(R (*f)(P0, P1, P2, P3, P4),
+                const A0& a0, const A1& a1, const A2& a2, const A3& a3,
+                const A4& a4) {
+    return future<R>(boost::bind(f, a0, a1, a2, a3, a4));
+}
+
+template<typename R, typename P0, typename P1, typename P2, typename P3,
+         typename P4, typename P5,
+         typename A0, typename A1, typename A2, typename A3,
+         typename A4, typename A5>
+future<R> spawn(R (*f)(P0, P1, P2, P3, P4, P5),
+                const A0& a0, const A1& a1, const A2& a2, const A3& a3,
+                const A4& a4, const A5& a5) {
+    return future<R>(boost::bind(f, a0, a1, a2, a3, a4, a5));
+}
+
+template<typename R, typename P0, typename P1, typename P2, typename P3,
+         typename P4, typename P5, typename P6,
+         typename A0, typename A1, typename A2, typename A3,
+         typename A4, typename A5, typename A6>
+future<R> spawn(R (*f)(P0, P1, P2, P3, P4, P5, P6),
+                const A0& a0, const A1& a1, const A2& a2, const A3& a3,
+                const A4& a4, const A5& a5, const A6& a6) {
+    return future<R>(boost::bind(f, a0, a1, a2, a3, a4, a5, a6));
+}
+
+template<typename R, typename P0, typename P1, typename P2, typename P3,
+         typename P4, typename P5, typename P6, typename P7,
+         typename A0, typename A1, typename A2, typename A3,
+         typename A4, typename A5, typename A6, typename A7>
+future<R> spawn(R (*f)(P0, P1, P2, P3, P4, P5, P6, P7),
+                const A0& a0, const A1& a1, const A2& a2, const A3& a3,
+                const A4& a4, const A5& a5, const A6& a6, const A7& a7) {
+    return future<R>(boost::bind(f, a0, a1, a2, a3, a4, a5, a6, a7));
+}
+
+template<typename R, typename P0, typename P1, typename P2, typename P3,
+         typename P4, typename P5, typename P6, typename P7, typename P8,
+         typename A0, typename A1, typename A2, typename A3,
+         typename A4, typename A5, typename A6, typename A7, typename A8>
+future<R> spawn(R (*f)(P0, P1, P2, P3, P4, P5, P6, P7, P8),
+                const A0& a0, const A1& a1, const A2& a2, const A3& a3,
+                const A4& a4, const A5& a5, const A6& a6, const A7& a7,
+                const A8& a8) {
+    return future<R>(boost::bind(f, a0, a1, a2, a3, a4, a5, a6, a7, a8));
+}
+
+//Waits for a spawned computation and returns its result
+template<typename R>
+R join(const future<R>& f) {
+    return f.get();
+}
+
+}
+
+//Defines name_task<R>, a function object which calls the primitive
+//name and returns its result as an R, so it can be spawned
+#define COPPERHEAD_TASK(name)                                           \
+    template<typename R>                                                \
+    struct name##_task {                                                \
+        typedef R result_type;                                          \
+        template<typename A0>                                           \
+        R operator()(A0& a0) const {                                    \
+            return name(a0);                                            \
+        }                                                               \
+        template<typename A0, typename A1>                              \
+        R operator()(A0& a0, A1& a1) const {                            \
+            return name(a0, a1);                                        \
+        }                                                               \
+        template<typename A0, typename A1, typename A2>                 \
+        R operator()(A0& a0, A1& a1, A2& a2) const {                    \
+            return name(a0, a1, a2);                                    \
+        }                                                               \
+        template<typename A0, typename A1, typename A2, typename A3>    \
+        R operator()(A0& a0, A1& a1, A2& a2, A3& a3) const {            \
+            return name(a0, a1, a2, a3);                                \
+        }                                                               \
+        template<typename A0, typename A1, typename A2, typename A3,    \
+                 typename A4>                                           \
+        R operator()(A0& a0, A1& a1, A2& a2, A3& a3, A4& a4) const {    \
+            return name(a0, a1, a2, a3, a4);                            \
+        }                                                               \
+        template<typename A0, typename A1, typename A2, typename A3,    \
+                 typename A4, typename A5>                              \
+        R operator()(A0& a0, A1& a1, A2& a2, A3& a3, A4& a4,            \
+                     A5& a5) const {                                    \
+            return name(a0, a1, a2, a3, a4, a5);                        \
+        }                                                               \
+    };
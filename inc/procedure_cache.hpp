@@ -0,0 +1,102 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ */
+/*! \file procedure_cache.hpp
+ *  \brief An in-memory cache of lowered procedures.
+ */
+
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+#include "statement.hpp"
+#include "prelude/runtime/tags.h"
+
+namespace backend {
+
+/*!
+  \addtogroup utilities
+  @{
+*/
+
+//! Finds the procedures each top level procedure depends on
+/*! \param n A suite of procedures.
+    \return For every statement of \p n, the positions in \p n of
+    the procedures it calls, directly or transitively, in increasing
+    order.  A statement never lists itself.
+*/
+std::vector<std::vector<std::size_t> > transitive_callees(const suite& n);
+
+//! A cache of lowered procedures, for incremental recompilation
+/*! Each entry holds the top level statements the compiler produced
+  for one procedure of its input: the lowered procedure itself,
+  followed by any statements generated for it, such as its functor
+  structure.  Entries are keyed by a \ref backend::structural_hash
+  "structural hash" of the procedure together with every procedure
+  it transitively calls, since what a procedure lowers to depends on
+  what its callees were found to be.
+
+  A cache belongs to a single \ref backend::compiler "compiler", so
+  the entry point and the backend system tag are not part of the key.
+*/
+class procedure_cache {
+public:
+    //! The statements produced for one procedure
+    typedef std::vector<std::shared_ptr<const statement> > fragment;
+private:
+    std::unordered_map<std::uint64_t, fragment> m_fragments;
+    std::size_t m_hits;
+    std::size_t m_misses;
+public:
+    procedure_cache();
+
+    //! Computes the key of every statement of a suite
+    /*! \param n A suite of procedures.
+        \param callees The result of \p transitive_callees(n).
+        \param t The backend system tag.
+    */
+    static std::vector<std::uint64_t> keys(
+        const suite& n,
+        const std::vector<std::vector<std::size_t> >& callees,
+        const copperhead::system_variant& t);
+
+    //! Finds the fragment for a key
+    /*! \return true if it was found, in which case \p f holds it.
+     */
+    bool lookup(std::uint64_t key, fragment& f);
+
+    //! Stores the fragment for a key, replacing any previous one
+    void store(std::uint64_t key, const fragment& f);
+
+    //! Forgets every fragment
+    void clear();
+
+    //! Number of fragments held
+    std::size_t size() const;
+
+    //! Number of lookups which found a fragment
+    std::size_t hits() const;
+
+    //! Number of lookups which found nothing
+    std::size_t misses() const;
+};
+
+/*!
+  @}
+*/
+
+}
@@ -40,8 +40,8 @@ class prune
     : public rewriter<prune>
 {
 private:
-    environment<std::string> m_used;
-    environment<std::string> m_protected;
+    environment<symbol> m_used;
+    environment<symbol> m_protected;
 public:
     using rewriter<prune>::operator();
     result_type operator()(const suite& n);
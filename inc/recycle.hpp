@@ -0,0 +1,81 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+#pragma once
+#include <string>
+#include "node.hpp"
+#include "rewriter.hpp"
+#include "liveness.hpp"
+
+namespace backend {
+
+/*!
+  \addtogroup rewriters
+  @{
+*/
+
+//! A rewrite pass which lets the entry point reuse dead buffers
+/*! Every cuarray allocated by the entry point stays alive until the
+ *  entry point returns, so a long program holds all its temporaries
+ *  at once.  Using a \ref backend::liveness "liveness" analysis of
+ *  the body of the entry point, this pass
+ *
+ *  - releases each cuarray it binds right after its last use, so
+ *  once nothing refers to its storage, the storage goes back to the
+ *  memory pool and the next allocation of a similar size reuses it:
+ *  \code
+ *  x_ary = sort(fn, y)
+ *  x = make_sequence<sequence<tag, float> >(x_ary, tag, true)
+ *  s = reduce(op_add, x, 0)
+ *  release(x_ary)
+ *  \endcode
+ *  Cuarrays which die when only the return remains are left for the
+ *  return to release.
+ *
+ *  - computes a sort, scan or scatter in the storage of its input
+ *  when that input dies at the same statement:
+ *  \code
+ *  x_ary = sort_in_place(fn, y, y_ary)
+ *  \endcode
+ *
+ *  This pass runs after \ref backend::containerize "containerize",
+ *  once every cuarray the entry point uses has been made explicit.
+*/
+class recycle
+    : public rewriter<recycle>
+{
+private:
+    const std::string& m_entry_point;
+    const suite* m_body;
+    std::shared_ptr<const statement> in_place(const liveness& l,
+                                              const suite& n,
+                                              int i);
+    std::shared_ptr<const suite> release(const suite& n);
+public:
+    //! Constructor
+    /*! \param entry_point The name of the entry point procedure
+     */
+    recycle(const std::string& entry_point);
+    using rewriter<recycle>::operator();
+    result_type operator()(const procedure& n);
+    result_type operator()(const suite& n);
+};
+
+/*!
+  @}
+*/
+
+}
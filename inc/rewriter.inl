@@ -64,7 +64,7 @@ typename rewriter<Derived>::result_type rewriter<Derived>::operator()(const tupl
     auto t = n.type().ptr();
     auto ct = n.ctype().ptr();
         
-    return result_type(new tuple(move(n_values), t, ct));
+    return make_node<const tuple>(move(n_values), t, ct);
 }
 
 template<typename Derived>
@@ -80,7 +80,7 @@ typename rewriter<Derived>::result_type rewriter<Derived>::operator()(const appl
     if (is_match())
         return n.ptr();
     
-    return result_type(new apply(n_fn, n_args));
+    return make_node<const apply>(n_fn, n_args);
 }
 
 template<typename Derived>
@@ -96,7 +96,7 @@ typename rewriter<Derived>::result_type rewriter<Derived>::operator()(const lamb
         return n.ptr();
     auto t = n.type().ptr();
     auto ct = n.ctype().ptr();
-    return result_type(new lambda(n_args, n_body, t, ct));
+    return make_node<const lambda>(n_args, n_body, t, ct);
 }
 
 template<typename Derived>
@@ -112,7 +112,7 @@ typename rewriter<Derived>::result_type rewriter<Derived>::operator()(const clos
         return n.ptr();
     auto t = n.type().ptr();
     auto ct = n.ctype().ptr();
-    return result_type(new closure(n_args, n_body, t, ct));
+    return make_node<const closure>(n_args, n_body, t, ct);
 }
 
 template<typename Derived>
@@ -128,7 +128,7 @@ typename rewriter<Derived>::result_type rewriter<Derived>::operator()(const subs
         n.ptr();
     auto t = n.type().ptr();
     auto ct = n.ctype().ptr();
-    return result_type(new subscript(n_src, n_idx, t, ct));
+    return make_node<const subscript>(n_src, n_idx, t, ct);
 }
 
 template<typename Derived>
@@ -145,7 +145,7 @@ typename rewriter<Derived>::result_type rewriter<Derived>::operator()(const cond
     update_match(n_orelse, n.orelse());
     if (is_match())
         return n.ptr();
-    return result_type(new conditional(n_cond, n_then, n_orelse));
+    return make_node<const conditional>(n_cond, n_then, n_orelse);
 }
 
 template<typename Derived>
@@ -156,7 +156,7 @@ typename rewriter<Derived>::result_type rewriter<Derived>::operator()(const ret
     update_match(n_val, n.val());
     if (is_match())
         return n.ptr();
-    return result_type(new ret(n_val));
+    return make_node<const ret>(n_val);
 }
 
 template<typename Derived>
@@ -170,7 +170,7 @@ typename rewriter<Derived>::result_type rewriter<Derived>::operator()(const bind
     update_match(n_rhs, n.rhs());
     if (is_match())
         return n.ptr();
-    return result_type(new bind(n_lhs, n_rhs));
+    return make_node<const bind>(n_lhs, n_rhs);
 }
 
 template<typename Derived>
@@ -181,7 +181,7 @@ typename rewriter<Derived>::result_type rewriter<Derived>::operator()(const call
     update_match(n_sub, n.sub());
     if (is_match())
         return n.ptr();
-    return result_type(new call(n_sub));
+    return make_node<const call>(n_sub);
 }
 
 template<typename Derived>
@@ -198,7 +198,7 @@ typename rewriter<Derived>::result_type rewriter<Derived>::operator()(const proc
     auto t = n.type().ptr();
     auto ct = n.ctype().ptr();
 
-    return result_type(new procedure(n_id, n_args, n_stmts, t, ct));
+    return make_node<const procedure>(n_id, n_args, n_stmts, t, ct);
 }
 
 template<typename Derived>
@@ -223,7 +223,7 @@ typename rewriter<Derived>::result_type rewriter<Derived>::operator()(const suit
     }
     if (is_match())
         return n.ptr();
-    return result_type(new suite(move(n_stmts)));
+    return make_node<const suite>(move(n_stmts));
 }
 
 template<typename Derived>
@@ -244,7 +244,7 @@ typename rewriter<Derived>::result_type rewriter<Derived>::operator()(const stru
         i++) {
         new_typevars.push_back(i->ptr());
     }
-    return result_type(new structure(n_id, n_stmts, move(new_typevars)));
+    return make_node<const structure>(n_id, n_stmts, move(new_typevars));
 }
 
 template<typename Derived>
@@ -283,7 +283,7 @@ typename rewriter<Derived>::result_type rewriter<Derived>::operator()(const whil
     update_match(n_stmts, n.stmts());
     if (is_match())
         return n.ptr();
-    return result_type(new while_block(n_pred, n_stmts));
+    return make_node<const while_block>(n_pred, n_stmts);
 }
 
 }
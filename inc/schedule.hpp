@@ -0,0 +1,75 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+#pragma once
+#include <string>
+#include <vector>
+#include "node.hpp"
+#include "rewriter.hpp"
+#include "liveness.hpp"
+
+namespace backend {
+
+/*!
+  \addtogroup rewriters
+  @{
+*/
+
+//! A rewrite pass which runs independent primitives concurrently
+/*! The entry point calls its primitives one after another, even when
+ *  they don't depend on each other.  This pass spawns primitive calls
+ *  onto the runtime's worker threads, and only waits for a result
+ *  just before something needs it:
+ *  \code
+ *  task0 = spawn(sort_task<sp_cuarray>(), fn, x)
+ *  task1 = spawn(sort_task<sp_cuarray>(), fn, y)
+ *  a_ary = join(task0)
+ *  b_ary = join(task1)
+ *  \endcode
+ *  Statements are first reordered, within stretches of binds, so
+ *  primitives which only depend on values that are already available
+ *  are spawned before anything which has to wait.  A computation is
+ *  also waited for before the storage it reads is released, before
+ *  the entry point returns, and before any loop, conditional or
+ *  primitive computed in place.  A primitive is only spawned when
+ *  another one can run while it does.
+ *
+ *  This pass runs after \ref backend::plan_memory "plan_memory".
+*/
+class schedule
+    : public rewriter<schedule>
+{
+private:
+    const std::string& m_entry_point;
+    bool m_enabled;
+    bool heavy(const statement& s) const;
+    std::vector<std::shared_ptr<const statement> > reorder(const suite& n) const;
+public:
+    //! Constructor
+    /*! \param entry_point The name of the entry point procedure
+        \param enabled Whether to schedule, otherwise the pass does
+        nothing
+     */
+    schedule(const std::string& entry_point, bool enabled);
+    using rewriter<schedule>::operator();
+    result_type operator()(const procedure& n);
+};
+
+/*!
+  @}
+*/
+
+}
@@ -0,0 +1,77 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+#pragma once
+#include <string>
+#include <unordered_map>
+#include "node.hpp"
+#include "rewriter.hpp"
+
+namespace backend {
+
+/*!
+  \addtogroup rewriters
+  @{
+*/
+
+//! A rewrite pass which maps, scans and reduces nested sequences segment-wise
+/*! A map over a nested sequence whose function maps, scans or reduces
+ *  its argument, for example
+ *  \code
+ *  def prefix(xs):
+ *      return scan(op_add, xs)
+ *  ys = map(prefix, xss)
+ *  s = map(sum, xss)
+ *  \endcode
+ *  runs a separate small primitive for every segment, so one very
+ *  long segment holds up the whole map.  This pass replaces such maps
+ *  with segmented primitives, which divide the elements of all the
+ *  segments evenly among threads, using the descriptors of the nested
+ *  sequence:
+ *  \code
+ *  ys = segmented_scan(op_add, xss)
+ *  s = segmented_sum(xss)
+ *  \endcode
+ *  The function may map with \p map, scan with \p scan, \p rscan or
+ *  \p exclusive_scan, or reduce with \p reduce or \p sum.  It must
+ *  take a single argument and only apply the primitive to it, with a
+ *  named function and, where the primitive takes one, a literal
+ *  prefix.
+ *
+ *  This pass looks into every procedure of the suite it is given, so
+ *  it runs on the program as a whole, before
+ *  \ref backend::phase_analyze "phase_analyze".
+*/
+class segment
+    : public rewriter<segment>
+{
+private:
+    //The primitive each segmentable procedure applies
+    std::unordered_map<symbol, std::shared_ptr<const apply> > m_segmentable;
+    result_type segmented(const bind& n);
+public:
+    //! Constructor
+    segment();
+    using rewriter<segment>::operator();
+    result_type operator()(const suite& n);
+    result_type operator()(const bind& n);
+};
+
+/*!
+  @}
+*/
+
+}
@@ -0,0 +1,116 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ */
+/*! \file structural_hash.hpp
+ *  \brief Hashing of AST nodes by structure.
+ */
+
+#pragma once
+#include <string>
+#include <cstdint>
+#include "node.hpp"
+#include "expression.hpp"
+#include "statement.hpp"
+#include "cppnode.hpp"
+#include "type.hpp"
+#include "ctype.hpp"
+#include "prelude/runtime/tags.h"
+
+namespace backend {
+
+/*!
+  \addtogroup utilities
+  @{
+*/
+
+//! Computes a hash of an AST from its structure
+/*! Two trees hash equally if they have the same shape, identifiers,
+  types and C++ implementation types, no matter where their nodes
+  live in memory.  The hash is 64 bit FNV-1a over a canonical
+  serialization of the tree, so it is stable from one process to
+  the next.
+*/
+class structural_hasher
+    : public boost::static_visitor<>
+{
+public:
+    //! Constructor
+    /*! \param t The backend system tag, used when hashing C++
+      implementation types, since sequence types depend on it.
+      \param serialization If not null, the canonical serialization
+      hashed is appended to it, so that trees whose hashes collide
+      can still be told apart.
+    */
+    structural_hasher(const copperhead::system_variant& t,
+                      std::string* serialization = nullptr);
+
+    void operator()(const literal &n);
+
+    void operator()(const name &n);
+
+    void operator()(const tuple &n);
+
+    void operator()(const apply &n);
+
+    void operator()(const lambda &n);
+
+    void operator()(const closure &n);
+
+    void operator()(const subscript &n);
+
+    void operator()(const ret &n);
+
+    void operator()(const bind &n);
+
+    void operator()(const call &n);
+
+    void operator()(const procedure &n);
+
+    void operator()(const conditional &n);
+
+    void operator()(const suite &n);
+
+    //! Nodes which only appear after C++ lowering hash by kind alone
+    void operator()(const node &n);
+
+    //! Mixes a string into the hash
+    void operator()(const std::string &s);
+
+    //! Gets the hash of everything visited so far
+    std::uint64_t value() const;
+private:
+    void mix(const std::string &s);
+    void mix(std::uint64_t v);
+    void type(const type_t &t);
+    void ctype(const ctype::type_t &t);
+
+    std::uint64_t m_h;
+    const copperhead::system_variant& m_t;
+    std::string* m_s;
+};
+
+//! Hashes an AST by structure
+/*! \param n The root of the AST.
+    \param t The backend system tag.
+ */
+std::uint64_t structural_hash(const node &n,
+                              const copperhead::system_variant& t);
+
+/*!
+  @}
+*/
+
+}
@@ -0,0 +1,94 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ */
+/*! \file symbol.hpp
+ *  \brief Interned identifiers.
+ */
+
+#pragma once
+#include <string>
+#include <functional>
+#include <ostream>
+
+namespace backend {
+
+/*!
+  \addtogroup utilities
+  @{
+*/
+
+//! An interned identifier
+/*! Every distinct identifier text is assigned a small integer id
+  from a global, thread safe table the first time a \p symbol is
+  made from it.  The table is sharded by the hash of the text, so
+  that threads making names rarely contend.  Comparing and hashing symbols then only touches the
+  id, which makes symbols cheap keys for environments and the
+  registry.  The table is never emptied, so the text of a symbol
+  remains valid for the life of the process.
+
+  Symbols convert implicitly to and from \p std::string, so they can
+  be used wherever identifier text is expected.
+*/
+class symbol {
+private:
+    unsigned int m_id;
+    const std::string* m_text;
+public:
+    //! Interns \p text
+    symbol(const std::string& text);
+    //! Interns \p text
+    symbol(const char* text);
+    //! Gets the id of this symbol
+    unsigned int id() const {
+        return m_id;
+    }
+    //! Gets the text of this symbol
+    const std::string& str() const {
+        return *m_text;
+    }
+    operator const std::string&() const {
+        return *m_text;
+    }
+    bool operator==(const symbol& o) const {
+        return m_id == o.m_id;
+    }
+    bool operator!=(const symbol& o) const {
+        return m_id != o.m_id;
+    }
+    //! Orders symbols by id, not by text
+    bool operator<(const symbol& o) const {
+        return m_id < o.m_id;
+    }
+};
+
+std::ostream& operator<<(std::ostream& strm, const symbol& s);
+
+/*!
+  @}
+*/
+
+}
+
+namespace std {
+
+template<>
+struct hash<backend::symbol> {
+    size_t operator()(const backend::symbol& s) const {
+        return s.id();
+    }
+};
+
+}
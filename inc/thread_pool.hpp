@@ -0,0 +1,81 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ */
+/*! \file thread_pool.hpp
+ *  \brief A pool of worker threads for running compiler passes.
+ */
+
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+namespace backend {
+
+/*!
+  \addtogroup utilities
+  @{
+*/
+
+//! A fixed set of worker threads which run indexed loops
+/*! The workers are started when the pool is constructed and sleep
+  between calls to \p for_each, so a pool can be reused across
+  passes and compilations without paying for thread creation.
+*/
+class thread_pool {
+private:
+    std::vector<std::thread> m_workers;
+    std::mutex m_call;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const std::function<void(std::size_t)>* m_fn;
+    std::size_t m_next;
+    std::size_t m_count;
+    std::size_t m_pending;
+    std::exception_ptr m_error;
+    bool m_stop;
+    void work();
+    void run(std::unique_lock<std::mutex>& lock);
+public:
+    //! Constructor
+    /*! \param threads The number of threads which run loop
+      iterations, counting the thread which calls \p for_each.  If
+      zero, one thread per hardware thread is used.
+    */
+    thread_pool(std::size_t threads = 0);
+    ~thread_pool();
+    //! Gets the number of threads which run loop iterations
+    std::size_t size() const;
+    //! Calls \p fn(i) for every \p i in [0, \p n)
+    /*! Iterations run concurrently and in no particular order; the
+      calling thread runs iterations too.  Returns once every
+      iteration has finished.  If any iteration throws, one of the
+      exceptions is rethrown here.  \p fn must not itself call \p
+      for_each on the same pool.
+    */
+    void for_each(std::size_t n, const std::function<void(std::size_t)>& fn);
+};
+
+/*!
+  @}
+*/
+
+}
@@ -19,6 +19,7 @@
 #include <boost/variant.hpp>
 #include <functional>
 #include <memory>
+#include "arena.hpp"
 
 namespace backend {
 
@@ -32,6 +32,12 @@ std::string fnize_id(const std::string &in);
 std::string wrap_array_id(const std::string &in);
 //! Creates a name for the wrapping procedure.
 std::string wrap_proc_id(const std::string &in);
+//! Creates a name for the asynchronous wrapping procedure.
+std::string async_proc_id(const std::string &in);
+//! Creates a name for the batched wrapping procedure.
+std::string batch_proc_id(const std::string &in);
+//! Creates a name for the body of the entry point, taking views.
+std::string body_proc_id(const std::string &in);
 //! Creates a name for the unique type of an identifier.
 std::string typify(const std::string &in);
 //! Creates a name for the completed identifier after a synchronization point.
@@ -39,7 +39,33 @@ namespace backend {
   whereas the rest of the program operates solely on views.  This pass
   adds a wrapper which operates on containers, derives views, and then
   calls the body of the entry point.
-  
+
+  If asked, it also adds an asynchronous wrapper, which takes the
+  same containers, starts the entry point on the runtime's worker
+  threads, and returns a \p future for its result straight away:
+
+  \verbatim
+  future<sp_cuarray> async_entry(sp_cuarray aryx) {
+      future<sp_cuarray> result = spawn(_entry, aryx);
+      return result;
+  }
+  \endverbatim
+
+  It can also add a batched wrapper, which runs the entry point once
+  for each segment of nested containers in a single call.  The body
+  of the entry point is kept as a procedure of its own, taking views,
+  and the runtime's \p batch calls it for every segment:
+
+  \verbatim
+  sp_cuarray batch_entry(sp_cuarray aryx, float a) {
+      return batch<float>(body_entry, aryx, a);
+  }
+  \endverbatim
+
+  Arguments which are sequences of scalars are batched, scalar
+  arguments are shared by every segment.  Entry points taking or
+  returning anything else, or returning the container of an argument,
+  are not batched.
 */
 class wrap
     : public rewriter<wrap>
@@ -48,14 +74,31 @@ private:
     const copperhead::system_variant& m_target;
     const std::string& m_entry_point;
     bool m_wrapping;
+    bool m_async;
+    bool m_batch;
+    std::vector<symbol> m_returned;
     bool needs_container(const type_t&);
+    std::shared_ptr<const procedure> async_wrapper(
+        const procedure& n,
+        const tuple& args,
+        const std::shared_ptr<const ctype::tuple_t>& p_arg_ct,
+        const std::shared_ptr<const ctype::type_t>& p_res_t);
+    std::vector<std::shared_ptr<const statement> > batch_wrapper(
+        const procedure& n,
+        const tuple& args,
+        const std::shared_ptr<const ctype::tuple_t>& p_arg_ct,
+        const suite& body,
+        const std::shared_ptr<const ctype::type_t>& p_res_t);
 public:
     //! Constructor
 /*! 
   
   \param entry_point Name of the entry point procedure
+  \param async Whether to add the asynchronous wrapper
+  \param batch Whether to add the batched wrapper
 */
-    wrap(const copperhead::system_variant&, const std::string& entry_point);
+    wrap(const copperhead::system_variant&, const std::string& entry_point,
+         bool async, bool batch);
     
     using rewriter<wrap>::operator();
     //! Rewrite rule for \p procedure nodes
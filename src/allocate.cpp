@@ -3,7 +3,6 @@
 
 using std::vector;
 using std::shared_ptr;
-using std::make_shared;
 using std::move;
 using std::string;
 using std::static_pointer_cast;
@@ -33,7 +32,7 @@ allocate::result_type allocate::operator()(const procedure &n) {
 shared_ptr<const ctype::type_t> allocate::container_type(const ctype::type_t& t) {
     if (detail::isinstance<ctype::sequence_t>(t)) {
         const ctype::sequence_t& st = detail::up_get<const ctype::sequence_t&>(t);
-        return make_shared<const ctype::cuarray_t>(st.sub().ptr());
+        return make_node<const ctype::cuarray_t>(st.sub().ptr());
     } else if (detail::isinstance<ctype::tuple_t>(t)) {
         const ctype::tuple_t& tt = boost::get<const ctype::tuple_t&>(t);
         vector<shared_ptr<const ctype::type_t> > subs;
@@ -48,7 +47,7 @@ shared_ptr<const ctype::type_t> allocate::container_type(const ctype::type_t& t)
         if (!containerize) {
             return t.ptr();
         }
-        return make_shared<const ctype::tuple_t>(
+        return make_node<const ctype::tuple_t>(
             move(subs));
     } else {
         return t.ptr();
@@ -76,12 +75,12 @@ allocate::result_type allocate::operator()(const bind &n) {
             static_pointer_cast<const ctype::sequence_t>(pre_lhs.ctype().ptr());
        
         shared_ptr<const ctype::tuple_t> tuple_impl_seq_ct =
-            make_shared<const ctype::tuple_t>(
+            make_node<const ctype::tuple_t>(
                 make_vector<shared_ptr<const ctype::type_t> >(impl_seq_ct));
 
         shared_ptr<const type_t> result_t =
             pre_lhs.type().ptr();
-        shared_ptr<const name> result_name = make_shared<const name>(
+        shared_ptr<const name> result_name = make_node<const name>(
             detail::wrap_array_id(pre_lhs.id()),
             result_t,
             containerized);
@@ -107,17 +106,17 @@ allocate::result_type allocate::operator()(const bind &n) {
                         boost::get<const name&>(*get_args.begin());
                     
                     shared_ptr<const name> cont_tuple_name =
-                        make_shared<const name>(
+                        make_node<const name>(
                             detail::wrap_array_id(view_tuple_name.id()));
-                    new_rhs = make_shared<const apply>(
+                    new_rhs = make_node<const apply>(
                         rhs.fn().ptr(),
-                        make_shared<const tuple>(
+                        make_node<const tuple>(
                             make_vector<shared_ptr<const expression> >(
                                 cont_tuple_name)));
                 }
             }
         } 
-        shared_ptr<const bind> allocator = make_shared<const bind>(
+        shared_ptr<const bind> allocator = make_node<const bind>(
             result_name, new_rhs);
         vector<shared_ptr<const statement> > stmts;
         stmts.push_back(allocator);
@@ -126,23 +125,23 @@ allocate::result_type allocate::operator()(const bind &n) {
         shared_ptr<const name> new_lhs = static_pointer_cast<const name>(
             boost::apply_visitor(*this, n.lhs()));
         shared_ptr<const templated_name> getter_name =
-            make_shared<const templated_name>(
+            make_node<const templated_name>(
                 detail::make_sequence(),
                 tuple_impl_seq_ct);
         shared_ptr<const tuple> getter_args =
-            make_shared<const tuple>(
+            make_node<const tuple>(
                 make_vector<shared_ptr<const expression> >(result_name)
-                (make_shared<const apply>(
-                    make_shared<const name>(copperhead::to_string(m_target)),
-                    make_shared<const tuple>(make_vector<shared_ptr<const expression> >())))
-                (make_shared<const literal>("true")));
+                (make_node<const apply>(
+                    make_node<const name>(copperhead::to_string(m_target)),
+                    make_node<const tuple>(make_vector<shared_ptr<const expression> >())))
+                (make_node<const literal>("true")));
         shared_ptr<const apply> getter_call =
-            make_shared<const apply>(getter_name, getter_args);
+            make_node<const apply>(getter_name, getter_args);
         shared_ptr<const bind> retriever =
-            make_shared<const bind>(new_lhs, getter_call);
+            make_node<const bind>(new_lhs, getter_call);
         stmts.push_back(retriever);
 
-        return make_shared<const suite>(move(stmts));
+        return make_node<const suite>(move(stmts));
         
     } else {
         return this->rewriter<allocate>::operator()(n);
@@ -0,0 +1,128 @@
+#include "arena.hpp"
+#include <cstdlib>
+#include <algorithm>
+
+namespace backend {
+
+namespace detail {
+
+static __thread arena_binding t_binding;
+
+ast_arena* current_arena() {
+    return t_binding.m_arena;
+}
+
+const std::shared_ptr<ast_arena>* current_owner() {
+    return t_binding.m_owner;
+}
+
+//Carves an object out of the part of a block a binding holds, or
+//returns null if it doesn't fit
+static inline void* carve(arena_binding& b,
+                          std::size_t bytes, std::size_t alignment) {
+    std::size_t padding =
+        (alignment - (std::size_t(b.m_current) % alignment)) % alignment;
+    if (b.m_current == nullptr || padding + bytes > b.m_remaining) {
+        return nullptr;
+    }
+    char* result = b.m_current + padding;
+    b.m_current = result + bytes;
+    b.m_remaining -= padding + bytes;
+    b.m_allocated += bytes;
+    return result;
+}
+
+static char* new_block(std::vector<char*>& blocks, std::size_t size) {
+    //malloc'd blocks are suitably aligned for any object
+    char* block = static_cast<char*>(std::malloc(size));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    blocks.push_back(block);
+    return block;
+}
+
+}
+
+ast_arena::ast_arena(std::size_t block_size)
+    : m_unbound(), m_block_size(block_size), m_allocated(0) {}
+
+ast_arena::~ast_arena() {
+    for(auto i = m_blocks.begin(); i != m_blocks.end(); i++) {
+        std::free(*i);
+    }
+}
+
+void* ast_arena::allocate(std::size_t bytes, std::size_t alignment) {
+    detail::arena_binding& b = detail::t_binding;
+    if (b.m_arena == this) {
+        void* result = detail::carve(b, bytes, alignment);
+        if (result) {
+            return result;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return refill(b, bytes, alignment);
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    void* result = detail::carve(m_unbound, bytes, alignment);
+    return result ? result : refill(m_unbound, bytes, alignment);
+}
+
+void* ast_arena::refill(detail::arena_binding& b,
+                        std::size_t bytes, std::size_t alignment) {
+    m_allocated += b.m_allocated;
+    b.m_allocated = 0;
+    if (bytes > m_block_size) {
+        //Oversized requests don't disturb the current block
+        m_allocated += bytes;
+        return detail::new_block(m_blocks, bytes);
+    }
+    if (!m_spare.empty()) {
+        b.m_current = m_spare.back().first;
+        b.m_remaining = m_spare.back().second;
+        m_spare.pop_back();
+        void* result = detail::carve(b, bytes, alignment);
+        if (result) {
+            return result;
+        }
+    }
+    b.m_current = detail::new_block(m_blocks, m_block_size);
+    b.m_remaining = m_block_size;
+    return detail::carve(b, bytes, alignment);
+}
+
+void ast_arena::release(detail::arena_binding& b) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_allocated += b.m_allocated;
+    if (b.m_remaining > 0) {
+        m_spare.push_back(std::make_pair(b.m_current, b.m_remaining));
+    }
+}
+
+std::size_t ast_arena::allocated() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocated + m_unbound.m_allocated;
+}
+
+std::size_t ast_arena::blocks() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_blocks.size();
+}
+
+arena_scope::arena_scope(ast_arena* a)
+    : m_previous(detail::t_binding) {
+    if (a) {
+        m_owner = a->shared_from_this();
+    }
+    detail::arena_binding b = {a, a ? &m_owner : nullptr, nullptr, 0, 0};
+    detail::t_binding = b;
+}
+
+arena_scope::~arena_scope() {
+    if (m_owner) {
+        m_owner->release(detail::t_binding);
+    }
+    detail::t_binding = m_previous;
+}
+
+}
@@ -1,7 +1,6 @@
 #include "backend_translate.hpp"
 
 using std::string;
-using std::make_shared;
 using std::make_pair;
 
 namespace backend {
@@ -14,9 +13,9 @@ backend_translate::backend_translate() {
 backend_translate::result_type backend_translate::operator()(const name& n) {
     auto it = m_table.find(n.id());
     if (it != m_table.end()) {
-        return make_shared<const name>(it->second,
-                                       n.type().ptr(),
-                                       n.ctype().ptr());
+        return make_node<const name>(it->second,
+                                     n.type().ptr(),
+                                     n.ctype().ptr());
     }
     return n.ptr();
 }
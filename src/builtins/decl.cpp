@@ -117,7 +117,7 @@ vector<named_info> cpp_support_fns =
 }
 
 void load_scalars(
-    std::map<ident, fn_info>& fns,
+    fn_map& fns,
     const vector<named_info>& names) {
     for(auto i = names.begin();
         i != names.end();
@@ -135,7 +135,7 @@ void load_scalars(
 
 
 shared_ptr<library> get_builtins() {
-    map<ident, fn_info> fns;
+    fn_map fns;
     builtins::load_scalars(fns, builtins::detail::unary_math_operators);
     builtins::load_scalars(fns, builtins::detail::unary_scalar_operators);
     builtins::load_scalars(fns, builtins::detail::binary_scalar_operators);
@@ -148,7 +148,15 @@ shared_ptr<library> get_builtins() {
     }
     string include(PRELUDE_FILE);
     shared_ptr<library> l(new library(move(fns),
-                                      make_map<string, string>(),
+                                      make_map<string, string>(
+                                          "make_frame",
+                                          "prelude/runtime/frame.hpp")(
+                                          "join",
+                                          "prelude/runtime/task.hpp")(
+                                          "spawn",
+                                          "prelude/runtime/task.hpp")(
+                                          "batch",
+                                          "prelude/runtime/batch.hpp"),
                                       make_set<string>(include),
                                       move(include_paths)));
     return l;
@@ -0,0 +1,169 @@
+#include "compile_cache.hpp"
+#include "structural_hash.hpp"
+#include "import/paths.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace backend {
+
+namespace detail {
+
+//The build defines COPPERHEAD_SOURCE_DIGEST as a digest of the
+//compiler's sources, so that entries written by a compiler whose code
+//generation differs are never returned.  Bump the version whenever
+//code generation changes, for builds which do not define the digest.
+#define COPPERHEAD_STRINGIFY(x) #x
+#define COPPERHEAD_STRING(x) COPPERHEAD_STRINGIFY(x)
+#ifdef COPPERHEAD_SOURCE_DIGEST
+const char* cache_version =
+    "copperhead-cache-3-" COPPERHEAD_STRING(COPPERHEAD_SOURCE_DIGEST);
+#else
+const char* cache_version = "copperhead-cache-3";
+#endif
+
+//Creates a directory and its parents, like mkdir -p
+bool make_directories(const std::string& dir) {
+    for(size_t i = 1; i <= dir.size(); i++) {
+        if (i == dir.size() || dir[i] == '/') {
+            std::string prefix = dir.substr(0, i);
+            if ((mkdir(prefix.c_str(), 0755) != 0) && (errno != EEXIST)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//Reads a whole file
+bool read_file(const std::string& path, std::string& contents) {
+    std::ifstream f(path.c_str(), std::ios::binary);
+    if (!f) {
+        return false;
+    }
+    std::ostringstream os;
+    os << f.rdbuf();
+    if (f.bad()) {
+        return false;
+    }
+    contents = os.str();
+    return true;
+}
+
+//Writes a file through a uniquely named temporary file in the same
+//directory, which is renamed into place once complete
+bool write_file(const std::string& destination, const std::string& contents) {
+    std::string tmp = destination + ".XXXXXX";
+    int fd = mkstemp(&tmp[0]);
+    if (fd < 0) {
+        return false;
+    }
+    //mkstemp creates files only their owner may read
+    fchmod(fd, 0644);
+    const char* p = contents.data();
+    size_t remaining = contents.size();
+    while(remaining > 0) {
+        ssize_t written = write(fd, p, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        p += written;
+        remaining -= written;
+    }
+    if ((close(fd) != 0) || (remaining > 0) ||
+        (std::rename(tmp.c_str(), destination.c_str()) != 0)) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
+
+compile_cache::compile_cache(const std::string& dir)
+    : m_dir(dir) {}
+
+std::string compile_cache::default_dir() {
+    std::string dir = detail::get_path("COPPERHEAD_CACHE_DIR");
+    if (!dir.empty()) {
+        return dir;
+    }
+    return std::string(detail::get_path("HOME")) + "/.copperhead/cache";
+}
+
+std::string compile_cache::canonical(const suite& n,
+                                     const std::string& entry_point,
+                                     const copperhead::system_variant& t) const {
+    std::string result;
+    structural_hasher h(t, &result);
+    h(std::string(detail::cache_version));
+    h(entry_point);
+    h(copperhead::to_string(t));
+    h(n);
+    return result;
+}
+
+std::string compile_cache::key(const std::string& canonical) const {
+    //The tag only matters when hashing types
+    copperhead::system_variant t = copperhead::cpp_tag();
+    structural_hasher h(t);
+    h(canonical);
+    std::ostringstream os;
+    os << std::hex << std::setw(16) << std::setfill('0') << h.value();
+    return os.str();
+}
+
+std::string compile_cache::key(const suite& n,
+                               const std::string& entry_point,
+                               const copperhead::system_variant& t) const {
+    return key(canonical(n, entry_point, t));
+}
+
+std::string compile_cache::path(const std::string& key,
+                                const std::string& suffix) const {
+    return m_dir + "/" + key + suffix;
+}
+
+bool compile_cache::lookup(const std::string& canonical,
+                           const std::string& suffix,
+                           std::string& contents) const {
+    std::string k = key(canonical);
+    std::string owner;
+    if (!detail::read_file(path(k, ".key"), owner) || (owner != canonical)) {
+        return false;
+    }
+    return detail::read_file(path(k, suffix), contents);
+}
+
+bool compile_cache::store(const std::string& canonical,
+                          const std::string& suffix,
+                          const std::string& contents) const {
+    if (!detail::make_directories(m_dir)) {
+        return false;
+    }
+    std::string k = key(canonical);
+    std::string owner;
+    if (detail::read_file(path(k, ".key"), owner)) {
+        if (owner != canonical) {
+            return false;
+        }
+    } else if (!detail::write_file(path(k, ".key"), canonical)) {
+        return false;
+    }
+    return detail::write_file(path(k, suffix), contents);
+}
+
+const std::string& compile_cache::dir() const {
+    return m_dir;
+}
+
+}
@@ -3,6 +3,11 @@
  */
 #include "compiler.hpp"
 #include <typeinfo>
+#include <sstream>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <type_traits>
+#include "utility/isinstance.hpp"
 
 #ifndef TRACE
 #define TRACE false
@@ -11,7 +16,21 @@
 namespace backend {
 compiler::compiler(const std::string& entry_point,
                    const copperhead::system_variant& backend_tag)
-    : m_entry_point(entry_point), m_backend_tag(backend_tag), m_registry(){
+    : m_entry_point(entry_point), m_backend_tag(backend_tag), m_registry(),
+      m_profiling(getenv("COPPERHEAD_PROFILE_PASSES") != nullptr),
+      m_hash_consing(getenv("COPPERHEAD_HASH_CONS") != nullptr),
+      m_arena(getenv("COPPERHEAD_AST_ARENA") != nullptr),
+      m_incremental(getenv("COPPERHEAD_INCREMENTAL") != nullptr),
+      m_memory_plan(getenv("COPPERHEAD_MEMORY_PLAN") != nullptr),
+      m_task_graph(getenv("COPPERHEAD_TASK_GRAPH") != nullptr),
+      m_async(getenv("COPPERHEAD_ASYNC") != nullptr),
+      m_batch(getenv("COPPERHEAD_BATCH") != nullptr) {
+    if (getenv("COPPERHEAD_CACHE_DIR") != nullptr) {
+        m_cache = std::make_shared<compile_cache>();
+    }
+    if (getenv("COPPERHEAD_PARALLEL_PASSES") != nullptr) {
+        set_parallel(true, atoi(getenv("COPPERHEAD_PARALLEL_PASSES")));
+    }
     std::shared_ptr<library> thrust = get_thrust();
     m_registry.add_library(thrust);
     std::shared_ptr<library> prelude = get_builtins();
@@ -21,6 +40,96 @@ compiler::compiler(const std::string& entry_point,
 
 namespace detail {
 
+template<typename T>
+std::string pass_name(const T& pass) {
+    int status;
+    char* demangled = abi::__cxa_demangle(typeid(pass).name(), 0, 0, &status);
+    if (demangled == nullptr) {
+        return typeid(pass).name();
+    }
+    std::string result(demangled);
+    std::free(demangled);
+    return result;
+}
+
+//Passes which rewrite each procedure without reference to any other
+//procedure, and which keep no state from one procedure to the next.
+//These may be run on the procedures of a suite concurrently.
+//Passes which gather information across procedures, like
+//phase_analyze, functorize, find_includes and prune, must not be
+//listed here.
+template<typename Pass>
+struct procedure_local : std::false_type {};
+
+template<> struct procedure_local<backend::backend_translate> : std::true_type {};
+template<> struct procedure_local<backend::tuple_break> : std::true_type {};
+template<> struct procedure_local<backend::iterizer> : std::true_type {};
+template<> struct procedure_local<backend::fuse> : std::true_type {};
+template<> struct procedure_local<backend::type_convert> : std::true_type {};
+template<> struct procedure_local<backend::fuse_reductions> : std::true_type {};
+template<> struct procedure_local<backend::thrust_rewriter> : std::true_type {};
+template<> struct procedure_local<backend::dereference> : std::true_type {};
+template<> struct procedure_local<backend::allocate> : std::true_type {};
+template<> struct procedure_local<backend::wrap> : std::true_type {};
+template<> struct procedure_local<backend::containerize> : std::true_type {};
+template<> struct procedure_local<backend::recycle> : std::true_type {};
+template<> struct procedure_local<backend::plan_memory> : std::true_type {};
+template<> struct procedure_local<backend::schedule> : std::true_type {};
+template<> struct procedure_local<backend::typedefify> : std::true_type {};
+
+template<typename Pass>
+std::shared_ptr<const suite> run_pass(Pass& pass,
+                                      const suite& n,
+                                      thread_pool*,
+                                      std::false_type) {
+    return std::static_pointer_cast<const suite>(
+        boost::apply_visitor(pass, n));
+}
+
+template<typename Pass>
+std::shared_ptr<const suite> run_pass(Pass& pass,
+                                      const suite& n,
+                                      thread_pool* tp,
+                                      std::true_type) {
+    std::vector<std::shared_ptr<const statement> > stmts;
+    for(auto i = n.begin(); i != n.end(); i++) {
+        stmts.push_back(i->ptr());
+    }
+    if (!tp || stmts.size() < 2) {
+        return run_pass(pass, n, tp, std::false_type());
+    }
+    std::vector<std::shared_ptr<const node> > results(stmts.size());
+    ast_arena* arena = detail::current_arena();
+    tp->for_each(stmts.size(), [&](std::size_t i) {
+            arena_scope scope(arena);
+            //Each procedure gets a pristine copy of the pass, as it
+            //would see it if it were the first procedure in the suite
+            Pass local(pass);
+            results[i] = boost::apply_visitor(local, *stmts[i]);
+        });
+    //Reassemble the suite as rewriter<>::operator()(const suite&)
+    //would, splicing in any statement rewritten to a suite
+    bool match = true;
+    std::vector<std::shared_ptr<const statement> > n_stmts;
+    for(std::size_t i = 0; i < stmts.size(); i++) {
+        if (detail::isinstance<suite>(*results[i])) {
+            match = false;
+            const suite& nested = boost::get<const suite&>(*results[i]);
+            for(auto j = nested.begin(); j != nested.end(); j++) {
+                n_stmts.push_back(j->ptr());
+            }
+        } else {
+            match = match && (results[i] == stmts[i]);
+            n_stmts.push_back(
+                std::static_pointer_cast<const statement>(results[i]));
+        }
+    }
+    if (match) {
+        return n.ptr();
+    }
+    return make_node<const suite>(std::move(n_stmts));
+}
+
 template<int N, bool D=false>
 struct pipeline_helper {
     typedef std::shared_ptr<const suite> result_type;
@@ -28,18 +137,30 @@ struct pipeline_helper {
     static inline result_type impl(
         Tuple& t,
         const result_type& i,
-        cpp_printer& cp) {
+        cpp_printer& cp,
+        pass_profiler* pp,
+        hash_cons* hc,
+        thread_pool* tp) {
+        auto& pass = std::get<std::tuple_size<Tuple>::value-N>(t);
+        typedef typename std::remove_reference<decltype(pass)>::type pass_t;
+        if (pp) {
+            pp->start(pass_name(pass), *i);
+        }
         result_type rewritten =
-            std::static_pointer_cast<const suite>(
-                boost::apply_visitor(
-                    std::get<std::tuple_size<Tuple>::value-N>(t),
-                    *i));
+            run_pass(pass, *i, tp, procedure_local<pass_t>());
+        if (pp) {
+            pp->finish(*rewritten);
+        }
+        if (hc) {
+            rewritten = std::static_pointer_cast<const suite>(
+                (*hc)(*rewritten));
+        }
         if (D) {
             std::cout << "After " <<
                 typeid(std::get<std::tuple_size<Tuple>::value-N>(t)).name() << std::endl;
             boost::apply_visitor(cp, *rewritten);
         }
-        return pipeline_helper<N-1, D>::impl(t, rewritten, cp);
+        return pipeline_helper<N-1, D>::impl(t, rewritten, cp, pp, hc, tp);
     }        
 };
 
@@ -50,7 +171,10 @@ struct pipeline_helper<0, D> {
     static inline result_type impl(
         const Tuple& t,
         const result_type& i,
-        const cpp_printer&) {
+        const cpp_printer&,
+        pass_profiler*,
+        hash_cons*,
+        thread_pool*) {
         return i;
     }        
 };
@@ -60,35 +184,202 @@ struct pipeline_helper<0, D> {
 template<class Tuple>
 static inline std::shared_ptr<const suite> apply(Tuple& t,
                                    const suite& n,
-                                   cpp_printer& cp) {
+                                   cpp_printer& cp,
+                                   pass_profiler* pp,
+                                   hash_cons* hc,
+                                   thread_pool* tp) {
+    std::shared_ptr<const suite> input = n.ptr();
+    if (hc) {
+        input = std::static_pointer_cast<const suite>((*hc)(n));
+    }
     return detail::
         pipeline_helper<std::tuple_size<Tuple>::value,
                         TRACE>::
-        impl(t, n.ptr(), cp);
+        impl(t, input, cp, pp, hc, tp);
+}
+
+namespace detail {
+
+//Splits a lowered suite into one fragment per procedure of the
+//suite it was lowered from.  Each fragment begins with the lowered
+//procedure, followed by the statements generated after it, such as
+//its functor structure.  Returns false if the lowered suite isn't
+//laid out that way.
+bool split_fragments(const suite& lowered,
+                     const suite& input,
+                     std::vector<procedure_cache::fragment>& fragments) {
+    auto next = input.begin();
+    for(auto i = lowered.begin(); i != lowered.end(); i++) {
+        if ((next != input.end()) &&
+            detail::isinstance<procedure>(*i) &&
+            (boost::get<const procedure&>(*i).id().sym() ==
+             boost::get<const procedure&>(*next).id().sym())) {
+            fragments.push_back(procedure_cache::fragment());
+            next++;
+        }
+        if (fragments.empty()) {
+            return false;
+        }
+        fragments.back().push_back(i->ptr());
+    }
+    return next == input.end();
+}
+
+}
+
+//Lowers only the procedures which have no fragment in the cache,
+//along with their callees, and splices the rest in from the cache
+template<class Tuple>
+static std::shared_ptr<const suite> apply_incremental(
+    Tuple& t,
+    const suite& n,
+    procedure_cache& c,
+    const copperhead::system_variant& target,
+    cpp_printer& cp,
+    pass_profiler* pp,
+    hash_cons* hc,
+    thread_pool* tp) {
+    for(auto i = n.begin(); i != n.end(); i++) {
+        if (!detail::isinstance<procedure>(*i)) {
+            return apply(t, n, cp, pp, hc, tp);
+        }
+    }
+    std::vector<std::vector<std::size_t> > callees = transitive_callees(n);
+    std::vector<std::uint64_t> keys = procedure_cache::keys(n, callees, target);
+    std::vector<procedure_cache::fragment> fragments(keys.size());
+    //Procedures are lowered in the context of their callees, so
+    //those must be lowered again too
+    std::vector<bool> needed(keys.size(), false);
+    for(std::size_t i = 0; i < keys.size(); i++) {
+        if (!c.lookup(keys[i], fragments[i])) {
+            needed[i] = true;
+            for(auto j = callees[i].begin(); j != callees[i].end(); j++) {
+                needed[*j] = true;
+            }
+        }
+    }
+    std::vector<std::shared_ptr<const statement> > sub_stmts;
+    std::vector<std::size_t> positions;
+    std::size_t position = 0;
+    for(auto i = n.begin(); i != n.end(); i++, position++) {
+        if (needed[position]) {
+            sub_stmts.push_back(i->ptr());
+            positions.push_back(position);
+        }
+    }
+    if (!positions.empty()) {
+        std::shared_ptr<const suite> sub =
+            make_node<const suite>(std::move(sub_stmts));
+        std::shared_ptr<const suite> lowered =
+            apply(t, *sub, cp, pp, hc, tp);
+        std::vector<procedure_cache::fragment> sub_fragments;
+        if (!detail::split_fragments(*lowered, *sub, sub_fragments)) {
+            //Nothing can be remembered, so lower the whole suite
+            return (sub->size() == n.size()) ?
+                lowered : apply(t, n, cp, pp, hc, tp);
+        }
+        for(std::size_t i = 0; i < positions.size(); i++) {
+            fragments[positions[i]] = sub_fragments[i];
+            c.store(keys[positions[i]], sub_fragments[i]);
+        }
+    }
+    std::vector<std::shared_ptr<const statement> > stmts;
+    for(auto i = fragments.begin(); i != fragments.end(); i++) {
+        stmts.insert(stmts.end(), i->begin(), i->end());
+    }
+    return make_node<const suite>(std::move(stmts));
 }
 
 
 std::shared_ptr<const suite> compiler::operator()(const suite &n) {
+    //Nodes allocated from the arena keep it alive, so it's safe
+    //to let go of it once compilation is done.  Remembered procedures
+    //would keep every arena they touched alive, so incremental
+    //compilations allocate from the heap.
+    std::shared_ptr<ast_arena> arena;
+    if (m_arena && !m_incremental) {
+        arena = std::make_shared<ast_arena>();
+    }
+    arena_scope scope(arena.get());
     //Defines the compiler pipeline
     //Passes will be processed sequentially, with outputs chained to inputs
-    auto passes = std::make_tuple(
+    //These passes lower each procedure to C++
+    auto lowering = std::make_tuple(
         backend_translate(),
+        segment(),
         tuple_break(),
         iterizer(),
         phase_analyze(m_entry_point, m_registry),
+        fuse(),
         type_convert(),
         functorize(m_entry_point, m_registry),
+        fuse_reductions(m_entry_point),
         thrust_rewriter(m_backend_tag),
         dereference(m_entry_point),
         allocate(m_backend_tag, m_entry_point),
-        wrap(m_backend_tag, m_entry_point),
+        wrap(m_backend_tag, m_entry_point, m_async, m_batch),
         containerize(m_entry_point),
-        typedefify(),
+        recycle(m_entry_point),
+        plan_memory(m_backend_tag, m_entry_point, m_memory_plan),
+        schedule(m_entry_point, m_task_graph),
+        typedefify());
+    //These passes finish the program as a whole
+    auto finishing = std::make_tuple(
         find_includes(m_registry),
         prune());
 
     cpp_printer cp(m_backend_tag, m_entry_point, m_registry, std::cout);
-    auto result = apply(passes, n, cp);
+    pass_profiler pp;
+    hash_cons hc;
+    pass_profiler* ppp = m_profiling ? &pp : nullptr;
+    hash_cons* hcp = m_hash_consing ? &hc : nullptr;
+    std::shared_ptr<const suite> lowered;
+    if (m_incremental) {
+        lowered = apply_incremental(lowering, n, m_procedures, m_backend_tag,
+                                    cp, ppp, hcp, m_pool.get());
+    } else {
+        lowered = apply(lowering, n, cp, ppp, hcp, m_pool.get());
+    }
+    auto result = apply(finishing, *lowered, cp, ppp, hcp, m_pool.get());
+    m_profiles = pp.profiles();
+    if (m_profiling && getenv("COPPERHEAD_PROFILE_PASSES") != nullptr) {
+        print_profiles(std::cerr, m_profiles);
+    }
+    return result;
+}
+
+std::string compiler::code(const suite &n) {
+    std::string canonical;
+    std::string result;
+    //Options which change the generated code are part of the suffix
+    std::string suffix;
+    if (m_memory_plan) {
+        suffix += ".planned";
+    }
+    if (m_task_graph) {
+        suffix += ".tasks";
+    }
+    if (m_async) {
+        suffix += ".async";
+    }
+    if (m_batch) {
+        suffix += ".batch";
+    }
+    suffix += ".cpp";
+    if (m_cache) {
+        canonical = m_cache->canonical(n, m_entry_point, m_backend_tag);
+        if (m_cache->lookup(canonical, suffix, result)) {
+            return result;
+        }
+    }
+    std::shared_ptr<const suite> compiled = (*this)(n);
+    std::ostringstream os;
+    cpp_printer cp(m_backend_tag, m_entry_point, m_registry, os);
+    boost::apply_visitor(cp, *compiled);
+    result = os.str();
+    if (m_cache) {
+        m_cache->store(canonical, suffix, result);
+    }
     return result;
 }
 
@@ -103,4 +394,79 @@ const copperhead::system_variant& compiler::target() const {
     return m_backend_tag;
 }
 
+void compiler::set_profiling(bool p) {
+    m_profiling = p;
+}
+
+const std::vector<pass_profile>& compiler::profiles() const {
+    return m_profiles;
+}
+
+void compiler::set_hash_consing(bool h) {
+    m_hash_consing = h;
+}
+
+void compiler::set_arena(bool a) {
+    m_arena = a;
+}
+
+void compiler::set_parallel(bool p, std::size_t threads) {
+    if (p) {
+        m_pool = std::make_shared<thread_pool>(threads);
+    } else {
+        m_pool.reset();
+    }
+}
+
+void compiler::set_incremental(bool i) {
+    m_incremental = i;
+    if (!i) {
+        m_procedures.clear();
+    }
+}
+
+void compiler::set_memory_plan(bool m) {
+    if (m != m_memory_plan) {
+        //Remembered entry points were lowered under the old setting
+        m_procedures.clear();
+    }
+    m_memory_plan = m;
+}
+
+void compiler::set_task_graph(bool t) {
+    if (t != m_task_graph) {
+        //Remembered entry points were lowered under the old setting
+        m_procedures.clear();
+    }
+    m_task_graph = t;
+}
+
+void compiler::set_async(bool a) {
+    if (a != m_async) {
+        //Remembered entry points were lowered under the old setting
+        m_procedures.clear();
+    }
+    m_async = a;
+}
+
+void compiler::set_batch(bool b) {
+    if (b != m_batch) {
+        //Remembered entry points were lowered under the old setting
+        m_procedures.clear();
+    }
+    m_batch = b;
+}
+
+const procedure_cache& compiler::procedures() const {
+    return m_procedures;
+}
+
+void compiler::set_cache(const std::shared_ptr<compile_cache>& c) {
+    m_cache = c;
+}
+
+const std::shared_ptr<compile_cache>& compiler::cache() const {
+    return m_cache;
+}
+
 }
@@ -20,7 +20,6 @@
 
 using std::string;
 using std::shared_ptr;
-using std::make_shared;
 using std::static_pointer_cast;
 using backend::utility::make_vector;
 using std::vector;
@@ -34,7 +33,7 @@ containerize::containerize(const string& entry_point) : m_entry_point(entry_poin
 
 
 containerize::result_type containerize::operator()(const name &n) {
-    m_decl_containers.insert(n.id());
+    m_decl_containers.insert(n.sym());
     return n.ptr();
 }
 
@@ -50,7 +49,7 @@ shared_ptr<const expression> containerize::container_args(const expression& t) {
     if (detail::isinstance<name>(t)) {
         if (detail::container_type(t.ctype()) != t.ctype().ptr()) {
             const name& n = boost::get<const name&>(t);
-            return make_shared<const name>(
+            return make_node<const name>(
                 detail::wrap_array_id(n.id()),
                 n.type().ptr(),
                 n.ctype().ptr());
@@ -67,7 +66,7 @@ shared_ptr<const expression> containerize::container_args(const expression& t) {
         if (match) {
             return t.ptr();
         }
-        return make_shared<const tuple>(
+        return make_node<const tuple>(
             move(sub_exprs),
             t.type().ptr(),
             t.ctype().ptr());
@@ -88,21 +87,21 @@ containerize::result_type containerize::reassign(const bind &n) {
         return n.ptr();
     }
     shared_ptr<const name> lhs_cont =
-        make_shared<const name>(
+        make_node<const name>(
             detail::wrap_array_id(lhs.id()),
             lhs.type().ptr(),
             detail::container_type(lhs.ctype()));
     shared_ptr<const name> rhs_cont =
-        make_shared<const name>(
+        make_node<const name>(
             detail::wrap_array_id(rhs.id()),
             rhs.type().ptr(),
             detail::container_type(rhs.ctype()));
     vector<shared_ptr<const statement> > stmts;
     stmts.push_back(
-        make_shared<const bind>(
+        make_node<const bind>(
             lhs_cont, rhs_cont));
     stmts.push_back(n.ptr());
-    return make_shared<const suite>(move(stmts));
+    return make_node<const suite>(move(stmts));
            
 }
 
@@ -140,7 +139,7 @@ containerize::result_type containerize::operator()(const bind &n) {
             
             
         shared_ptr<const ctype::type_t> cont_type = detail::container_type(
-            *make_shared<const ctype::tuple_t>(move(arg_c_types)));
+            *make_node<const ctype::tuple_t>(move(arg_c_types)));
         //If the container is the same as the ctype, no - because this
         //means that no containers were necessary for the original
         //e.g. a tuple of scalars
@@ -176,22 +175,22 @@ containerize::result_type containerize::operator()(const bind &n) {
         assert(detail::isinstance<name>(n.lhs()));
         const name& lhs = boost::get<const name&>(n.lhs());
         shared_ptr<const name> new_lhs =
-            make_shared<const name>(
+            make_node<const name>(
                 detail::wrap_array_id(
                     lhs.id()),
                 lhs.type().ptr(),
                 cont_type);
         shared_ptr<const apply> new_rhs =
-            make_shared<const apply>(
+            make_node<const apply>(
                 apply_fn.ptr(),
                 cont_args.ptr());
 
         //Add new container to declared containers
-        m_decl_containers.insert(new_lhs->id());
+        m_decl_containers.insert(new_lhs->sym());
         
-        return make_shared<const suite>(
+        return make_node<const suite>(
             make_vector<shared_ptr<const statement> >(n.ptr())
-            (make_shared<const bind>(
+            (make_node<const bind>(
                 new_lhs,
                 new_rhs)));
     }
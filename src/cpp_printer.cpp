@@ -18,7 +18,7 @@ cpp_printer::cpp_printer(
       tp(t, os),
       m_in_rhs(false),
       m_in_struct(false) {
-    const std::map<ident, fn_info>& fns = globals.fns();
+    const fn_map& fns = globals.fns();
     for(auto i = fns.cbegin();
         i != fns.cend();
         i++) {
@@ -30,10 +30,10 @@ cpp_printer::cpp_printer(
     
 
 void cpp_printer::operator()(const backend::name &n) {
-    if ((!declared.exists(n.id())) && !m_in_rhs) {
+    if ((!declared.exists(n.sym())) && !m_in_rhs) {
         boost::apply_visitor(tp, n.ctype());
         m_os << " ";
-        declared.insert(n.id());
+        declared.insert(n.sym());
     }
     m_os << n.id();
 }
@@ -142,9 +142,11 @@ void cpp_printer::operator()(const bind &n) {
     m_in_rhs = false;
 }
 void cpp_printer::operator()(const call &n) {
-    const literal& fn = n.sub().fn();
-    this->cpp_printer::operator()(fn);
-    boost::apply_visitor(*this, n.sub().args());
+    //Neither the function nor its arguments are declared here, and
+    //the function may be templated
+    m_in_rhs = true;
+    (*this)(n.sub());
+    m_in_rhs = false;
     m_os << ";";
 }
 void cpp_printer::print_proc_return(const ctype::monotype_t& mt,
@@ -19,7 +19,6 @@
 
 using std::string;
 using std::shared_ptr;
-using std::make_shared;
 using backend::utility::make_vector;
 
 namespace backend {
@@ -35,9 +34,9 @@ dereference::result_type dereference::operator()(const subscript &s) {
     if (!m_in_entry) {
         return s.ptr();
     } else {
-        return make_shared<const apply>(
-            make_shared<const name>("dereference"),
-            make_shared<const tuple>(
+        return make_node<const apply>(
+            make_node<const name>("dereference"),
+            make_node<const tuple>(
                 make_vector<shared_ptr<const expression> >
                 (s.src().ptr())(s.idx().ptr())));
     }
@@ -37,9 +37,13 @@ shared_ptr<const literal> literal::ptr() const {
 name::name(const std::string &val,
            const std::shared_ptr<const type_t>& type,
            const std::shared_ptr<const ctype::type_t>& ctype)
-    : literal(*this, val, type, ctype)
+    : literal(*this, val, type, ctype), m_sym(val)
 {}
 
+const symbol& name::sym(void) const {
+    return m_sym;
+}
+
 shared_ptr<const name> name::ptr() const {
     return static_pointer_cast<const name>(this->shared_from_this());
 }
@@ -1,7 +1,6 @@
 #include "find_includes.hpp"
 
 using std::shared_ptr;
-using std::make_shared;
 using std::static_pointer_cast;
 using std::vector;
 using std::set;
@@ -29,8 +28,8 @@ find_includes::result_type find_includes::operator()(const suite& n) {
         i != m_includes.end();
         i++) {
         augmented_statements.push_back(
-            make_shared<include>(
-                make_shared<literal>(
+            make_node<include>(
+                make_node<literal>(
                     *i)));
     }
     for(auto i = n.begin();
@@ -38,7 +37,7 @@ find_includes::result_type find_includes::operator()(const suite& n) {
         i++) {
         augmented_statements.push_back(i->ptr());
     }
-    return make_shared<const suite>(move(augmented_statements));
+    return make_node<const suite>(move(augmented_statements));
 }
 
 find_includes::result_type find_includes::operator()(const apply& n) {
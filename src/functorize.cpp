@@ -1,7 +1,6 @@
 #include "functorize.hpp"
 
 using std::shared_ptr;
-using std::make_shared;
 using std::string;
 using std::static_pointer_cast;
 using std::vector;
@@ -68,14 +67,14 @@ shared_ptr<const expression> functorize::instantiate_fn(const name& n,
                                                         const type_t &t) {
     string id = n.id();
     //Function id must exist in type registry
-    assert(m_fns.find(id) != m_fns.end());
-    const type_t& n_t = *m_fns[id];
+    assert(m_fns.find(n.sym()) != m_fns.end());
+    const type_t& n_t = *m_fns[n.sym()];
     
     if (!detail::isinstance<polytype_t>(n_t)) {
         //The function is monomorphic. Instantiate a functor.
-        return make_shared<const apply>(
-            make_shared<const name>(detail::fnize_id(id)),
-            make_shared<const tuple>(
+        return make_node<const apply>(
+            make_node<const name>(detail::fnize_id(id)),
+            make_node<const tuple>(
                 make_vector<shared_ptr<const expression> >()));
     }
     type_map tm;
@@ -101,13 +100,13 @@ shared_ptr<const expression> functorize::instantiate_fn(const name& n,
         instantiated_ctypes.push_back(
             boost::apply_visitor(ctc, **i));
     }
-    return make_shared<const apply>(
-        make_shared<const templated_name>(
+    return make_node<const apply>(
+        make_node<const templated_name>(
             detail::fnize_id(id),
-            make_shared<const ctype::tuple_t>(move(instantiated_ctypes)),
+            make_node<const ctype::tuple_t>(move(instantiated_ctypes)),
             n.type().ptr(),
             n.ctype().ptr()),
-        make_shared<const tuple>(
+        make_node<const tuple>(
             make_vector<shared_ptr<const expression> >()));
 }
     
@@ -119,7 +118,7 @@ functorize::functorize(const string& entry_point,
         i != reg.fns().cend();
         i++) {
         auto id = i->first;
-        string fn_name = std::get<0>(id);
+        const symbol& fn_name = std::get<0>(id);
         std::shared_ptr<const type_t> fn_t = i->second.type().ptr();
         m_fns.insert(std::make_pair(fn_name, fn_t));
     }
@@ -159,7 +158,7 @@ functorize::result_type functorize::operator()(const apply &n) {
             //Can only close over function names
             assert(detail::isinstance<name>(n_closure.body()));
             const name& closed_fn = boost::get<const name&>(n_closure.body());
-            auto found = m_fns.find(closed_fn.id());
+            auto found = m_fns.find(closed_fn.sym());
             //Can only close over function names
             assert(found != m_fns.end());
 
@@ -192,23 +191,22 @@ functorize::result_type functorize::operator()(const apply &n) {
                     i->type().ptr());
             }
             shared_ptr<const fn_t> augmented_fn_t =
-                make_shared<const fn_t>(
-                    make_shared<const tuple_t>(
+                make_node<const fn_t>(
+                    make_node<const tuple_t>(
                         move(augmented_args_t)),
                     in_situ_fn_t.result().ptr());
             
             shared_ptr<const expression> instantiated_fn =
                 instantiate_fn(closed_fn, *augmented_fn_t);
             n_arg_list.push_back(
-                make_shared<const closure>(
+                make_node<const closure>(
                     n_closure.args().ptr(),
                     instantiated_fn,
                     n_closure.type().ptr(),
                     n_closure.ctype().ptr()));
         } else if (detail::isinstance<name>(*n_arg)) {
             const name& n_name = boost::get<const name&>(*n_arg);
-            const string id = n_name.id();
-            auto found = m_fns.find(id);
+            auto found = m_fns.find(n_name.sym());
             if (found == m_fns.end()) {
                 n_arg_list.push_back(
                     static_pointer_cast<const expression>(
@@ -227,8 +225,8 @@ functorize::result_type functorize::operator()(const apply &n) {
         }
     }
     auto n_fn = static_pointer_cast<const name>(this->rewriter::operator()(n.fn()));
-    auto new_args = shared_ptr<const tuple>(new tuple(move(n_arg_list)));
-    return shared_ptr<const apply>(new apply(n_fn, new_args));
+    auto new_args = make_node<const tuple>(move(n_arg_list));
+    return make_node<const apply>(n_fn, new_args);
 }
     
 functorize::result_type functorize::operator()(const suite &n) {
@@ -283,24 +281,24 @@ functorize::result_type functorize::operator()(const procedure &n) {
             static_pointer_cast<const tuple>(this->rewriter::operator()(n_proc->args()));
         shared_ptr<const name> forward_name =
             static_pointer_cast<const name>(this->rewriter::operator()(n_proc->id()));
-        shared_ptr<const apply> op_call(new apply(forward_name, forward_args));
-        shared_ptr<const ret> op_ret(new ret(op_call));
+        shared_ptr<const apply> op_call(make_node<const apply>(forward_name, forward_args));
+        shared_ptr<const ret> op_ret(make_node<const ret>(op_call));
         vector<shared_ptr<const statement> > op_body_stmts =
             make_vector<shared_ptr<const statement> >(op_ret);
-        shared_ptr<const suite> op_body(new suite(move(op_body_stmts)));
+        shared_ptr<const suite> op_body(make_node<const suite>(move(op_body_stmts)));
         auto op_args =
             static_pointer_cast<const tuple>(this->rewriter::operator()(n.args()));
-        shared_ptr<const name> op_id(new name(string("operator()")));
+        shared_ptr<const name> op_id(make_node<const name>(string("operator()")));
         shared_ptr<const procedure> op(
             new procedure(
                 op_id, op_args, op_body,
                 n.type().ptr(),
                 n.ctype().ptr()));
         shared_ptr<const suite> st_body =
-            make_shared<const suite>(
+            make_node<const suite>(
                 make_vector<shared_ptr<const statement> >(res_defn)(op));
         shared_ptr<const name> st_id =
-            make_shared<const name>(detail::fnize_id(n_proc->id().id()));
+            make_node<const name>(detail::fnize_id(n_proc->id().id()));
         shared_ptr<const structure> st;
         if (detail::isinstance<ctype::polytype_t>(n.ctype())) {
             const ctype::polytype_t& pt =
@@ -311,13 +309,13 @@ functorize::result_type functorize::operator()(const procedure &n) {
                 i++) {
                 typevars.push_back(i->ptr());
             }
-            st = make_shared<const structure>(st_id, st_body, move(typevars));
+            st = make_node<const structure>(st_id, st_body, move(typevars));
         } else {
-            st = make_shared<const structure>(st_id, st_body);
+            st = make_node<const structure>(st_id, st_body);
         }
         m_additionals.push_back(st);
         m_fns.insert(std::make_pair(
-                         n_proc->id().id(),
+                         n_proc->id().sym(),
                          n_proc->type().ptr()));
     }
     return n_proc;
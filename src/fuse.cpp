@@ -0,0 +1,156 @@
+#include "fuse.hpp"
+
+using std::shared_ptr;
+using std::static_pointer_cast;
+using std::vector;
+
+namespace backend {
+
+namespace detail {
+//Counts how many times each identifier is bound and used
+class use_counter
+    : public rewriter<use_counter> {
+private:
+    std::unordered_map<symbol, int>& m_uses;
+    std::unordered_map<symbol, int>& m_binds;
+    void bound(const expression& lhs) {
+        if (detail::isinstance<name>(lhs)) {
+            m_binds[boost::get<const name&>(lhs).sym()]++;
+        } else if (detail::isinstance<tuple>(lhs)) {
+            const tuple& t = boost::get<const tuple&>(lhs);
+            for(auto i = t.begin(); i != t.end(); i++) {
+                bound(*i);
+            }
+        }
+    }
+public:
+    use_counter(std::unordered_map<symbol, int>& uses,
+                std::unordered_map<symbol, int>& binds)
+        : m_uses(uses), m_binds(binds) {}
+    
+    using rewriter<use_counter>::operator();
+
+    result_type operator()(const procedure& n) {
+        bound(n.args());
+        boost::apply_visitor(*this, n.stmts());
+        return n.ptr();
+    }
+
+    result_type operator()(const bind& n) {
+        bound(n.lhs());
+        boost::apply_visitor(*this, n.rhs());
+        return n.ptr();
+    }
+
+    result_type operator()(const name& n) {
+        m_uses[n.sym()]++;
+        return n.ptr();
+    }
+};
+}
+
+fuse::fuse() {
+    //Primitives which only read their sequence arguments
+    //front to back through iterators
+    m_streaming.insert("reduce");
+    m_streaming.insert("sum");
+    m_streaming.insert("scan");
+    m_streaming.insert("rscan");
+    m_streaming.insert("exclusive_scan");
+    m_streaming.insert("exclusive_rscan");
+    m_streaming.insert("filter");
+    m_streaming.insert("scatter");
+    m_streaming.insert("permute");
+    m_streaming.insert("adjacent_difference");
+}
+
+bool fuse::fusible(const bind& boundary,
+                   suite::const_iterator consumers,
+                   suite::const_iterator end) {
+    if (!detail::isinstance<name>(boundary.lhs()) ||
+        !detail::isinstance<apply>(boundary.rhs())) {
+        return false;
+    }
+    const name& completed = boost::get<const name&>(boundary.lhs());
+    const apply& pb = boost::get<const apply&>(boundary.rhs());
+    if ((pb.fn().id() != detail::phase_boundary()) ||
+        (pb.args().arity() != 1) ||
+        !detail::isinstance<name>(*pb.args().begin())) {
+        return false;
+    }
+    const name& source = boost::get<const name&>(*pb.args().begin());
+    //The source must not be rebound, for example in a loop, or the
+    //consumer might see a different value than the boundary did
+    if ((m_uses[completed.sym()] != 1) ||
+        (m_binds[source.sym()] > 1)) {
+        return false;
+    }
+    //Find the only use of the completed sequence
+    for(auto i = consumers; i != end; i++) {
+        if (!detail::isinstance<bind>(*i)) {
+            continue;
+        }
+        const bind& b = boost::get<const bind&>(*i);
+        if (!detail::isinstance<apply>(b.rhs())) {
+            continue;
+        }
+        const apply& a = boost::get<const apply&>(b.rhs());
+        for(auto j = a.args().begin(); j != a.args().end(); j++) {
+            if (detail::isinstance<name>(*j) &&
+                (boost::get<const name&>(*j).sym() == completed.sym())) {
+                return m_streaming.find(a.fn().sym()) != m_streaming.end();
+            }
+        }
+    }
+    return false;
+}
+
+fuse::result_type fuse::operator()(const procedure& n) {
+    m_uses.clear();
+    m_binds.clear();
+    m_fused.clear();
+    detail::use_counter uc(m_uses, m_binds);
+    boost::apply_visitor(uc, n);
+    return this->rewriter<fuse>::operator()(n);
+}
+
+fuse::result_type fuse::operator()(const suite& n) {
+    bool match = true;
+    vector<shared_ptr<const statement> > stmts;
+    for(auto i = n.begin(); i != n.end(); i++) {
+        if (detail::isinstance<bind>(*i)) {
+            const bind& b = boost::get<const bind&>(*i);
+            auto next = i;
+            next++;
+            if (fusible(b, next, n.end())) {
+                const apply& pb = boost::get<const apply&>(b.rhs());
+                m_fused.insert(
+                    std::make_pair(
+                        boost::get<const name&>(b.lhs()).sym(),
+                        static_pointer_cast<const name>(
+                            pb.args().begin()->ptr())));
+                match = false;
+                continue;
+            }
+        }
+        shared_ptr<const statement> s =
+            static_pointer_cast<const statement>(
+                boost::apply_visitor(*this, *i));
+        match = match && (s == i->ptr());
+        stmts.push_back(s);
+    }
+    if (match) {
+        return n.ptr();
+    }
+    return make_node<const suite>(std::move(stmts));
+}
+
+fuse::result_type fuse::operator()(const name& n) {
+    auto i = m_fused.find(n.sym());
+    if (i != m_fused.end()) {
+        return i->second;
+    }
+    return n.ptr();
+}
+
+}
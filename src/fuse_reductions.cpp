@@ -0,0 +1,319 @@
+#include "fuse_reductions.hpp"
+#include "liveness.hpp"
+#include "utility/initializers.hpp"
+#include "utility/markers.hpp"
+#include <sstream>
+#include <algorithm>
+
+using std::shared_ptr;
+using std::static_pointer_cast;
+using std::vector;
+using std::string;
+using std::unordered_map;
+using std::unordered_set;
+using backend::utility::make_vector;
+
+namespace backend {
+
+namespace detail {
+//Finds sequences produced by maps, and the sequence each was
+//mapped over, which has the same length.  Only sequences bound
+//once are recorded, so the relation holds wherever they are read.
+class source_finder
+    : public rewriter<source_finder> {
+private:
+    unordered_map<symbol, int> m_binds;
+    unordered_map<symbol, symbol> m_sources;
+public:
+    using rewriter<source_finder>::operator();
+
+    result_type operator()(const procedure& n) {
+        for(auto i = n.args().begin(); i != n.args().end(); i++) {
+            if (detail::isinstance<name>(*i)) {
+                m_binds[boost::get<const name&>(*i).sym()]++;
+            }
+        }
+        return this->rewriter<source_finder>::operator()(n);
+    }
+    
+    result_type operator()(const bind& n) {
+        if (!detail::isinstance<name>(n.lhs())) {
+            return n.ptr();
+        }
+        const name& lhs = boost::get<const name&>(n.lhs());
+        m_binds[lhs.sym()]++;
+        if (detail::isinstance<apply>(n.rhs())) {
+            const apply& rhs = boost::get<const apply&>(n.rhs());
+            auto arg = rhs.args().begin();
+            if ((rhs.fn().id().substr(0, 3) == "map") &&
+                (rhs.args().arity() > 1) &&
+                detail::isinstance<name>(*(++arg))) {
+                m_sources.insert(
+                    std::make_pair(lhs.sym(),
+                                   boost::get<const name&>(*arg).sym()));
+            }
+        }
+        return n.ptr();
+    }
+
+    unordered_map<symbol, symbol> sources() const {
+        unordered_map<symbol, symbol> result;
+        for(auto i = m_sources.begin(); i != m_sources.end(); i++) {
+            auto lhs_binds = m_binds.find(i->first);
+            auto src_binds = m_binds.find(i->second);
+            if ((lhs_binds->second == 1) &&
+                (src_binds != m_binds.end()) &&
+                (src_binds->second == 1)) {
+                result.insert(*i);
+            }
+        }
+        return result;
+    }
+};
+
+}
+
+fuse_reductions::fuse_reductions(const string& entry_point)
+    : m_entry_point(entry_point), m_supply("reduction") {}
+
+symbol fuse_reductions::root(const symbol& s) const {
+    symbol r = s;
+    auto i = m_sources.find(r);
+    while(i != m_sources.end()) {
+        r = i->second;
+        i = m_sources.find(r);
+    }
+    return r;
+}
+
+bool fuse_reductions::reduction(const statement& s) const {
+    if (!detail::isinstance<bind>(s)) {
+        return false;
+    }
+    const bind& b = boost::get<const bind&>(s);
+    if (!detail::isinstance<name>(b.lhs()) ||
+        !detail::isinstance<apply>(b.rhs())) {
+        return false;
+    }
+    const apply& a = boost::get<const apply&>(b.rhs());
+    auto src = a.args().begin();
+    if ((a.fn().id() == "reduce") && (a.args().arity() == 3)) {
+        src++;
+    } else if ((a.fn().id() != "sum") || (a.args().arity() != 1)) {
+        return false;
+    }
+    return detail::isinstance<name>(*src);
+}
+
+//The sequence a reduction reads
+static const name& reduction_source(const bind& b) {
+    const apply& a = boost::get<const apply&>(b.rhs());
+    auto src = a.args().begin();
+    if (a.fn().id() == "reduce") {
+        src++;
+    }
+    return boost::get<const name&>(*src);
+}
+
+//The function, sequence and prefix of a reduction.  sum(x) is
+//reduce(op_add, x, 0).
+static void reduction_args(const bind& b,
+                           vector<shared_ptr<const expression> >& args) {
+    const apply& a = boost::get<const apply&>(b.rhs());
+    if (a.fn().id() == "reduce") {
+        for(auto i = a.args().begin(); i != a.args().end(); i++) {
+            args.push_back(i->ptr());
+        }
+        return;
+    }
+    const expression& lhs = b.lhs();
+    args.push_back(
+        make_node<const apply>(
+            make_node<const templated_name>(
+                detail::fnize_id("op_add"),
+                make_node<const ctype::tuple_t>(
+                    make_vector<shared_ptr<const ctype::type_t> >(
+                        lhs.ctype().ptr()))),
+            make_node<const tuple>(
+                make_vector<shared_ptr<const expression> >())));
+    args.push_back(a.args().begin()->ptr());
+    args.push_back(
+        make_node<const literal>("0", lhs.type().ptr(), lhs.ctype().ptr()));
+}
+
+fuse_reductions::result_type fuse_reductions::fused(
+    const vector<shared_ptr<const bind> >& reductions) {
+    vector<shared_ptr<const expression> > args;
+    vector<shared_ptr<const type_t> > types;
+    vector<shared_ptr<const ctype::type_t> > ctypes;
+    for(auto i = reductions.begin(); i != reductions.end(); i++) {
+        reduction_args(**i, args);
+        types.push_back((*i)->lhs().type().ptr());
+        ctypes.push_back((*i)->lhs().ctype().ptr());
+    }
+    shared_ptr<const name> result =
+        make_node<const name>(
+            m_supply.next(),
+            make_node<const tuple_t>(std::move(types)),
+            make_node<const ctype::tuple_t>(std::move(ctypes)));
+    std::ostringstream fn_id;
+    fn_id << "reduce" << reductions.size();
+    vector<shared_ptr<const statement> > stmts;
+    stmts.push_back(
+        make_node<const bind>(
+            result,
+            make_node<const apply>(
+                make_node<const name>(fn_id.str()),
+                make_node<const tuple>(std::move(args)))));
+    int number = 0;
+    for(auto i = reductions.begin(); i != reductions.end(); i++, number++) {
+        stmts.push_back(
+            make_node<const bind>(
+                (*i)->lhs().ptr(),
+                make_node<const apply>(
+                    make_node<const name>(
+                        detail::snippet_get(number)),
+                    make_node<const tuple>(
+                        make_vector<shared_ptr<const expression> >(result)))));
+    }
+    return make_node<const suite>(std::move(stmts));
+}
+
+fuse_reductions::result_type fuse_reductions::operator()(const procedure& n) {
+    if (n.id().id() != m_entry_point) {
+        return n.ptr();
+    }
+    detail::source_finder sf;
+    boost::apply_visitor(sf, n);
+    m_sources = sf.sources();
+    return this->rewriter<fuse_reductions>::operator()(n);
+}
+
+//Whether a statement can move across the statements in [from, to),
+//apart from those in skip: none of them may read or bind what it
+//binds, nor bind what it reads
+static bool movable(const vector<detail::binding_finder>& bindings,
+                    size_t s, size_t from, size_t to,
+                    const vector<size_t>& skip) {
+    const unordered_set<symbol>& bound = bindings[s].bound();
+    const unordered_set<symbol>& reads = bindings[s].read();
+    for(size_t k = from; k < to; k++) {
+        if (std::find(skip.begin(), skip.end(), k) != skip.end()) {
+            continue;
+        }
+        const unordered_set<symbol>& k_bound = bindings[k].bound();
+        const unordered_set<symbol>& k_read = bindings[k].read();
+        for(auto b = bound.begin(); b != bound.end(); b++) {
+            if (k_bound.count(*b) || k_read.count(*b)) {
+                return false;
+            }
+        }
+        for(auto r = reads.begin(); r != reads.end(); r++) {
+            if (k_bound.count(*r)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//Whether two statements are independent of each other
+static bool independent(const vector<detail::binding_finder>& bindings,
+                        size_t a, size_t b) {
+    vector<size_t> none;
+    return movable(bindings, a, b, b + 1, none);
+}
+
+fuse_reductions::result_type fuse_reductions::operator()(const suite& n) {
+    //Nested suites are fused first
+    bool match = true;
+    vector<shared_ptr<const statement> > stmts;
+    vector<detail::binding_finder> bindings;
+    for(auto i = n.begin(); i != n.end(); i++) {
+        shared_ptr<const statement> s =
+            static_pointer_cast<const statement>(
+                boost::apply_visitor(*this, *i));
+        match = match && (s == i->ptr());
+        stmts.push_back(s);
+        bindings.push_back(detail::binding_finder());
+        boost::apply_visitor(bindings.back(), *s);
+    }
+    //Each group of reductions is placed at one of its members.  A
+    //reduction joins a group if it can move up to where the group
+    //is placed, or if the group can move down to it.
+    vector<bool> taken(stmts.size(), false);
+    unordered_map<size_t, vector<size_t> > placed;
+    for(size_t i = 0; i < stmts.size(); i++) {
+        if (taken[i] || !reduction(*stmts[i])) {
+            continue;
+        }
+        vector<size_t> group = make_vector<size_t>(i);
+        size_t place = i;
+        symbol group_root = root(
+            reduction_source(boost::get<const bind&>(*stmts[i])).sym());
+        for(size_t j = i + 1; (j < stmts.size()) && (group.size() < 4); j++) {
+            if (taken[j] || !reduction(*stmts[j])) {
+                continue;
+            }
+            const bind& b = boost::get<const bind&>(*stmts[j]);
+            if (root(reduction_source(b).sym()) != group_root) {
+                continue;
+            }
+            bool joins = true;
+            for(auto m = group.begin(); joins && (m != group.end()); m++) {
+                joins = independent(bindings, *m, j);
+            }
+            if (!joins) {
+                continue;
+            }
+            if (movable(bindings, j, place, j, group)) {
+                group.push_back(j);
+            } else {
+                bool down = true;
+                for(auto m = group.begin(); down && (m != group.end()); m++) {
+                    down = movable(bindings, *m, *m + 1, j, group);
+                }
+                if (!down) {
+                    continue;
+                }
+                group.push_back(j);
+                place = j;
+            }
+        }
+        if (group.size() == 1) {
+            continue;
+        }
+        for(auto m = group.begin(); m != group.end(); m++) {
+            taken[*m] = true;
+        }
+        placed[place] = std::move(group);
+    }
+    if (placed.empty()) {
+        if (match) {
+            return n.ptr();
+        }
+        return make_node<const suite>(std::move(stmts));
+    }
+    vector<shared_ptr<const statement> > result;
+    for(size_t i = 0; i < stmts.size(); i++) {
+        auto p = placed.find(i);
+        if (p == placed.end()) {
+            if (!taken[i]) {
+                result.push_back(stmts[i]);
+            }
+            continue;
+        }
+        vector<shared_ptr<const bind> > group;
+        for(auto m = p->second.begin(); m != p->second.end(); m++) {
+            group.push_back(static_pointer_cast<const bind>(stmts[*m]));
+        }
+        shared_ptr<const suite> f =
+            static_pointer_cast<const suite>(fused(group));
+        for(auto j = f->begin(); j != f->end(); j++) {
+            result.push_back(j->ptr());
+        }
+    }
+    return make_node<const suite>(std::move(result));
+}
+
+}
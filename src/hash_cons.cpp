@@ -0,0 +1,247 @@
+#include "hash_cons.hpp"
+#include "rewriter.hpp"
+#include "polytype.hpp"
+#include <sstream>
+
+using std::shared_ptr;
+using std::string;
+
+namespace backend {
+
+namespace detail {
+
+bool cons_key::operator==(const cons_key& o) const {
+    return (hash == o.hash) && (kind == o.kind) &&
+        (text == o.text) && (parts == o.parts);
+}
+
+inline bool boost_flag(const ctype::tuple_t& t) {
+    return t.boost_impl();
+}
+
+template<typename T>
+inline bool boost_flag(const T&) {
+    return false;
+}
+
+//Serializes a type, used to key the type tables
+template<typename Polytype>
+class type_key
+    : public boost::static_visitor<> {
+private:
+    std::ostream& m_os;
+public:
+    type_key(std::ostream& os) : m_os(os) {}
+
+    void operator()(const Polytype& t) {
+        m_os << "P(";
+        for(auto i = t.begin(); i != t.end(); i++) {
+            boost::apply_visitor(*this, *i);
+            m_os << ",";
+        }
+        (*this)(t.monotype());
+        m_os << ")";
+    }
+
+    template<typename Monotype>
+    void operator()(const Monotype& t) {
+        m_os << t.which() << (boost_flag(t) ? "B" : "")
+             << t.name().size() << ":" << t.name() << "(";
+        for(auto i = t.begin(); i != t.end(); i++) {
+            boost::apply_visitor(*this, *i);
+            m_os << ",";
+        }
+        m_os << ")";
+    }
+};
+
+class cons_key_builder
+    : public boost::static_visitor<> {
+private:
+    hash_cons& m_hc;
+    cons_key& m_k;
+
+    void part(const node& n) {
+        m_k.parts.push_back(&n);
+    }
+    void types(const expression& n) {
+        m_k.parts.push_back(m_hc.intern(n.type().ptr()).get());
+        m_k.parts.push_back(m_hc.intern(n.ctype().ptr()).get());
+    }
+public:
+    cons_key_builder(hash_cons& hc, cons_key& k)
+        : m_hc(hc), m_k(k) {}
+
+    void operator()(const literal& n) {
+        m_k.text = n.id();
+        types(n);
+    }
+    void operator()(const name& n) {
+        m_k.text = n.id();
+        types(n);
+    }
+    void operator()(const templated_name& n) {
+        m_k.text = n.id();
+        types(n);
+        m_k.parts.push_back(m_hc.intern(n.template_types().ptr()).get());
+    }
+    void operator()(const tuple& n) {
+        for(auto i = n.begin(); i != n.end(); i++) {
+            part(*i);
+        }
+        types(n);
+    }
+    void operator()(const apply& n) {
+        part(n.fn());
+        part(n.args());
+    }
+    void operator()(const lambda& n) {
+        part(n.args());
+        part(n.body());
+        types(n);
+    }
+    void operator()(const closure& n) {
+        part(n.args());
+        part(n.body());
+        types(n);
+    }
+    void operator()(const subscript& n) {
+        part(n.src());
+        part(n.idx());
+        types(n);
+    }
+    void operator()(const conditional& n) {
+        part(n.cond());
+        part(n.then());
+        part(n.orelse());
+    }
+    void operator()(const ret& n) {
+        part(n.val());
+    }
+    void operator()(const bind& n) {
+        part(n.lhs());
+        part(n.rhs());
+    }
+    void operator()(const call& n) {
+        part(n.sub());
+    }
+    void operator()(const procedure& n) {
+        m_k.text = n.place();
+        part(n.id());
+        part(n.args());
+        part(n.stmts());
+        m_k.parts.push_back(m_hc.intern(n.type().ptr()).get());
+        m_k.parts.push_back(m_hc.intern(n.ctype().ptr()).get());
+    }
+    void operator()(const suite& n) {
+        for(auto i = n.begin(); i != n.end(); i++) {
+            part(*i);
+        }
+    }
+    //C++ specific nodes are only equal to themselves
+    void operator()(const node& n) {
+        part(n);
+    }
+};
+
+//Rebuilds a tree bottom up, interning each node
+class hash_conser
+    : public rewriter<hash_conser> {
+private:
+    hash_cons& m_hc;
+public:
+    hash_conser(hash_cons& hc) : m_hc(hc) {}
+
+    template<typename T>
+    result_type operator()(const T& n) {
+        return m_hc.intern(rewriter<hash_conser>::operator()(n));
+    }
+};
+
+}
+
+hash_cons::hash_cons()
+    : m_sweep_at(1024), m_hits(0), m_misses(0) {}
+
+detail::cons_key hash_cons::key(const node& n) {
+    detail::cons_key k;
+    k.kind = n.which();
+    detail::cons_key_builder b(*this, k);
+    boost::apply_visitor(b, n);
+    std::size_t h = std::hash<string>()(k.text) ^ std::size_t(k.kind);
+    for(auto i = k.parts.begin(); i != k.parts.end(); i++) {
+        h ^= std::hash<const void*>()(*i) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+    k.hash = h;
+    return k;
+}
+
+shared_ptr<const node> hash_cons::operator()(const node& n) {
+    detail::hash_conser hc(*this);
+    return boost::apply_visitor(hc, n);
+}
+
+shared_ptr<const node> hash_cons::intern(const shared_ptr<const node>& n) {
+    detail::cons_key k = key(*n);
+    auto i = m_nodes.find(k);
+    if (i != m_nodes.end()) {
+        shared_ptr<const node> existing = i->second.lock();
+        if (existing) {
+            m_hits++;
+            return existing;
+        }
+        i->second = n;
+    } else {
+        m_nodes.insert(std::make_pair(std::move(k), std::weak_ptr<const node>(n)));
+        if (m_nodes.size() >= m_sweep_at) {
+            sweep();
+            m_sweep_at = 2 * m_nodes.size() + 1024;
+        }
+    }
+    m_misses++;
+    return n;
+}
+
+shared_ptr<const type_t> hash_cons::intern(const shared_ptr<const type_t>& t) {
+    std::ostringstream os;
+    detail::type_key<polytype_t> tk(os);
+    boost::apply_visitor(tk, *t);
+    auto i = m_types.insert(std::make_pair(os.str(), t));
+    return i.first->second;
+}
+
+shared_ptr<const ctype::type_t> hash_cons::intern(const shared_ptr<const ctype::type_t>& t) {
+    std::ostringstream os;
+    detail::type_key<ctype::polytype_t> tk(os);
+    boost::apply_visitor(tk, *t);
+    auto i = m_ctypes.insert(std::make_pair(os.str(), t));
+    return i.first->second;
+}
+
+std::size_t hash_cons::hash(const node& n) {
+    return key(n).hash;
+}
+
+std::size_t hash_cons::size() const {
+    return m_nodes.size();
+}
+
+std::size_t hash_cons::hits() const {
+    return m_hits;
+}
+
+std::size_t hash_cons::misses() const {
+    return m_misses;
+}
+
+void hash_cons::sweep() {
+    for(auto i = m_nodes.begin(); i != m_nodes.end();) {
+        if (i->second.expired()) {
+            i = m_nodes.erase(i);
+        } else {
+            i++;
+        }
+    }
+}
+
+}
@@ -5,7 +5,6 @@
 
 
 using std::shared_ptr;
-using std::make_shared;
 using std::static_pointer_cast;
 using std::vector;
 using std::move;
@@ -118,37 +117,37 @@ public:
         
         //We need to invert the sense of this conditional
         shared_ptr<const name> inverted_cond =
-            make_shared<const name>(
+            make_node<const name>(
                 "inverted",
                 bool_mt);
         shared_ptr<const expression> cond = c.cond().ptr();
         //Flatten conditional expression to avoid creating nested expressions
         if (!detail::isinstance<name>(c.cond())) {
             shared_ptr<const name> cond_name =
-                make_shared<const name>(
+                make_node<const name>(
                     "conditional",
                     bool_mt);
             stmts.push_back(
-                make_shared<const bind>(
+                make_node<const bind>(
                     cond_name,
                     cond));
             cond = cond_name;
         }
         shared_ptr<const apply> make_inverted =
-            make_shared<const apply>(
-                make_shared<const name>("op_not"),
-                make_shared<const tuple>(
+            make_node<const apply>(
+                make_node<const name>("op_not"),
+                make_node<const tuple>(
                     make_vector<shared_ptr<const expression> >(cond)));
         shared_ptr<const bind> inverted_bind =
-            make_shared<const bind>(inverted_cond, make_inverted);
+            make_node<const bind>(inverted_cond, make_inverted);
         stmts.push_back(inverted_bind);
         shared_ptr<const conditional> inverted_conditional =
-            make_shared<const conditional>(
+            make_node<const conditional>(
                 inverted_cond,
                 c.orelse().ptr(),
                 c.then().ptr());
         stmts.push_back(inverted_conditional);
-        return make_shared<const suite>(move(stmts));
+        return make_node<const suite>(move(stmts));
     }
             
     
@@ -199,7 +198,7 @@ public:
                             }
                             if (!assigned) {
                                 while_stmts.push_back(
-                                    make_shared<const bind>(
+                                    make_node<const bind>(
                                         formal_name.ptr(),
                                         k->ptr()));
                             }
@@ -215,16 +214,16 @@ public:
         }
         while_stmts.insert(while_stmts.end(), m_pre.begin(), m_pre.end());
         stmts.push_back(
-            make_shared<const while_block>(
+            make_node<const while_block>(
                 c.cond().ptr(),
-                make_shared<const suite>(
+                make_node<const suite>(
                     move(while_stmts))));
         for(auto i = c.orelse().begin();
             i != c.orelse().end();
             i++) {
             stmts.push_back(i->ptr());
         }
-        auto result = make_shared<const suite>(move(stmts));
+        auto result = make_node<const suite>(move(stmts));
         return result;
     }
 };
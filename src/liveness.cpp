@@ -0,0 +1,190 @@
+#include "liveness.hpp"
+#include "utility/snippets.hpp"
+#include <algorithm>
+#include <cassert>
+
+using std::string;
+using std::vector;
+using std::unordered_set;
+
+namespace backend {
+
+namespace detail {
+
+void binding_finder::bound(const expression& lhs) {
+    if (detail::isinstance<name>(lhs)) {
+        m_bound.insert(boost::get<const name&>(lhs).sym());
+    } else if (detail::isinstance<tuple>(lhs)) {
+        const tuple& t = boost::get<const tuple&>(lhs);
+        for(auto i = t.begin(); i != t.end(); i++) {
+            bound(*i);
+        }
+    }
+}
+
+binding_finder::result_type binding_finder::operator()(const procedure& n) {
+    bound(n.args());
+    boost::apply_visitor(*this, n.stmts());
+    return n.ptr();
+}
+
+binding_finder::result_type binding_finder::operator()(const bind& n) {
+    bound(n.lhs());
+    boost::apply_visitor(*this, n.rhs());
+    return n.ptr();
+}
+
+binding_finder::result_type binding_finder::operator()(const name& n) {
+    m_read.insert(n.sym());
+    return n.ptr();
+}
+
+const unordered_set<symbol>& binding_finder::bound() const {
+    return m_bound;
+}
+
+const unordered_set<symbol>& binding_finder::read() const {
+    return m_read;
+}
+
+//Scalars can't point into anyone's storage
+static bool scalar(const ctype::type_t& t) {
+    return detail::isinstance<ctype::monotype_t>(t) &&
+        !detail::isinstance<ctype::sequence_t>(t) &&
+        !detail::isinstance<ctype::tuple_t>(t) &&
+        !detail::isinstance<ctype::fn_t>(t);
+}
+
+//Whether a bind gives its lhs a newly allocated cuarray.  Tuple
+//elements and buffers updated in place belong to someone else.
+static bool allocates(const bind& n) {
+    if (!detail::isinstance<ctype::cuarray_t>(n.lhs().ctype()) ||
+        !detail::isinstance<apply>(n.rhs())) {
+        return false;
+    }
+    const string& fn = boost::get<const apply&>(n.rhs()).fn().id();
+    const string in_place("_in_place");
+    return (fn.find(detail::snippet_get()) == string::npos) &&
+        ((fn.size() < in_place.size()) ||
+         (fn.compare(fn.size() - in_place.size(),
+                     in_place.size(), in_place) != 0));
+}
+
+}
+
+liveness::liveness(const suite& n) {
+    int index = 0;
+    for(auto i = n.begin(); i != n.end(); i++, index++) {
+        m_stmts.push_back(detail::binding_finder());
+        detail::binding_finder& stmt = m_stmts.back();
+        boost::apply_visitor(stmt, *i);
+        for(auto j = stmt.bound().begin(); j != stmt.bound().end(); j++) {
+            m_binds[*j]++;
+            m_definitions[*j] = index;
+        }
+        bool holds = true;
+        if (detail::isinstance<bind>(*i)) {
+            const bind& b = boost::get<const bind&>(*i);
+            if (detail::scalar(b.lhs().ctype())) {
+                holds = false;
+            } else if (detail::allocates(b)) {
+                holds = false;
+                assert(detail::isinstance<name>(b.lhs()));
+                m_fresh.insert(boost::get<const name&>(b.lhs()).sym());
+            }
+        }
+        if (holds) {
+            for(auto j = stmt.bound().begin(); j != stmt.bound().end(); j++) {
+                for(auto k = stmt.read().begin(); k != stmt.read().end(); k++) {
+                    if (*j != *k) {
+                        m_holders[*k].push_back(*j);
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::size_t liveness::size() const {
+    return m_stmts.size();
+}
+
+const unordered_set<symbol>& liveness::bound(std::size_t i) const {
+    return m_stmts[i].bound();
+}
+
+const unordered_set<symbol>& liveness::read(std::size_t i) const {
+    return m_stmts[i].read();
+}
+
+int liveness::last_use(const symbol& s,
+                       unordered_set<symbol>& visiting) const {
+    auto memo = m_last_uses.find(s);
+    if (memo != m_last_uses.end()) {
+        return memo->second;
+    }
+    int result = -1;
+    for(int i = int(m_stmts.size()) - 1; i >= 0; i--) {
+        if (m_stmts[i].read().count(s)) {
+            result = i;
+            break;
+        }
+    }
+    //Loops can make identifiers hold each other
+    visiting.insert(s);
+    auto holders = m_holders.find(s);
+    if (holders != m_holders.end()) {
+        for(auto i = holders->second.begin(); i != holders->second.end(); i++) {
+            if (visiting.count(*i) == 0) {
+                result = std::max(result, last_use(*i, visiting));
+            }
+        }
+    }
+    visiting.erase(s);
+    //Results computed while inside a cycle may be incomplete
+    if (visiting.empty()) {
+        m_last_uses[s] = result;
+    }
+    return result;
+}
+
+int liveness::last_use(const symbol& s) const {
+    unordered_set<symbol> visiting;
+    return last_use(s, visiting);
+}
+
+bool liveness::holds(const symbol& h, const symbol& s) const {
+    unordered_set<symbol> seen;
+    vector<symbol> work(1, s);
+    while(!work.empty()) {
+        symbol i = work.back();
+        work.pop_back();
+        auto holders = m_holders.find(i);
+        if (holders == m_holders.end()) {
+            continue;
+        }
+        for(auto j = holders->second.begin(); j != holders->second.end(); j++) {
+            if (*j == h) {
+                return true;
+            }
+            if (seen.insert(*j).second) {
+                work.push_back(*j);
+            }
+        }
+    }
+    return false;
+}
+
+int liveness::definition(const symbol& s) const {
+    auto binds = m_binds.find(s);
+    if ((binds == m_binds.end()) || (binds->second != 1)) {
+        return -1;
+    }
+    return m_definitions.find(s)->second;
+}
+
+bool liveness::fresh(const symbol& s) const {
+    return (definition(s) != -1) && (m_fresh.count(s) != 0);
+}
+
+}
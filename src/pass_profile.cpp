@@ -0,0 +1,78 @@
+#include "pass_profile.hpp"
+#include "rewriter.hpp"
+
+using std::string;
+using std::vector;
+using std::unordered_set;
+
+namespace backend {
+
+namespace detail {
+
+//Collects the address of every node in an AST
+class node_census
+    : public rewriter<node_census> {
+private:
+    unordered_set<const node*>& m_nodes;
+public:
+    node_census(unordered_set<const node*>& nodes)
+        : m_nodes(nodes) {}
+
+    template<typename T>
+    result_type operator()(const T& n) {
+        m_nodes.insert(&n);
+        return rewriter<node_census>::operator()(n);
+    }
+};
+
+void census(const node& n, unordered_set<const node*>& nodes) {
+    node_census c(nodes);
+    boost::apply_visitor(c, n);
+}
+
+}
+
+void pass_profiler::start(const string& name, const node& n) {
+    m_input.clear();
+    detail::census(n, m_input);
+    pass_profile p;
+    p.name = name;
+    p.nodes_in = m_input.size();
+    m_profiles.push_back(p);
+    m_start = std::chrono::high_resolution_clock::now();
+}
+
+void pass_profiler::finish(const node& n) {
+    std::chrono::high_resolution_clock::time_point stop =
+        std::chrono::high_resolution_clock::now();
+    pass_profile& p = m_profiles.back();
+    p.seconds =
+        std::chrono::duration_cast<std::chrono::duration<double> >(
+            stop - m_start).count();
+    unordered_set<const node*> output;
+    detail::census(n, output);
+    p.nodes_out = output.size();
+    p.shared = 0;
+    for(auto i = output.begin(); i != output.end(); i++) {
+        if (m_input.find(*i) != m_input.end()) {
+            p.shared++;
+        }
+    }
+    p.allocated = p.nodes_out - p.shared;
+    m_input.clear();
+}
+
+const vector<pass_profile>& pass_profiler::profiles() const {
+    return m_profiles;
+}
+
+void print_profiles(std::ostream& o, const vector<pass_profile>& p) {
+    o << "pass\tseconds\tnodes_in\tnodes_out\tallocated\tshared" << std::endl;
+    for(auto i = p.begin(); i != p.end(); i++) {
+        o << i->name << "\t" << i->seconds << "\t" << i->nodes_in << "\t"
+          << i->nodes_out << "\t" << i->allocated << "\t"
+          << i->shared << std::endl;
+    }
+}
+
+}
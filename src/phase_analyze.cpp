@@ -3,7 +3,6 @@
 using std::string;
 using std::pair;
 using std::shared_ptr;
-using std::make_shared;
 using std::move;
 using std::vector;
 using std::static_pointer_cast;
@@ -11,6 +10,7 @@ using std::make_pair;
 using backend::utility::make_vector;
 using backend::utility::make_set;
 using std::set;
+using std::unordered_set;
 
 namespace backend {
 
@@ -19,7 +19,7 @@ namespace detail {
 class return_finder
     : public rewriter<return_finder> {
 private:
-    set<string> m_returns;
+    unordered_set<symbol> m_returns;
 public:
     using rewriter<return_finder>::operator();
 
@@ -47,11 +47,11 @@ public:
     result_type operator()(const ret& r) {
         if (detail::isinstance<name>(r.val())) {
             const name& return_name = boost::get<const name&>(r.val());
-            m_returns.insert(return_name.id());
+            m_returns.insert(return_name.sym());
         }
         return r.ptr();
     }
-    const set<string>& returns() const {
+    const unordered_set<symbol>& returns() const {
         return m_returns;
     }
 };
@@ -65,7 +65,7 @@ phase_analyze::phase_analyze(const string& entry_point,
         i != reg.fns().cend();
         i++) {
         auto id = i->first;
-        string fn_name = std::get<0>(id);
+        const symbol& fn_name = std::get<0>(id);
         auto info = i->second;
         m_fns.insert(make_pair(fn_name, info.phase().ptr()));
     }
@@ -87,7 +87,7 @@ phase_analyze::result_type phase_analyze::operator()(const procedure& n) {
             //Arguments to procedures must be names
             assert(detail::isinstance<name>(*i));
             const name& arg_name = detail::up_get<name>(*i);
-            const std::string& arg_id = arg_name.id();
+            const symbol& arg_id = arg_name.sym();
 
             //If the input is typed as a sequence, it's totally formed
             //Otherwise it's invariantly formed (scalars)
@@ -102,7 +102,7 @@ phase_analyze::result_type phase_analyze::operator()(const procedure& n) {
             static_pointer_cast<const suite>(
                 boost::apply_visitor(*this, n.stmts()));
         result_type result =
-            make_shared<const procedure>(
+            make_node<const procedure>(
                 n.id().ptr(),
                 n.args().ptr(),
                 stmts,
@@ -118,10 +118,10 @@ phase_analyze::result_type phase_analyze::operator()(const procedure& n) {
 }
 
 bool phase_analyze::add_phase_boundary_tuple(const name& n, bool post) {
-    assert(m_tuples.exists(n.id()));
+    assert(m_tuples.exists(n.sym()));
     bool need_boundary = false;
     const vector<shared_ptr<const literal> >& sources =
-        m_tuples.find(n.id())->second;
+        m_tuples.find(n.sym())->second;
     for(auto i = sources.begin();
         i != sources.end();
         i++) {
@@ -134,7 +134,7 @@ bool phase_analyze::add_phase_boundary_tuple(const name& n, bool post) {
         return false;
     }
     shared_ptr<const name> p_result =
-        make_shared<const name>(
+        make_node<const name>(
             detail::complete(n.id()),
             n.type().ptr());
 
@@ -144,9 +144,9 @@ bool phase_analyze::add_phase_boundary_tuple(const name& n, bool post) {
         i++) {
         if (detail::isinstance<name>(**i)) {
             const name& i_name = boost::get<const name&>(**i);
-            if (m_substitutions.exists(i_name.id())) {
+            if (m_substitutions.exists(i_name.sym())) {
                 expr_sources.push_back(
-                    m_substitutions.find(i_name.id())->second->ptr());
+                    m_substitutions.find(i_name.sym())->second->ptr());
             } else {
                 expr_sources.push_back(*i);
             }
@@ -155,16 +155,16 @@ bool phase_analyze::add_phase_boundary_tuple(const name& n, bool post) {
         }
     }
     shared_ptr<const tuple> pb_args =
-        make_shared<const tuple>(
+        make_node<const tuple>(
             move(expr_sources));
     shared_ptr<const apply> pb_apply =
-        make_shared<const apply>(
-            make_shared<const name>(
+        make_node<const apply>(
+            make_node<const name>(
                 detail::snippet_make_tuple()),
             pb_args);
 
     shared_ptr<const bind> result =
-        make_shared<const bind>(p_result, pb_apply);
+        make_node<const bind>(p_result, pb_apply);
     if (post) {
         m_post_boundary = result;
     } else {
@@ -172,43 +172,43 @@ bool phase_analyze::add_phase_boundary_tuple(const name& n, bool post) {
     }
     //Register completion
     m_completions.insert(
-        make_pair(p_result->id(), completion::total));
+        make_pair(p_result->sym(), completion::total));
         
     //Register substitution
     m_substitutions.insert(
-        make_pair(n.id(), p_result));
+        make_pair(n.sym(), p_result));
     return true;
 }
 
 bool phase_analyze::add_phase_boundary(const name& n, bool post) {
-    if (m_tuples.exists(n.id())) {
+    if (m_tuples.exists(n.sym())) {
         return add_phase_boundary_tuple(n, post);
     }
 
     if (!post) {
         //Post completions can happen multiple times due to iteration
         //Pre completions may happen only once
-        if (m_completions.exists(n.id())) {
-            completion c = m_completions.find(n.id())->second;
+        if (m_completions.exists(n.sym())) {
+            completion c = m_completions.find(n.sym())->second;
             if ((c == completion::invariant) ||
                 (c == completion::total))
                 return false;
         }
     }
     shared_ptr<const name> p_result =
-        make_shared<const name>(
+        make_node<const name>(
             detail::complete(n.id()),
             n.type().ptr());
     
     shared_ptr<const tuple> pb_args =
-        make_shared<const tuple>(
+        make_node<const tuple>(
             make_vector<shared_ptr<const expression> >(n.ptr()));
     shared_ptr<const name> pb_name =
-        make_shared<const name>(detail::phase_boundary());
+        make_node<const name>(detail::phase_boundary());
     shared_ptr<const apply> pb_apply =
-        make_shared<const apply>(pb_name, pb_args);
+        make_node<const apply>(pb_name, pb_args);
     shared_ptr<const bind> result =
-        make_shared<const bind>(p_result, pb_apply);
+        make_node<const bind>(p_result, pb_apply);
     if (post) {
         m_post_boundary = result;
     } else {
@@ -216,11 +216,11 @@ bool phase_analyze::add_phase_boundary(const name& n, bool post) {
     }
     //Register completion
     m_completions.insert(
-        make_pair(p_result->id(), completion::total));
+        make_pair(p_result->sym(), completion::total));
         
     //Register substitution
     m_substitutions.insert(
-        make_pair(n.id(), p_result));
+        make_pair(n.sym(), p_result));
     return true;
 }
 
@@ -232,11 +232,11 @@ phase_analyze::result_type phase_analyze::operator()(const apply& n) {
     const name& fn_name = n.fn();
    
     //If function not declared, assume it can't trigger a phase boundary
-    if (m_fns.find(fn_name.id()) == m_fns.end()) {
+    if (m_fns.find(fn_name.sym()) == m_fns.end()) {
         return n.ptr();
     }
     
-    shared_ptr<const phase_t> fn_phase = m_fns.find(fn_name.id())->second;
+    shared_ptr<const phase_t> fn_phase = m_fns.find(fn_name.sym())->second;
     phase_t::iterator j = fn_phase->begin();
     //The phase type for the function must match the args given to it
     assert(fn_phase->size() == n.args().arity());
@@ -251,20 +251,20 @@ phase_analyze::result_type phase_analyze::operator()(const apply& n) {
         //assume it's invariant
         if (detail::isinstance<name>(*i)) {
             const name& id = detail::up_get<name>(*i);
-            if (m_substitutions.exists(id.id())) {
+            if (m_substitutions.exists(id.sym())) {
                 //Phase boundary already took place, use the complete version
                 //HEURISTIC HAZARD:
                 //This might not always be the right choice
-                new_arg = m_substitutions.find(id.id())->second;
+                new_arg = m_substitutions.find(id.sym())->second;
             } else {
                 //If completion hasn't been recorded, assume it's invariant
-                if (m_completions.exists(id.id())) {
+                if (m_completions.exists(id.sym())) {
                     completion arg_completion =
-                        m_completions.find(id.id())->second;
+                        m_completions.find(id.sym())->second;
                     //Do we need a phase boundary for this argument?
                     if (arg_completion < (*j)) {
                         add_phase_boundary(id);
-                        new_arg = m_substitutions.find(id.id())->second;
+                        new_arg = m_substitutions.find(id.sym())->second;
                     }
                 }
             } 
@@ -279,9 +279,9 @@ phase_analyze::result_type phase_analyze::operator()(const apply& n) {
     if (!changed) {
         return n.ptr();
     }
-    return make_shared<const apply>(
+    return make_node<const apply>(
         n.fn().ptr(),
-        make_shared<const tuple>(
+        make_node<const tuple>(
             move(new_args)));
 }
 
@@ -308,13 +308,13 @@ phase_analyze::result_type phase_analyze::make_tuple_analyze(const bind& n) {
             }
         }
     }
-    m_completions.insert(make_pair(lhs.id(), glb));
-    m_tuples.insert(make_pair(lhs.id(),
+    m_completions.insert(make_pair(lhs.sym(), glb));
+    m_tuples.insert(make_pair(lhs.sym(),
                               move(sources)));
 
     //If the result is going to be returned at some point, it must be
     //completed
-    if ((m_returns.find(lhs.id()) != m_returns.end()) &&
+    if ((m_returns.find(lhs.sym()) != m_returns.end()) &&
         glb < completion::total) {
         //Add a phase boundary, POST call
         add_phase_boundary_tuple(lhs, true);
@@ -339,7 +339,7 @@ phase_analyze::result_type phase_analyze::form_suite(
         stmts.push_back(m_post_boundary);
         m_post_boundary = shared_ptr<const statement>();
     }
-    return make_shared<const suite>(move(stmts));
+    return make_node<const suite>(move(stmts));
 }
     
 
@@ -374,30 +374,30 @@ phase_analyze::result_type phase_analyze::operator()(const bind& n) {
         shared_ptr<const name> rhs = source_name.ptr();
         //Check to see if we have a completed version of the RHS
         //If so, return a binding which grabs from the completed version
-        auto subst = m_substitutions.find(source_name.id());
+        auto subst = m_substitutions.find(source_name.sym());
         if (subst != m_substitutions.end()) {
-            return make_shared<bind>(n.lhs().ptr(), subst->second);
+            return make_node<bind>(n.lhs().ptr(), subst->second);
         }
         
         //We don't have a completed version, so we'll need to use it
         assert(detail::isinstance<name>(n.lhs()));
         const name& dest_name = boost::get<const name&>(n.lhs());
-        if (m_completions.exists(source_name.id()) &&
-            m_completions.exists(dest_name.id())) {
+        if (m_completions.exists(source_name.sym()) &&
+            m_completions.exists(dest_name.sym())) {
             completion source_completion =
-                m_completions.find(source_name.id())->second;
+                m_completions.find(source_name.sym())->second;
             completion dest_completion =
-                m_completions.find(dest_name.id())->second;
+                m_completions.find(dest_name.sym())->second;
             if (source_completion < dest_completion) {
                 add_phase_boundary(source_name);
-                rhs = m_substitutions.find(source_name.id())->second;
+                rhs = m_substitutions.find(source_name.sym())->second;
             }
         }
         
         if (rhs == n.rhs().ptr()) {
             return n.ptr();
         } else {
-            return form_suite(make_shared<const bind>(
+            return form_suite(make_node<const bind>(
                                   n.lhs().ptr(),
                                   rhs));
         }
@@ -409,7 +409,7 @@ phase_analyze::result_type phase_analyze::operator()(const bind& n) {
     //completed
     if (detail::isinstance<name>(n.lhs())) {
         const name& lhs_name = boost::get<const name&>(n.lhs());
-        if ((m_returns.find(lhs_name.id()) != m_returns.end()) &&
+        if ((m_returns.find(lhs_name.sym()) != m_returns.end()) &&
             m_result_completion < completion::total) {
             //Add a phase boundary, POST call
             add_phase_boundary(lhs_name, true);
@@ -420,7 +420,7 @@ phase_analyze::result_type phase_analyze::operator()(const bind& n) {
     //Update completion declarations
     if (detail::isinstance<name>(n.lhs())) {
         const name& lhs_name = detail::up_get<name>(n.lhs());
-        m_completions.insert(make_pair(lhs_name.id(),
+        m_completions.insert(make_pair(lhs_name.sym(),
                                        m_result_completion));
     }
     return form_suite(static_pointer_cast<const statement>(rewritten));
@@ -429,9 +429,9 @@ phase_analyze::result_type phase_analyze::operator()(const bind& n) {
 phase_analyze::result_type phase_analyze::operator()(const ret& n) {
     if (detail::isinstance<name>(n.val())) {
         const name& ret_val = boost::get<const name&>(n.val());
-        auto subst = m_substitutions.find(ret_val.id());
+        auto subst = m_substitutions.find(ret_val.sym());
         if (subst != m_substitutions.end()) {
-            return make_shared<const ret>(subst->second);
+            return make_node<const ret>(subst->second);
         }
     }
     return n.ptr();
@@ -447,13 +447,13 @@ phase_analyze::result_type phase_analyze::operator()(const closure &n) {
         bool boundaried = false;
         if (detail::isinstance<name>(*i)) {
             const name& arg = boost::get<const name&>(*i);
-            if (m_completions.exists(arg.id())) {
+            if (m_completions.exists(arg.sym())) {
                 completion arg_completion =
-                    m_completions.find(arg.id())->second;
+                    m_completions.find(arg.sym())->second;
                 if (arg_completion < completion::total) {
                     add_phase_boundary(arg);
                     new_args.push_back(
-                        m_substitutions.find(arg.id())->second);
+                        m_substitutions.find(arg.sym())->second);
                     boundaried = true;
                 }
             }
@@ -466,8 +466,8 @@ phase_analyze::result_type phase_analyze::operator()(const closure &n) {
     if (!changed) {
         return n.ptr();
     }
-    auto result = make_shared<const closure>(
-        make_shared<const tuple>(
+    auto result = make_node<const closure>(
+        make_node<const tuple>(
             move(new_args),
             args.type().ptr(),
             args.ctype().ptr()),
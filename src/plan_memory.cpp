@@ -0,0 +1,228 @@
+#include "plan_memory.hpp"
+#include "utility/initializers.hpp"
+#include "utility/snippets.hpp"
+#include "utility/name_supply.hpp"
+
+using std::shared_ptr;
+using std::static_pointer_cast;
+using std::vector;
+using std::string;
+using backend::utility::make_vector;
+
+namespace backend {
+
+plan_memory::plan_memory(const copperhead::system_variant& target,
+                         const string& entry_point,
+                         bool enabled)
+    : m_target(target), m_entry_point(entry_point), m_enabled(enabled) {}
+
+//The argument of a primitive whose length bounds the length of its
+//result, or -1 if there is none
+static int length_operand(const apply& n) {
+    const string& fn = n.fn().id();
+    int arity = n.args().arity();
+    int result = -1;
+    if ((fn == detail::make_sequence()) ||
+        (fn == detail::phase_boundary()) ||
+        (fn == "permute") ||
+        (fn.substr(0, 3) == "zip")) {
+        result = 0;
+    } else if ((fn.substr(0, 3) == "map") ||
+               (fn == "sort") || (fn == "sort_in_place") ||
+               (fn == "scan") || (fn == "scan_in_place") ||
+               (fn == "rscan") ||
+               (fn == "filter") ||
+               (fn == "adjacent_difference")) {
+        result = 1;
+    } else if ((fn == "exclusive_scan") || (fn == "exclusive_rscan") ||
+               (fn == "scatter") || (fn == "scatter_in_place")) {
+        result = 2;
+    }
+    if (result >= arity) {
+        return -1;
+    }
+    return result;
+}
+
+shared_ptr<const name> plan_memory::length_source(const liveness& l,
+                                                  const suite& n,
+                                                  const symbol& s) const {
+    symbol current = s;
+    //Definitions precede uses, so this visits each statement once
+    for(size_t steps = 0; steps <= l.size(); steps++) {
+        auto arg = m_args.find(current);
+        if (arg != m_args.end()) {
+            return arg->second;
+        }
+        int def = l.definition(current);
+        if (def == -1) {
+            break;
+        }
+        const statement& d = *(n.begin() + def);
+        if (!detail::isinstance<bind>(d)) {
+            break;
+        }
+        const bind& b = boost::get<const bind&>(d);
+        if (!detail::isinstance<apply>(b.rhs())) {
+            break;
+        }
+        const apply& a = boost::get<const apply&>(b.rhs());
+        int op = length_operand(a);
+        if (op == -1) {
+            break;
+        }
+        const expression& source = *(a.args().begin() + op);
+        if (!detail::isinstance<name>(source)) {
+            break;
+        }
+        current = boost::get<const name&>(source).sym();
+    }
+    return shared_ptr<const name>();
+}
+
+//Whether a bind allocates a new cuarray.  Tuple elements, views and
+//results computed in place don't.
+static bool allocates(const bind& n) {
+    if (!detail::isinstance<apply>(n.rhs())) {
+        return false;
+    }
+    const string& fn = boost::get<const apply&>(n.rhs()).fn().id();
+    if ((fn.find(detail::snippet_get()) != string::npos) ||
+        (fn == detail::snippet_make_tuple()) ||
+        (fn.find("_in_place") != string::npos)) {
+        return false;
+    }
+    const ctype::type_t& t = n.lhs().ctype();
+    return detail::isinstance<ctype::cuarray_t>(t) ||
+        detail::isinstance<ctype::tuple_t>(t);
+}
+
+plan_memory::result_type plan_memory::operator()(const procedure& n) {
+    if (!m_enabled || (n.id().id() != m_entry_point)) {
+        return n.ptr();
+    }
+    m_args.clear();
+    for(auto i = n.args().begin(); i != n.args().end(); i++) {
+        if (detail::isinstance<name>(*i) &&
+            detail::isinstance<ctype::cuarray_t>(i->ctype())) {
+            const name& arg = boost::get<const name&>(*i);
+            m_args.insert(std::make_pair(arg.sym(), arg.ptr()));
+        }
+    }
+    const suite& body = n.stmts();
+    liveness l(body);
+    detail::name_supply supply("frame");
+    shared_ptr<const name> frame =
+        make_node<const name>(
+            supply.next(),
+            void_mt,
+            make_node<const ctype::monotype_t>("sp_frame"));
+    vector<shared_ptr<const statement> > reservations;
+    vector<bool> escapes(l.size(), false);
+    int index = 0;
+    for(auto i = body.begin(); i != body.end(); i++, index++) {
+        if (detail::isinstance<ret>(*i) || detail::isinstance<call>(*i)) {
+            continue;
+        }
+        if (!detail::isinstance<bind>(*i)) {
+            //Loops and conditionals allocate an unknown number of times
+            return n.ptr();
+        }
+        const bind& b = boost::get<const bind&>(*i);
+        if (!allocates(b)) {
+            continue;
+        }
+        if (!detail::isinstance<ctype::cuarray_t>(b.lhs().ctype()) ||
+            !detail::isinstance<name>(b.lhs())) {
+            return n.ptr();
+        }
+        const ctype::cuarray_t& t =
+            boost::get<const ctype::cuarray_t&>(b.lhs().ctype());
+        if (detail::isinstance<ctype::sequence_t>(t.sub())) {
+            //Nested cuarrays also hold descriptors of unknown size
+            return n.ptr();
+        }
+        const symbol& lhs = boost::get<const name&>(b.lhs()).sym();
+        int last = l.last_use(lhs);
+        if ((last != -1) && detail::isinstance<ret>(*(body.begin() + last))) {
+            escapes[index] = true;
+            continue;
+        }
+        const apply& a = boost::get<const apply&>(b.rhs());
+        int op = length_operand(a);
+        if ((op == -1) ||
+            !detail::isinstance<name>(*(a.args().begin() + op))) {
+            return n.ptr();
+        }
+        shared_ptr<const name> source =
+            length_source(
+                l, body,
+                boost::get<const name&>(*(a.args().begin() + op)).sym());
+        if (!source) {
+            return n.ptr();
+        }
+        reservations.push_back(
+            make_node<const call>(
+                make_node<const apply>(
+                    make_node<const templated_name>(
+                        "reserve",
+                        make_node<const ctype::tuple_t>(
+                            make_vector<shared_ptr<const ctype::type_t> >(
+                                t.sub().ptr()))),
+                    make_node<const tuple>(
+                        make_vector<shared_ptr<const expression> >
+                        (frame)(source)))));
+    }
+    if (reservations.empty()) {
+        return n.ptr();
+    }
+    vector<shared_ptr<const statement> > stmts;
+    stmts.push_back(
+        make_node<const bind>(
+            frame,
+            make_node<const apply>(
+                make_node<const name>("make_frame"),
+                make_node<const tuple>(
+                    make_vector<shared_ptr<const expression> >()))));
+    stmts.insert(stmts.end(), reservations.begin(), reservations.end());
+    stmts.push_back(
+        make_node<const call>(
+            make_node<const apply>(
+                make_node<const name>("begin_frame"),
+                make_node<const tuple>(
+                    make_vector<shared_ptr<const expression> >
+                    (frame)
+                    (make_node<const apply>(
+                        make_node<const name>(copperhead::to_string(m_target)),
+                        make_node<const tuple>(
+                            make_vector<shared_ptr<const expression> >())))))));
+    index = 0;
+    for(auto i = body.begin(); i != body.end(); i++, index++) {
+        if (escapes[index]) {
+            stmts.push_back(
+                make_node<const call>(
+                    make_node<const apply>(
+                        make_node<const name>("pause_frame"),
+                        make_node<const tuple>(
+                            make_vector<shared_ptr<const expression> >(frame)))));
+        }
+        stmts.push_back(i->ptr());
+        if (escapes[index]) {
+            stmts.push_back(
+                make_node<const call>(
+                    make_node<const apply>(
+                        make_node<const name>("resume_frame"),
+                        make_node<const tuple>(
+                            make_vector<shared_ptr<const expression> >(frame)))));
+        }
+    }
+    return make_node<const procedure>(
+        n.id().ptr(),
+        n.args().ptr(),
+        make_node<const suite>(std::move(stmts)),
+        n.type().ptr(),
+        n.ctype().ptr(),
+        n.place());
+}
+
+}
@@ -17,19 +17,84 @@
 
 #include <prelude/config.h>
 #include <prelude/runtime/chunk.hpp>
+#include <prelude/runtime/frame.hpp>
 #include <prelude/runtime/tags.h>
 #include <prelude/runtime/tag_malloc_and_free.h>
 #include <stdexcept>
+#include <algorithm>
 #include <thrust/copy.h>
 #include <boost/utility/enable_if.hpp>
 #include <boost/type_traits.hpp>
 #include <boost/mpl/not.hpp>
 #include <boost/mpl/or.hpp>
 
+#ifdef OMP_SUPPORT
+#include <omp.h>
+#elif defined(TBB_SUPPORT)
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
+
 namespace copperhead {
 
 namespace detail {
 
+//Migrations smaller than this are done by the calling thread
+const size_t parallel_copy_threshold = 1 << 20;
+//Larger migrations are split into blocks of this many bytes
+const size_t copy_block_size = 1 << 18;
+
+//Copies blocks [b, e) of a migration between memory spaces
+template<typename DTag, typename STag>
+struct copy_blocks {
+    char* m_d;
+    char* m_s;
+    size_t m_r;
+    copy_blocks(char* d, char* s, size_t r)
+        : m_d(d), m_s(s), m_r(r) {}
+    void operator()(size_t b, size_t e) const {
+        size_t start = std::min(b * copy_block_size, m_r);
+        size_t stop = std::min(e * copy_block_size, m_r);
+        if (start >= stop) {
+            return;
+        }
+        thrust::pointer<char, STag> s_start(m_s + start);
+        thrust::pointer<char, STag> s_end(m_s + stop);
+        thrust::pointer<char, DTag> d_start(m_d + start);
+        thrust::copy(s_start, s_end, d_start);
+    }
+#ifdef TBB_SUPPORT
+    void operator()(const tbb::blocked_range<size_t>& r) const {
+        (*this)(r.begin(), r.end());
+    }
+#endif
+};
+
+//Migrates r bytes using all available threads.  Each thread copies
+//a contiguous range, so the host side of the transfer, which the
+//driver stages through its own buffers, is spread across cores.
+template<typename DTag, typename STag>
+void parallel_copy(char* d, char* s, size_t r) {
+    copy_blocks<DTag, STag> copier(d, s, r);
+    size_t blocks = (r + copy_block_size - 1) / copy_block_size;
+    if (r < parallel_copy_threshold) {
+        copier(0, blocks);
+        return;
+    }
+#ifdef OMP_SUPPORT
+#pragma omp parallel
+    {
+        size_t threads = omp_get_num_threads();
+        size_t id = omp_get_thread_num();
+        copier(blocks * id / threads, blocks * (id + 1) / threads);
+    }
+#elif defined(TBB_SUPPORT)
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, blocks), copier);
+#else
+    copier(0, blocks);
+#endif
+}
+
 struct apply_malloc
     : public boost::static_visitor<void*> {
     const size_t m_ctr;
@@ -77,20 +142,23 @@ struct apply_copy
     operator()(DTag, STag) const {
         typedef typename copperhead::detail::canonical_memory_tag<DTag>::tag canonical_tag_D;
         typedef typename copperhead::detail::canonical_memory_tag<STag>::tag canonical_tag_S;
-        thrust::pointer<char, canonical_tag_S> s_start((char*)m_s);
-        thrust::pointer<char, canonical_tag_S> s_end = s_start + m_r;
-        thrust::pointer<char, canonical_tag_D> d_start((char*)m_d);
-        thrust::copy(s_start, s_end, d_start);
+        parallel_copy<canonical_tag_D, canonical_tag_S>((char*)m_d, (char*)m_s, m_r);
     }
 };
             
 }
 
 chunk::chunk(const system_variant &s,
-             size_t r) : m_s(s), m_d(NULL), m_r(r) {}
+             size_t r) : m_s(s), m_d(NULL), m_r(r), m_owned(true) {}
+
+chunk::chunk(const system_variant &s,
+             void* d,
+             size_t r,
+             const boost::shared_ptr<void>& keep)
+    : m_s(s), m_d(d), m_r(r), m_owned(false), m_keep(keep) {}
 
 chunk::~chunk() {
-    if (m_d != NULL) {
+    if (m_owned && (m_d != NULL)) {
         boost::apply_visitor(
             detail::apply_free(m_d),
             m_s);
@@ -108,13 +176,41 @@ void chunk::copy_from(chunk& o) {
                          o.m_s);
 }
 
+void chunk::copy_from(chunk& o, size_t b, size_t e) {
+    if ((e > m_r) || (e > o.m_r) || (b > e)) {
+        throw std::invalid_argument("Internal error: copy range exceeds chunk");
+    }
+    boost::apply_visitor(detail::apply_copy((char*)ptr() + b,
+                                            (char*)o.ptr() + b,
+                                            e - b),
+                         m_s,
+                         o.m_s);
+}
+
+void chunk::shrink(size_t r) {
+    if (r > m_r) {
+        throw std::invalid_argument("Internal error: can't grow a chunk");
+    }
+    //If the chunk has not been allocated yet, the smaller
+    //size will be used when it is.
+    m_r = r;
+}
 
 void* chunk::ptr() {
-    if (m_d == NULL) {
-        //Lazy allocation - only allocate when pointer is requested
-        m_d = boost::apply_visitor(
-            detail::apply_malloc(m_r),
-            m_s);
+    if (m_owned && (m_d == NULL)) {
+        //Lazy allocation - only allocate when pointer is requested.
+        //Temporaries of a planned invocation come from its frame.
+        frame* f = detail::current_frame();
+        if (f != NULL) {
+            m_d = f->carve(m_s, m_r, m_keep);
+        }
+        if (m_d != NULL) {
+            m_owned = false;
+        } else {
+            m_d = boost::apply_visitor(
+                detail::apply_malloc(m_r),
+                m_s);
+        }
     } 
     return m_d;
 }
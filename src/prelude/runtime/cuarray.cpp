@@ -1,8 +1,68 @@
 #include <prelude/runtime/cuarray.hpp>
 #include <prelude/runtime/type_holder.hpp>
+#include <stdexcept>
+#include <cassert>
+#include <algorithm>
+#include <limits>
 
 namespace copperhead {
 
+namespace detail {
+
+void add_range(range_set& s, size_t b, size_t e) {
+    if (b >= e) {
+        return;
+    }
+    s.push_back(std::make_pair(b, e));
+    std::sort(s.begin(), s.end());
+    range_set merged;
+    for(range_set::const_iterator i = s.begin();
+        i != s.end();
+        i++) {
+        if (!merged.empty() && (i->first <= merged.back().second)) {
+            merged.back().second = std::max(merged.back().second, i->second);
+        } else {
+            merged.push_back(*i);
+        }
+    }
+    s.swap(merged);
+}
+
+void remove_range(range_set& s, size_t b, size_t e) {
+    range_set remaining;
+    for(range_set::const_iterator i = s.begin();
+        i != s.end();
+        i++) {
+        if ((i->second <= b) || (i->first >= e)) {
+            remaining.push_back(*i);
+        } else {
+            if (i->first < b) {
+                remaining.push_back(std::make_pair(i->first, b));
+            }
+            if (i->second > e) {
+                remaining.push_back(std::make_pair(e, i->second));
+            }
+        }
+    }
+    s.swap(remaining);
+}
+
+range_set intersect_range(const range_set& s, size_t b, size_t e) {
+    range_set result;
+    for(range_set::const_iterator i = s.begin();
+        i != s.end();
+        i++) {
+        size_t lo = std::max(i->first, b);
+        size_t hi = std::min(i->second, e);
+        if (lo < hi) {
+            result.push_back(std::make_pair(lo, hi));
+        }
+    }
+    return result;
+}
+
+}
+
 cuarray::cuarray(type_holder* t,
                  size_t o)
     : m_t(t), m_o(o) {}
@@ -20,19 +80,58 @@ void cuarray::push_back_length(size_t l) {
 void cuarray::add_chunk(boost::shared_ptr<chunk> c,
                         const bool& v) {
     system_variant t = c->tag();
+    range_set stale;
+    if (!v) {
+        stale.push_back(whole());
+    }
     if (m_d.find(t) == m_d.end()) {
         std::vector<boost::shared_ptr<chunk> > new_vector;
         new_vector.push_back(c);
-        std::pair<std::vector<boost::shared_ptr<chunk> >, bool> new_pair =
-            std::make_pair(std::move(new_vector), v);
+        std::pair<std::vector<boost::shared_ptr<chunk> >, range_set> new_pair =
+            std::make_pair(std::move(new_vector), std::move(stale));
         m_d[t] = std::move(new_pair);
     } else {
-        std::pair<std::vector<boost::shared_ptr<chunk> >, bool>& e = m_d[t];
-        e.second = v;
+        std::pair<std::vector<boost::shared_ptr<chunk> >, range_set>& e = m_d[t];
+        e.second = std::move(stale);
         e.first.push_back(c);
     }
 }
 
+void cuarray::shrink(size_t l) {
+    if (m_l.size() != 1) {
+        throw std::invalid_argument("Internal error: can only shrink flat cuarrays");
+    }
+    size_t old_l = m_l[0];
+    if (l > old_l) {
+        throw std::invalid_argument("Internal error: can't grow a cuarray");
+    }
+    if (l == old_l) {
+        return;
+    }
+    m_l[0] = l;
+    //Chunks of an offset cuarray are shared with the cuarray it views,
+    //so only the logical length changes
+    if (m_o != 0) {
+        return;
+    }
+    for(typename data_map::iterator i = m_d.begin();
+        i != m_d.end();
+        i++) {
+        detail::remove_range(i->second.second, l, old_l);
+    }
+    for(typename data_map::iterator i = m_d.begin();
+        i != m_d.end();
+        i++) {
+        std::vector<boost::shared_ptr<chunk> >& chunks = i->second.first;
+        for(std::vector<boost::shared_ptr<chunk> >::iterator j = chunks.begin();
+            j != chunks.end();
+            j++) {
+            size_t element_size = (*j)->size() / old_l;
+            (*j)->shrink(element_size * l);
+        }
+    }
+}
+
 size_t cuarray::size() const {
     size_t s = m_l[0];
     if (m_l.size() > 1) {
@@ -42,41 +141,79 @@ size_t cuarray::size() const {
 }
 
 std::vector<boost::shared_ptr<chunk> >& cuarray::get_chunks(const system_variant& t, bool write) {
+    std::pair<size_t, size_t> w = whole();
+    return get_chunks(t, write, w.first, w.second);
+}
+
+std::vector<boost::shared_ptr<chunk> >& cuarray::get_chunks(const system_variant& t, bool write,
+                                                            size_t b, size_t e) {
+    if (!ranged()) {
+        std::pair<size_t, size_t> w = whole();
+        b = w.first;
+        e = w.second;
+    }
     system_variant canonical_tag = canonical_memory_tag(t);
-    std::pair<std::vector<boost::shared_ptr<chunk> >, bool>& s = m_d[canonical_tag];
+    std::pair<std::vector<boost::shared_ptr<chunk> >, range_set>& s = m_d[canonical_tag];
     //Do we need to copy?
-    if (!s.second) {
-        //Find a valid representation
-        std::pair<std::vector<boost::shared_ptr<chunk> >, bool> x;
-        x.second = false;
-        for(typename data_map::iterator i = m_d.begin();
-            (x.second == false) && (i != m_d.end());
-            i++) {
-            x = i->second;
+    range_set stale = detail::intersect_range(s.second, b, e);
+    for(range_set::const_iterator r = stale.begin();
+        r != stale.end();
+        r++) {
+        //Find a representation which is valid over this range
+        typename data_map::iterator x = m_d.begin();
+        while((x != m_d.end()) &&
+              (system_variant_equal(x->first, canonical_tag) ||
+               !detail::intersect_range(x->second.second,
+                                        r->first, r->second).empty())) {
+            x++;
         }
-        assert(x.second == true);
+        assert(x != m_d.end());
         //Copy from valid representation
         for(std::vector<boost::shared_ptr<chunk> >::iterator i = s.first.begin(),
-                j = x.first.begin();
+                j = x->second.first.begin();
             i != s.first.end();
             i++, j++) {
-            (*i)->copy_from(**j);
+            std::pair<size_t, size_t> bytes = byte_range(**i, *r);
+            (*i)->copy_from(**j, bytes.first, bytes.second);
         }
-        s.second = true;
     }
+    detail::remove_range(s.second, b, e);
     //Do we need to invalidate?
     if (write) {
         for(typename data_map::iterator i = m_d.begin();
             i != m_d.end();
             i++) {
-            i->second.second = system_variant_equal(i->first, canonical_tag);
+            if (!system_variant_equal(i->first, canonical_tag)) {
+                detail::add_range(i->second.second, b, e);
+            }
         }
     }
     return s.first;
 }
 
 bool cuarray::clean(const system_variant& t) {
-    return m_d[t].second;
+    return m_d[t].second.empty();
+}
+
+bool cuarray::ranged() const {
+    return (m_l.size() == 1) && (m_o == 0);
+}
+
+std::pair<size_t, size_t> cuarray::whole() const {
+    if (ranged()) {
+        return std::make_pair(size_t(0), m_l[0]);
+    }
+    //Other cuarrays are tracked as a single range
+    return std::make_pair(size_t(0), std::numeric_limits<size_t>::max());
+}
+
+std::pair<size_t, size_t> cuarray::byte_range(const chunk& c,
+                                              const std::pair<size_t, size_t>& r) const {
+    if (!ranged() || (m_l[0] == 0)) {
+        return std::make_pair(size_t(0), c.size());
+    }
+    size_t element_size = c.size() / m_l[0];
+    return std::make_pair(r.first * element_size, r.second * element_size);
 }
 
 }
@@ -0,0 +1,134 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+
+#include <prelude/runtime/frame.hpp>
+#include <mutex>
+
+namespace copperhead {
+
+namespace detail {
+
+static __thread frame* t_current_frame = NULL;
+
+frame* current_frame() {
+    return t_current_frame;
+}
+
+frame_scope::frame_scope(frame* f) : m_previous(t_current_frame) {
+    t_current_frame = f;
+}
+
+frame_scope::~frame_scope() {
+    t_current_frame = m_previous;
+}
+
+}
+
+struct frame::lock {
+    std::mutex m_mutex;
+};
+
+frame::frame() : m_lock(new lock()), m_r(0), m_previous(NULL), m_begun(false) {}
+
+frame::~frame() {
+    if (detail::t_current_frame == this) {
+        detail::t_current_frame = m_previous;
+    }
+}
+
+void frame::reserve(size_t r) {
+    m_r += r;
+}
+
+frame::block_map::iterator frame::block(const system_variant& t) {
+    system_variant canonical = canonical_memory_tag(t);
+    block_map::iterator i = m_blocks.find(canonical);
+    if (i != m_blocks.end()) {
+        return i;
+    }
+    boost::shared_ptr<chunk> c(new chunk(canonical, m_r));
+    //The block itself must come from the memory pool
+    frame* current = detail::t_current_frame;
+    detail::t_current_frame = NULL;
+    c->ptr();
+    detail::t_current_frame = current;
+    return m_blocks.insert(
+        std::make_pair(canonical, std::make_pair(c, size_t(0)))).first;
+}
+
+void frame::begin(const system_variant& t) {
+    if (m_r > 0) {
+        block(t);
+    }
+    m_previous = detail::t_current_frame;
+    m_begun = true;
+    detail::t_current_frame = this;
+}
+
+void frame::pause() {
+    if (detail::t_current_frame == this) {
+        detail::t_current_frame = m_previous;
+    }
+}
+
+void frame::resume() {
+    if (m_begun) {
+        detail::t_current_frame = this;
+    }
+}
+
+size_t frame::size() const {
+    return m_r;
+}
+
+void* frame::carve(const system_variant& t, size_t r,
+                   boost::shared_ptr<void>& keep) {
+    if (m_r == 0) {
+        return NULL;
+    }
+    std::lock_guard<std::mutex> guard(m_lock->m_mutex);
+    block_map::iterator i = block(t);
+    size_t& used = i->second.second;
+    size_t aligned =
+        (r + detail::frame_alignment - 1) / detail::frame_alignment *
+        detail::frame_alignment;
+    if (aligned > m_r - used) {
+        return NULL;
+    }
+    void* result = (char*)i->second.first->ptr() + used;
+    used += aligned;
+    keep = i->second.first;
+    return result;
+}
+
+sp_frame make_frame() {
+    return sp_frame(new frame());
+}
+
+void begin_frame(sp_frame& f, const system_variant& t) {
+    f->begin(t);
+}
+
+void pause_frame(sp_frame& f) {
+    f->pause();
+}
+
+void resume_frame(sp_frame& f) {
+    f->resume();
+}
+
+}
@@ -0,0 +1,93 @@
+#include <prelude/runtime/mapped_file.hpp>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace copperhead {
+
+namespace detail {
+
+namespace {
+
+std::runtime_error system_error(const std::string& what,
+                                const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + strerror(errno));
+}
+
+struct unmap {
+    void* m_base;
+    size_t m_length;
+    unmap(void* base, size_t length) : m_base(base), m_length(length) {}
+    void operator()(void*) const {
+        munmap(m_base, m_length);
+    }
+};
+
+}
+
+boost::shared_ptr<void> map_file(const std::string& path,
+                                 size_t o,
+                                 size_t r,
+                                 bool writable) {
+    int fd = open(path.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    if (fd < 0) {
+        throw system_error("Couldn't open", path);
+    }
+    if (writable) {
+        struct stat info;
+        if ((fstat(fd, &info) != 0) ||
+            (((size_t)info.st_size < o + r) && (ftruncate(fd, o + r) != 0))) {
+            close(fd);
+            throw system_error("Couldn't extend", path);
+        }
+    }
+    if (r == 0) {
+        close(fd);
+        return boost::shared_ptr<void>();
+    }
+    //Mappings must start on a page boundary
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t aligned_o = o - o % page;
+    size_t length = r + (o - aligned_o);
+    //A read-only file is mapped copy-on-write, so that the cuarray
+    //can still be written through its chunks without touching the file
+    void* base = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                      writable ? MAP_SHARED : MAP_PRIVATE, fd, aligned_o);
+    //The mapping keeps the file open
+    close(fd);
+    if (base == MAP_FAILED) {
+        throw system_error("Couldn't map", path);
+    }
+    return boost::shared_ptr<void>((char*)base + (o - aligned_o),
+                                   unmap(base, length));
+}
+
+}
+
+void sync(const sp_cuarray& a) {
+    std::vector<boost::shared_ptr<chunk> >& chunks =
+        a->get_chunks(cpp_tag(), false);
+    size_t page = sysconf(_SC_PAGESIZE);
+    for(std::vector<boost::shared_ptr<chunk> >::iterator i = chunks.begin();
+        i != chunks.end();
+        i++) {
+        if ((*i)->size() == 0) {
+            continue;
+        }
+        uintptr_t start = (uintptr_t)(*i)->ptr();
+        uintptr_t aligned_start = start - start % page;
+        //Syncing memory not backed by a file does nothing
+        if (msync((void*)aligned_start, (*i)->size() + (start - aligned_start),
+                  MS_SYNC) != 0) {
+            throw std::runtime_error(std::string("Couldn't sync: ") +
+                                     strerror(errno));
+        }
+    }
+}
+
+}
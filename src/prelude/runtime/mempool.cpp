@@ -1,62 +1,238 @@
 #include <cstdlib>
-#include <map>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <ostream>
+#include <iostream>
 #include <cassert>
+#include <stdint.h>
+#include <pthread.h>
 #include <prelude/runtime/mempool.hpp>
 
 namespace copperhead {
 namespace detail {
 
-// cached_allocator: a simple allocator for caching allocation
+// Requests are rounded up to geometric size classes, four per power
+// of two, so a cached block can serve any request that rounds to the
+// same class, and at most a quarter of a block is wasted.
+// The smallest class is 2^min_bin_shift bytes.
+const int min_bin_shift = 8;
+const int bins_per_octave = 4;
+const int bin_count = (64 - min_bin_shift) * bins_per_octave;
+
+// Number of blocks per size class a thread keeps for itself before
+// returning blocks to the shared central list.
+const size_t thread_cache_depth = 8;
+
+// Allocated blocks are recorded in one of several maps, chosen by
+// address, so that concurrent frees rarely contend.
+const size_t block_shard_count = 64;
+
+// Allocation requests are histogrammed by power of two
+const int histogram_bins = 64;
+
+inline int log2_floor(size_t x) {
+    return (int)(sizeof(unsigned long long) * 8 - 1) -
+        __builtin_clzll((unsigned long long)x);
+}
+
+inline int bin_index(size_t num_bytes) {
+    if (num_bytes <= ((size_t)1 << min_bin_shift)) {
+        return 0;
+    }
+    int octave = log2_floor(num_bytes);
+    size_t quantum = (size_t)1 << (octave - 2);
+    size_t rounded = (num_bytes + quantum - 1) / quantum;
+    //rounded is in [4, 8]; 8 is the first class of the next octave
+    return (octave - min_bin_shift) * bins_per_octave +
+        (int)rounded - bins_per_octave;
+}
+
+inline size_t bin_size(int bin) {
+    int octave = bin / bins_per_octave + min_bin_shift;
+    size_t sub = bin % bins_per_octave;
+    return (bins_per_octave + sub) << (octave - 2);
+}
+
+// cached_allocator: a thread safe allocator for caching allocation
 // requests.  Adapted from thrust's custom_temporary_allocator example
+//
+// Free blocks are binned by size class.  Each thread owns a small
+// cache of free blocks per size class, which it can use without
+// contending with other threads.  When a thread's cache runs dry it
+// refills from a central list shared by all threads, and when it
+// overflows it spills half of its blocks back to the central list.
+//
+// The bytes held in free blocks can be capped.  When a deallocation
+// pushes the cache over its limit, the least recently freed blocks are
+// returned to the system until the cache is back under three quarters
+// of the limit, so that trimming is amortized over many deallocations.
+// Blocks are aged by trimming epoch rather than stamped individually,
+// so that deallocation does not increment a shared clock: every trim
+// starts a new epoch, and blocks freed within one epoch are returned
+// to the system in the order they sit in their free lists.
 template<typename Tag>
 struct cached_allocator
 {
     typedef typename thrust_memory_tag<Tag>::tag thrust_tag;
+
+    struct free_block {
+        void* m_p;
+        //Value of m_epoch when the block was freed
+        size_t m_stamp;
+        free_block(void* p, size_t stamp) : m_p(p), m_stamp(stamp) {}
+    };
+    //Ordered from least to most recently freed
+    typedef std::vector<free_block> free_list;
+    //Maps each allocated block to the number of bytes requested for it
+    typedef std::unordered_map<void*, size_t> allocated_blocks_type;
+
+    //Statistics gathered by one thread.  Only the owning thread
+    //writes them, so they are updated without read-modify-writes;
+    //other threads read them to compute totals.
+    //Blocks may be freed by a different thread than allocated them, so
+    //a thread's byte counts wrap around, but their sum does not.
+    struct counters {
+        std::atomic<size_t> m_live_bytes;
+        std::atomic<size_t> m_requested_bytes;
+        std::atomic<size_t> m_hits;
+        std::atomic<size_t> m_misses;
+        std::atomic<size_t> m_histogram[histogram_bins];
+        counters() : m_live_bytes(0), m_requested_bytes(0),
+                     m_hits(0), m_misses(0) {
+            for(int i = 0; i < histogram_bins; i++) {
+                m_histogram[i] = 0;
+            }
+        }
+    };
+
+    struct thread_cache {
+        cached_allocator* m_owner;
+        //Only contended when another thread flushes all caches
+        std::mutex m_mutex;
+        free_list m_bins[bin_count];
+        counters m_counters;
+        //Bytes freed by this thread since the cache limit was checked
+        size_t m_unchecked_bytes;
+        thread_cache(cached_allocator* owner)
+            : m_owner(owner), m_unchecked_bytes(0) {}
+    };
+
+    struct central_bin {
+        std::mutex m_mutex;
+        free_list m_blocks;
+    };
+
+    struct block_shard {
+        std::mutex m_mutex;
+        allocated_blocks_type m_blocks;
+    };
+
     bool m_live;
-    cached_allocator() : m_live(true) {}
+    pthread_key_t m_key;
+    std::mutex m_caches_mutex;
+    std::vector<thread_cache*> m_caches;
+    central_bin m_central[bin_count];
+    block_shard m_shards[block_shard_count];
 
-    void *allocate(std::ptrdiff_t num_bytes)
+    //Cache trimming
+    std::mutex m_trim_mutex;
+    std::atomic<size_t> m_cache_limit;
+    //Only advanced by the trimmer, so freeing a block merely reads it
+    std::atomic<size_t> m_epoch;
+
+    //Statistics
+    //Per thread counters are kept in the thread caches.  Those of
+    //threads which have exited are accumulated here, under
+    //m_caches_mutex.  The remaining counters only change when memory
+    //is drawn from or returned to the system.
+    counters m_retired;
+    std::atomic<size_t> m_system_bytes;
+    std::atomic<size_t> m_peak_live_bytes;
+    std::atomic<size_t> m_peak_system_bytes;
+    std::atomic<size_t> m_flushes;
+
+    cached_allocator() : m_live(true),
+                         m_cache_limit(std::numeric_limits<size_t>::max()),
+                         m_epoch(0),
+                         m_system_bytes(0), m_peak_live_bytes(0),
+                         m_peak_system_bytes(0), m_flushes(0) {
+        pthread_key_create(&m_key, &cached_allocator::release_cache);
+    }
+
+    void *allocate(size_t num_bytes)
         {
+            int bin = bin_index(num_bytes);
             void *result = 0;
-            
-            // search the cache for a free block
-            free_blocks_type::iterator free_block = free_blocks.find(num_bytes);
 
-            if(free_block != free_blocks.end())
+            // search this thread's cache for a free block
+            thread_cache& local = local_cache();
             {
-                // get the pointer
-                result = free_block->second;
+                std::lock_guard<std::mutex> guard(local.m_mutex);
+                free_list& blocks = local.m_bins[bin];
+                if (!blocks.empty()) {
+                    result = blocks.back().m_p;
+                    blocks.pop_back();
+                }
+            }
 
-                // erase from the free_blocks map
-                free_blocks.erase(free_block);
+            // then the central list for this size class
+            if (result == 0) {
+                central_bin& central = m_central[bin];
+                std::lock_guard<std::mutex> guard(central.m_mutex);
+                if (!central.m_blocks.empty()) {
+                    result = central.m_blocks.back().m_p;
+                    central.m_blocks.pop_back();
+                }
             }
-            else
-            {
-                // no allocation of the right size exists
-                // create a new one with cuda::malloc
-                // throw if cuda::malloc can't satisfy the request
+
+            bool missed = result == 0;
+            if (missed) {
+                // no free block of the right size class exists
+                // create a new one with tag_malloc
+                // throw if tag_malloc can't satisfy the request
+                add(local.m_counters.m_misses, 1);
                 try
                 {
                     result = thrust::detail::tag_malloc(thrust_tag(),
-                                                        num_bytes);
+                                                        bin_size(bin));
                 }
                 catch(std::runtime_error &e)
                 {
                     //Allocation failed
                     //Nuke the cache and try again
+                    m_flushes++;
                     free_free();
-                    
-                    try {
-                        result = thrust::detail::tag_malloc(thrust_tag(),
-                                                            num_bytes);
-                    } catch(std::runtime_error &e) {
-                        throw;
-                    }
+                    result = thrust::detail::tag_malloc(thrust_tag(),
+                                                        bin_size(bin));
                 }
+                update_peak(m_peak_system_bytes,
+                            m_system_bytes += bin_size(bin));
+            } else {
+                add(local.m_counters.m_hits, 1);
             }
 
-            // insert the allocated pointer into the allocated_blocks map
-            allocated_blocks.insert(std::make_pair(result, num_bytes));
+            // record the allocated pointer so deallocate can find its bin
+            block_shard& shard = shard_of(result);
+            {
+                std::lock_guard<std::mutex> guard(shard.m_mutex);
+                shard.m_blocks.insert(std::make_pair(result, num_bytes));
+            }
+
+            add(local.m_counters.m_live_bytes, bin_size(bin));
+            add(local.m_counters.m_requested_bytes, num_bytes);
+            add(local.m_counters.m_histogram[
+                    num_bytes == 0 ? 0 : log2_floor(num_bytes)], 1);
+            if (missed) {
+                //Summing the live bytes of every thread is too costly
+                //for each allocation, so the high water mark is
+                //sampled when memory is drawn from the system, and
+                //when statistics are read
+                update_peak(m_peak_live_bytes, live_bytes());
+            }
 
             return result;
         }
@@ -68,57 +244,425 @@ struct cached_allocator
                 return;
             }
             // erase the allocated block from the allocated blocks map
-            allocated_blocks_type::iterator iter = allocated_blocks.find(ptr);
-            std::ptrdiff_t num_bytes = iter->second;
-            allocated_blocks.erase(iter);
+            size_t num_bytes;
+            block_shard& shard = shard_of(ptr);
+            {
+                std::lock_guard<std::mutex> guard(shard.m_mutex);
+                typename allocated_blocks_type::iterator iter =
+                    shard.m_blocks.find(ptr);
+                assert(iter != shard.m_blocks.end());
+                num_bytes = iter->second;
+                shard.m_blocks.erase(iter);
+            }
+            int bin = bin_index(num_bytes);
+
+            // insert the block into this thread's cache,
+            // spilling to the central list if the cache is full
+            thread_cache& local = local_cache();
+            add(local.m_counters.m_live_bytes, -bin_size(bin));
+            add(local.m_counters.m_requested_bytes, -num_bytes);
+            {
+                std::lock_guard<std::mutex> guard(local.m_mutex);
+                free_list& blocks = local.m_bins[bin];
+                blocks.push_back(
+                    free_block(ptr,
+                               m_epoch.load(std::memory_order_relaxed)));
+                if (blocks.size() > thread_cache_depth) {
+                    spill(blocks, bin, thread_cache_depth / 2);
+                }
+            }
 
-            // insert the block into the free blocks map
-            free_blocks.insert(std::make_pair(num_bytes, ptr));
+            // keep the cache under its limit
+            // summing the live bytes of every thread is not cheap, so
+            // the limit is checked after each thread has freed an
+            // eighth of it
+            size_t limit = m_cache_limit;
+            if (limit == std::numeric_limits<size_t>::max()) {
+                return;
+            }
+            local.m_unchecked_bytes += bin_size(bin);
+            if (local.m_unchecked_bytes <= limit / 8) {
+                return;
+            }
+            local.m_unchecked_bytes = 0;
+            if (cached_bytes() > limit) {
+                //If another thread is already trimming, leave it be
+                std::unique_lock<std::mutex> lock(m_trim_mutex,
+                                                  std::try_to_lock);
+                if (lock.owns_lock()) {
+                    trim_locked(limit - limit / 4);
+                }
+            }
         }
 
     void free_free() {
-        for(free_blocks_type::iterator i = free_blocks.begin();
-            i != free_blocks.end();
-            ++i) {
-            // transform the pointer to cuda::pointer before calling cuda::free
-            thrust::detail::tag_free(thrust_tag(), i->second);
-        }
-        free_blocks.clear();
+        std::lock_guard<std::mutex> guard(m_trim_mutex);
+        release_older(std::numeric_limits<size_t>::max(), 0);
     }
-    
+
+    //Returns the least recently freed blocks to the system
+    //until at most target bytes remain cached
+    void trim(size_t target) {
+        std::lock_guard<std::mutex> guard(m_trim_mutex);
+        trim_locked(target);
+    }
+
+    void set_cache_limit(size_t limit) {
+        m_cache_limit = limit;
+        trim(limit);
+    }
+
 
     void free_all()
         {
             free_free();
-            for(allocated_blocks_type::iterator i = allocated_blocks.begin();
-                i != allocated_blocks.end();
-                ++i)
-            {
-                thrust::detail::tag_free(thrust_tag(), i->first);
+            counters& local = local_cache().m_counters;
+            for(size_t s = 0; s < block_shard_count; s++) {
+                std::lock_guard<std::mutex> guard(m_shards[s].m_mutex);
+                allocated_blocks_type& blocks = m_shards[s].m_blocks;
+                for(typename allocated_blocks_type::iterator i = blocks.begin();
+                    i != blocks.end();
+                    ++i)
+                {
+                    thrust::detail::tag_free(thrust_tag(), i->first);
+                    size_t size = bin_size(bin_index(i->second));
+                    m_system_bytes -= size;
+                    add(local.m_live_bytes, -size);
+                    add(local.m_requested_bytes, -i->second);
+                }
+                blocks.clear();
             }
-            allocated_blocks.clear();
         }
 
     void close() {
-        free_all();
         m_live = false;
+        free_all();
+    }
+
+    mempool_stats stats() {
+        mempool_stats result;
+        result.live_bytes = 0;
+        result.requested_bytes = 0;
+        result.hits = 0;
+        result.misses = 0;
+        result.histogram.resize(histogram_bins, 0);
+        {
+            std::lock_guard<std::mutex> guard(m_caches_mutex);
+            accumulate(m_retired, result);
+            for(typename std::vector<thread_cache*>::iterator i = m_caches.begin();
+                i != m_caches.end();
+                ++i) {
+                accumulate((*i)->m_counters, result);
+            }
+        }
+        size_t system_bytes = m_system_bytes;
+        result.cached_bytes = system_bytes > result.live_bytes ?
+            system_bytes - result.live_bytes : 0;
+        update_peak(m_peak_live_bytes, result.live_bytes);
+        result.peak_live_bytes = m_peak_live_bytes;
+        result.peak_footprint_bytes = m_peak_system_bytes;
+        result.flushes = m_flushes;
+        return result;
+    }
+
+private:
+    block_shard& shard_of(void* ptr) {
+        //Blocks are at least 2^min_bin_shift bytes apart
+        uintptr_t address = (uintptr_t)ptr >> min_bin_shift;
+        return m_shards[address % block_shard_count];
+    }
+
+    thread_cache& local_cache() {
+        thread_cache* cache =
+            static_cast<thread_cache*>(pthread_getspecific(m_key));
+        if (cache == 0) {
+            cache = new thread_cache(this);
+            pthread_setspecific(m_key, cache);
+            std::lock_guard<std::mutex> guard(m_caches_mutex);
+            m_caches.push_back(cache);
+        }
+        return *cache;
+    }
+
+    //Adds to a counter only written by the calling thread
+    static void add(std::atomic<size_t>& counter, size_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value,
+                      std::memory_order_relaxed);
+    }
+
+    static void accumulate(const counters& c, mempool_stats& s) {
+        s.live_bytes += c.m_live_bytes.load(std::memory_order_relaxed);
+        s.requested_bytes +=
+            c.m_requested_bytes.load(std::memory_order_relaxed);
+        s.hits += c.m_hits.load(std::memory_order_relaxed);
+        s.misses += c.m_misses.load(std::memory_order_relaxed);
+        for(int i = 0; i < histogram_bins; i++) {
+            s.histogram[i] +=
+                c.m_histogram[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    //Moves the counters of an exiting thread into m_retired
+    //Must be called with m_caches_mutex held
+    void retire(const counters& c) {
+        add(m_retired.m_live_bytes, c.m_live_bytes);
+        add(m_retired.m_requested_bytes, c.m_requested_bytes);
+        add(m_retired.m_hits, c.m_hits);
+        add(m_retired.m_misses, c.m_misses);
+        for(int i = 0; i < histogram_bins; i++) {
+            add(m_retired.m_histogram[i], c.m_histogram[i]);
+        }
+    }
+
+    size_t live_bytes() {
+        size_t result = 0;
+        std::lock_guard<std::mutex> guard(m_caches_mutex);
+        result += m_retired.m_live_bytes.load(std::memory_order_relaxed);
+        for(typename std::vector<thread_cache*>::iterator i = m_caches.begin();
+            i != m_caches.end();
+            ++i) {
+            result += (*i)->m_counters.m_live_bytes.load(
+                std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    size_t cached_bytes() {
+        size_t system_bytes = m_system_bytes;
+        size_t live = live_bytes();
+        return system_bytes > live ? system_bytes - live : 0;
+    }
+
+    //Must be called with m_trim_mutex held
+    void trim_locked(size_t target) {
+        size_t cached = cached_bytes();
+        if (cached <= target) {
+            return;
+        }
+        //Collect the age and size of every free block
+        std::vector<std::pair<size_t, size_t> > ages;
+        {
+            std::lock_guard<std::mutex> guard(m_caches_mutex);
+            for(typename std::vector<thread_cache*>::iterator i = m_caches.begin();
+                i != m_caches.end();
+                ++i) {
+                std::lock_guard<std::mutex> cache_guard((*i)->m_mutex);
+                for(int bin = 0; bin < bin_count; bin++) {
+                    collect_ages((*i)->m_bins[bin], bin, ages);
+                }
+            }
+        }
+        for(int bin = 0; bin < bin_count; bin++) {
+            std::lock_guard<std::mutex> guard(m_central[bin].m_mutex);
+            collect_ages(m_central[bin].m_blocks, bin, ages);
+        }
+        //Find the oldest epochs which cover the excess.  Of the
+        //youngest of them, only enough blocks to cover the rest of the
+        //excess are released.
+        std::sort(ages.begin(), ages.end());
+        size_t excess = cached - target;
+        size_t cutoff = 0;
+        size_t older = 0;
+        for(std::vector<std::pair<size_t, size_t> >::iterator i = ages.begin();
+            (excess > older) && (i != ages.end());
+            ++i) {
+            if (i->first != cutoff) {
+                excess -= older;
+                older = 0;
+                cutoff = i->first;
+            }
+            older += i->second;
+        }
+        release_older(cutoff, excess);
+        //Blocks freed from now on are younger than all survivors
+        m_epoch.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void collect_ages(const free_list& blocks, int bin,
+                             std::vector<std::pair<size_t, size_t> >& ages) {
+        for(typename free_list::const_iterator i = blocks.begin();
+            i != blocks.end();
+            ++i) {
+            ages.push_back(std::make_pair(i->m_stamp, bin_size(bin)));
+        }
+    }
+
+    //Returns all free blocks freed before epoch cutoff to the system,
+    //and blocks freed during epoch cutoff until budget bytes are freed
+    //Must be called with m_trim_mutex held
+    void release_older(size_t cutoff, size_t budget) {
+        {
+            std::lock_guard<std::mutex> guard(m_caches_mutex);
+            for(typename std::vector<thread_cache*>::iterator i = m_caches.begin();
+                i != m_caches.end();
+                ++i) {
+                std::lock_guard<std::mutex> cache_guard((*i)->m_mutex);
+                for(int bin = 0; bin < bin_count; bin++) {
+                    release_older((*i)->m_bins[bin], bin, cutoff, budget);
+                }
+            }
+        }
+        for(int bin = 0; bin < bin_count; bin++) {
+            std::lock_guard<std::mutex> guard(m_central[bin].m_mutex);
+            release_older(m_central[bin].m_blocks, bin, cutoff, budget);
+        }
     }
-    typedef std::multimap<std::ptrdiff_t, void*> free_blocks_type;
-    typedef std::map<void *, std::ptrdiff_t>     allocated_blocks_type;
 
-    free_blocks_type      free_blocks;
-    allocated_blocks_type allocated_blocks;
+    void release_older(free_list& blocks, int bin, size_t cutoff,
+                       size_t& budget) {
+        typename free_list::iterator kept = blocks.begin();
+        for(typename free_list::iterator i = blocks.begin();
+            i != blocks.end();
+            ++i) {
+            bool release = i->m_stamp < cutoff;
+            if (!release && i->m_stamp == cutoff && budget > 0) {
+                budget -= std::min(budget, bin_size(bin));
+                release = true;
+            }
+            if (release) {
+                thrust::detail::tag_free(thrust_tag(), i->m_p);
+                m_system_bytes -= bin_size(bin);
+            } else {
+                *kept++ = *i;
+            }
+        }
+        blocks.erase(kept, blocks.end());
+    }
+
+    //Moves all but the newest keep blocks to the central list
+    void spill(free_list& blocks, int bin, size_t keep) {
+        central_bin& central = m_central[bin];
+        std::lock_guard<std::mutex> guard(central.m_mutex);
+        central.m_blocks.insert(central.m_blocks.end(),
+                                blocks.begin(),
+                                blocks.end() - keep);
+        blocks.erase(blocks.begin(), blocks.end() - keep);
+    }
+
+    static void update_peak(std::atomic<size_t>& peak, size_t value) {
+        size_t current = peak;
+        while(value > current &&
+              !peak.compare_exchange_weak(current, value)) {}
+    }
+
+    //Called by pthreads when a thread exits
+    //Returns the thread's cached blocks to the central lists
+    static void release_cache(void* p) {
+        thread_cache* cache = static_cast<thread_cache*>(p);
+        cached_allocator* owner = cache->m_owner;
+        {
+            std::lock_guard<std::mutex> guard(owner->m_caches_mutex);
+            typename std::vector<thread_cache*>::iterator i =
+                std::find(owner->m_caches.begin(), owner->m_caches.end(), cache);
+            if (i != owner->m_caches.end()) {
+                owner->m_caches.erase(i);
+            }
+            owner->retire(cache->m_counters);
+        }
+        for(int bin = 0; bin < bin_count; bin++) {
+            owner->spill(cache->m_bins[bin], bin, 0);
+        }
+        delete cache;
+    }
 };
 
 
-//XXX Need to protect access to these with mutex
 cached_allocator<cpp_tag> g_cpp_allocator;
 
-//XXX Need to protect access to these with mutex
 #ifdef CUDA_SUPPORT
 cached_allocator<cuda_tag> g_cuda_allocator;
 #endif
 
+//Finds the allocator responsible for a canonical memory space
+template<typename Tag>
+struct allocator_of {};
+
+template<>
+struct allocator_of<cpp_tag> {
+    static cached_allocator<cpp_tag>& get() {
+        return g_cpp_allocator;
+    }
+};
+
+#ifdef CUDA_SUPPORT
+template<>
+struct allocator_of<cuda_tag> {
+    static cached_allocator<cuda_tag>& get() {
+        return g_cuda_allocator;
+    }
+};
+#endif
+
+struct apply_stats
+    : public boost::static_visitor<mempool_stats> {
+    template<typename Tag>
+    mempool_stats operator()(const Tag&) const {
+        typedef typename canonical_memory_tag<Tag>::tag canonical_tag;
+        return allocator_of<canonical_tag>::get().stats();
+    }
+};
+
+struct apply_trim
+    : public boost::static_visitor<> {
+    size_t m_target;
+    apply_trim(size_t target) : m_target(target) {}
+    template<typename Tag>
+    void operator()(const Tag&) const {
+        typedef typename canonical_memory_tag<Tag>::tag canonical_tag;
+        allocator_of<canonical_tag>::get().trim(m_target);
+    }
+};
+
+struct apply_set_cache_limit
+    : public boost::static_visitor<> {
+    size_t m_limit;
+    apply_set_cache_limit(size_t limit) : m_limit(limit) {}
+    template<typename Tag>
+    void operator()(const Tag&) const {
+        typedef typename canonical_memory_tag<Tag>::tag canonical_tag;
+        allocator_of<canonical_tag>::get().set_cache_limit(m_limit);
+    }
+};
+
+void print_stats(std::ostream& o, const system_variant& t) {
+    mempool_stats s = get_stats(t);
+    o << to_string(copperhead::canonical_memory_tag(t)) << " memory pool:" << std::endl;
+    o << "  live bytes:      " << s.live_bytes
+      << " (" << s.requested_bytes << " requested)" << std::endl;
+    o << "  cached bytes:    " << s.cached_bytes << std::endl;
+    o << "  peak live bytes: " << s.peak_live_bytes << std::endl;
+    o << "  peak footprint:  " << s.peak_footprint_bytes << std::endl;
+    o << "  hits:            " << s.hits << std::endl;
+    o << "  misses:          " << s.misses << std::endl;
+    o << "  flushes:         " << s.flushes << std::endl;
+    o << "  allocation sizes:" << std::endl;
+    for(size_t i = 0; i < s.histogram.size(); i++) {
+        if (s.histogram[i] != 0) {
+            o << "    [2^" << i << ", 2^" << i + 1 << "): "
+              << s.histogram[i] << std::endl;
+        }
+    }
+}
+
+}
+
+mempool_stats get_stats(const system_variant& t) {
+    return boost::apply_visitor(detail::apply_stats(), t);
+}
+
+void trim(const system_variant& t, size_t bytes) {
+    boost::apply_visitor(detail::apply_trim(bytes), t);
+}
+
+void set_cache_limit(const system_variant& t, size_t bytes) {
+    boost::apply_visitor(detail::apply_set_cache_limit(bytes), t);
+}
+
+void print_stats(std::ostream& o) {
+    detail::print_stats(o, cpp_tag());
+    #ifdef CUDA_SUPPORT
+    detail::print_stats(o, cuda_tag());
+    #endif
 }
 
 void* malloc(cpp_tag, size_t cnt) {
@@ -139,7 +683,10 @@ void free(cuda_tag, void* ptr) {
 }
 #endif
 
-void take_down() {
+void take_down(bool print) {
+    if (print) {
+        print_stats(std::cerr);
+    }
     detail::g_cpp_allocator.close();
     #ifdef CUDA_SUPPORT
     detail::g_cuda_allocator.close();
@@ -0,0 +1,193 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ * 
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ * 
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ * 
+ */
+
+#include <prelude/runtime/task.hpp>
+#include <prelude/runtime/frame.hpp>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <utility>
+#include <cstdlib>
+
+namespace copperhead {
+
+namespace detail {
+
+struct task_state::impl {
+    std::mutex m_mutex;
+    std::condition_variable m_done;
+    bool m_ready;
+    std::exception_ptr m_error;
+    impl() : m_ready(false) {}
+};
+
+//Threads which run spawned computations.  The pool is never
+//destroyed, so computations still queued at exit are abandoned
+//rather than racing with static destructors.
+class worker_pool {
+private:
+    typedef std::pair<boost::shared_ptr<task_state>,
+                      boost::function<void()> > work;
+    std::mutex m_mutex;
+    std::condition_variable m_work;
+    std::deque<work> m_queue;
+    size_t m_threads;
+
+    void serve() {
+        while(true) {
+            work w;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_work.wait(lock, [this]{ return !m_queue.empty(); });
+                w = m_queue.front();
+                m_queue.pop_front();
+            }
+            w.first->run(w.second);
+        }
+    }
+public:
+    explicit worker_pool(size_t threads) : m_threads(threads) {
+        for(size_t i = 0; i < threads; i++) {
+            std::thread(&worker_pool::serve, this).detach();
+        }
+    }
+
+    void submit(const boost::shared_ptr<task_state>& s,
+                const boost::function<void()>& f) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push_back(work(s, f));
+        }
+        m_work.notify_one();
+    }
+
+    size_t threads() const {
+        return m_threads;
+    }
+
+    //Runs one queued computation on the calling thread, if any.
+    //Threads waiting for results help, so a computation which
+    //itself waits can't starve the pool.
+    bool run_one() {
+        work w;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_queue.empty()) {
+                return false;
+            }
+            w = m_queue.front();
+            m_queue.pop_front();
+        }
+        w.first->run(w.second);
+        return true;
+    }
+};
+
+static worker_pool& get_pool() {
+    //The number of threads can be set with COPPERHEAD_TASK_THREADS,
+    //and defaults to one per hardware thread
+    static worker_pool* pool = [] {
+        size_t threads = std::thread::hardware_concurrency();
+        const char* n = std::getenv("COPPERHEAD_TASK_THREADS");
+        if (n != NULL && std::atoi(n) > 0) {
+            threads = std::atoi(n);
+        }
+        return new worker_pool(threads > 0 ? threads : 1);
+    }();
+    return *pool;
+}
+
+task_state::task_state() : m_impl(new impl()) {}
+
+void task_state::run(const boost::function<void()>& f) {
+    std::exception_ptr error;
+    try {
+        f();
+    } catch(...) {
+        error = std::current_exception();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+        m_impl->m_error = error;
+        m_impl->m_ready = true;
+    }
+    m_impl->m_done.notify_all();
+}
+
+void task_state::wait() const {
+    while(!ready() && get_pool().run_one()) {
+    }
+    std::unique_lock<std::mutex> lock(m_impl->m_mutex);
+    m_impl->m_done.wait(lock, [this]{ return m_impl->m_ready; });
+    if (m_impl->m_error) {
+        std::rethrow_exception(m_impl->m_error);
+    }
+}
+
+bool task_state::ready() const {
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return m_impl->m_ready;
+}
+
+//Runs a computation with the frame which was current where it was
+//spawned, and no other.  Temporaries of spawned primitives come from
+//the frame planned for them, and a thread which runs computations
+//while it waits doesn't carve theirs from its own frame.
+struct in_frame {
+    sp_frame m_frame;
+    boost::function<void()> m_f;
+    in_frame(const sp_frame& fr, const boost::function<void()>& f)
+        : m_frame(fr), m_f(f) {}
+    void operator()() const {
+        frame_scope scope(m_frame.get());
+        m_f();
+    }
+};
+
+void submit(const boost::shared_ptr<task_state>& s,
+            const boost::function<void()>& f) {
+    frame* current = current_frame();
+    get_pool().submit(
+        s, in_frame(current ? current->shared_from_this() : sp_frame(), f));
+}
+
+void wait_all(const std::vector<boost::shared_ptr<task_state> >& s) {
+    std::exception_ptr error;
+    for(size_t i = 0; i < s.size(); i++) {
+        try {
+            s[i]->wait();
+        } catch(...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+size_t worker_count() {
+    return get_pool().threads();
+}
+
+}
+
+}
@@ -0,0 +1,134 @@
+#include "procedure_cache.hpp"
+#include "structural_hash.hpp"
+#include "rewriter.hpp"
+#include <unordered_set>
+#include <algorithm>
+#include <sstream>
+
+namespace backend {
+
+namespace detail {
+
+//Records every identifier referenced within a procedure
+class reference_finder
+    : public rewriter<reference_finder> {
+private:
+    std::unordered_set<symbol> m_refs;
+public:
+    using rewriter<reference_finder>::operator();
+
+    result_type operator()(const name &n) {
+        m_refs.insert(n.sym());
+        return n.ptr();
+    }
+
+    const std::unordered_set<symbol>& refs() const {
+        return m_refs;
+    }
+};
+
+}
+
+std::vector<std::vector<std::size_t> > transitive_callees(const suite& n) {
+    std::unordered_map<symbol, std::size_t> positions;
+    std::vector<const statement*> stmts;
+    for(auto i = n.begin(); i != n.end(); i++) {
+        if (detail::isinstance<procedure>(*i)) {
+            const procedure& p = boost::get<const procedure&>(*i);
+            positions.insert(std::make_pair(p.id().sym(), stmts.size()));
+        }
+        stmts.push_back(&*i);
+    }
+    //Direct callees.  Any reference to a procedure's name counts,
+    //whether it is called or passed as a function object.  A local
+    //which shadows a procedure's name adds a spurious dependence,
+    //which costs reuse but never correctness.
+    std::vector<std::vector<std::size_t> > direct(stmts.size());
+    for(std::size_t i = 0; i < stmts.size(); i++) {
+        detail::reference_finder rf;
+        boost::apply_visitor(rf, *stmts[i]);
+        for(auto j = rf.refs().begin(); j != rf.refs().end(); j++) {
+            auto k = positions.find(*j);
+            if (k != positions.end() && k->second != i) {
+                direct[i].push_back(k->second);
+            }
+        }
+    }
+    std::vector<std::vector<std::size_t> > result(stmts.size());
+    for(std::size_t i = 0; i < stmts.size(); i++) {
+        std::vector<bool> seen(stmts.size(), false);
+        std::vector<std::size_t> work(direct[i]);
+        seen[i] = true;
+        while(!work.empty()) {
+            std::size_t j = work.back();
+            work.pop_back();
+            if (seen[j]) {
+                continue;
+            }
+            seen[j] = true;
+            result[i].push_back(j);
+            work.insert(work.end(), direct[j].begin(), direct[j].end());
+        }
+        std::sort(result[i].begin(), result[i].end());
+    }
+    return result;
+}
+
+procedure_cache::procedure_cache()
+    : m_hits(0), m_misses(0) {}
+
+std::vector<std::uint64_t> procedure_cache::keys(
+    const suite& n,
+    const std::vector<std::vector<std::size_t> >& callees,
+    const copperhead::system_variant& t) {
+    //Each statement is hashed once, then keys combine the hashes
+    std::vector<std::uint64_t> hashes;
+    for(auto i = n.begin(); i != n.end(); i++) {
+        hashes.push_back(structural_hash(*i, t));
+    }
+    std::vector<std::uint64_t> result;
+    for(std::size_t i = 0; i < hashes.size(); i++) {
+        structural_hasher h(t);
+        std::ostringstream os;
+        os << hashes[i];
+        for(auto j = callees[i].begin(); j != callees[i].end(); j++) {
+            os << ' ' << hashes[*j];
+        }
+        h(os.str());
+        result.push_back(h.value());
+    }
+    return result;
+}
+
+bool procedure_cache::lookup(std::uint64_t key, fragment& f) {
+    auto i = m_fragments.find(key);
+    if (i == m_fragments.end()) {
+        m_misses++;
+        return false;
+    }
+    m_hits++;
+    f = i->second;
+    return true;
+}
+
+void procedure_cache::store(std::uint64_t key, const fragment& f) {
+    m_fragments[key] = f;
+}
+
+void procedure_cache::clear() {
+    m_fragments.clear();
+}
+
+std::size_t procedure_cache::size() const {
+    return m_fragments.size();
+}
+
+std::size_t procedure_cache::hits() const {
+    return m_hits;
+}
+
+std::size_t procedure_cache::misses() const {
+    return m_misses;
+}
+
+}
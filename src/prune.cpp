@@ -3,7 +3,6 @@
 #include <algorithm>
 
 using std::shared_ptr;
-using std::make_shared;
 using std::static_pointer_cast;
 using std::vector;
 using std::reverse;
@@ -16,8 +15,8 @@ namespace detail {
 class protector :
         public rewriter<protector> {
 private:
-    environment<string> m_declared;
-    environment<string> m_modified;
+    environment<symbol> m_declared;
+    environment<symbol> m_modified;
 public:
     using rewriter<protector>::operator();
 
@@ -27,7 +26,7 @@ public:
             i++) {
             assert(detail::isinstance<name>(*i));
             const name& arg_name = boost::get<const name&>(*i);
-            m_declared.insert(arg_name.id());
+            m_declared.insert(arg_name.sym());
         }
         return rewriter<protector>::operator()(p);
     }
@@ -35,15 +34,15 @@ public:
     result_type operator()(const bind &b) {
         assert(detail::isinstance<name>(b.lhs()));
         const name& lhs = boost::get<const name&>(b.lhs());
-        if (m_declared.exists(lhs.id())) {
-            m_modified.insert(lhs.id());
+        if (m_declared.exists(lhs.sym())) {
+            m_modified.insert(lhs.sym());
         } else {
-            m_declared.insert(lhs.id());
+            m_declared.insert(lhs.sym());
         }
         return b.ptr();
     }
     
-    const environment<string>& modified() const {
+    const environment<symbol>& modified() const {
         return m_modified;
     }
     
@@ -64,11 +63,11 @@ prune::result_type prune::operator()(const suite& n) {
         }
     } while (i != n.begin());
     reverse(stmts.begin(), stmts.end());
-    return make_shared<const suite>(move(stmts));
+    return make_node<const suite>(move(stmts));
 }
 
 prune::result_type prune::operator()(const name& n) {
-    m_used.insert(n.id());
+    m_used.insert(n.sym());
     return n.ptr();
 }
 
@@ -78,8 +77,8 @@ prune::result_type prune::operator()(const bind& n) {
             boost::apply_visitor(*this, n.rhs()));
     assert(detail::isinstance<name>(n.lhs()));
     const name& lhs = boost::get<const name&>(n.lhs());
-    if (m_used.exists(lhs.id()) ||
-        m_protected.exists(lhs.id())) {
+    if (m_used.exists(lhs.sym()) ||
+        m_protected.exists(lhs.sym())) {
         return n.ptr();
     } else {
         return prune::result_type();
@@ -0,0 +1,219 @@
+#include "recycle.hpp"
+#include "utility/initializers.hpp"
+#include "utility/snippets.hpp"
+#include <algorithm>
+
+using std::shared_ptr;
+using std::static_pointer_cast;
+using std::vector;
+using std::string;
+using backend::utility::make_vector;
+
+namespace backend {
+
+recycle::recycle(const string& entry_point)
+    : m_entry_point(entry_point), m_body(nullptr) {}
+
+//The argument of a primitive which has an in place variant that
+//reuses its storage, or -1 if it has none
+static int operand(const apply& n) {
+    const string& fn = n.fn().id();
+    if (((fn == "sort") || (fn == "scan")) && (n.args().arity() == 2)) {
+        return 1;
+    }
+    if ((fn == "scatter") && (n.args().arity() == 3)) {
+        return 2;
+    }
+    return -1;
+}
+
+//If v = make_sequence<...>(a, tag, true), returns a
+static const name* viewed(const statement& s) {
+    if (!detail::isinstance<bind>(s)) {
+        return nullptr;
+    }
+    const bind& b = boost::get<const bind&>(s);
+    if (!detail::isinstance<apply>(b.rhs())) {
+        return nullptr;
+    }
+    const apply& a = boost::get<const apply&>(b.rhs());
+    if ((a.fn().id() != detail::make_sequence()) ||
+        (a.args().arity() != 3)) {
+        return nullptr;
+    }
+    auto arg = a.args().begin();
+    const expression& ary = *arg;
+    arg++;
+    arg++;
+    if (!detail::isinstance<name>(ary) ||
+        !detail::isinstance<literal>(*arg) ||
+        (boost::get<const literal&>(*arg).id() != "true")) {
+        return nullptr;
+    }
+    return &boost::get<const name&>(ary);
+}
+
+//True if the statements after i only view existing storage before
+//the entry point returns, so releasing storage after statement i
+//would not let anything reuse it
+static bool returns_after(const suite& n, int i) {
+    for(auto j = n.begin() + i + 1; j != n.end(); j++) {
+        if (detail::isinstance<ret>(*j)) {
+            return true;
+        }
+        if (!detail::isinstance<bind>(*j)) {
+            return false;
+        }
+        const bind& b = boost::get<const bind&>(*j);
+        if (!detail::isinstance<apply>(b.rhs()) ||
+            (boost::get<const apply&>(b.rhs()).fn().id() !=
+             detail::make_sequence())) {
+            return false;
+        }
+    }
+    return false;
+}
+
+shared_ptr<const statement> recycle::in_place(const liveness& l,
+                                              const suite& n,
+                                              int i) {
+    const statement& s = *(n.begin() + i);
+    if (!detail::isinstance<bind>(s)) {
+        return s.ptr();
+    }
+    const bind& b = boost::get<const bind&>(s);
+    if (!detail::isinstance<apply>(b.rhs())) {
+        return s.ptr();
+    }
+    const apply& a = boost::get<const apply&>(b.rhs());
+    int op = operand(a);
+    if (op == -1) {
+        return s.ptr();
+    }
+    const expression& x = *(a.args().begin() + op);
+    if (!detail::isinstance<name>(x)) {
+        return s.ptr();
+    }
+    const symbol& v = boost::get<const name&>(x).sym();
+    int def = l.definition(v);
+    if (def == -1) {
+        return s.ptr();
+    }
+    const name* ary = viewed(*(n.begin() + def));
+    if ((ary == nullptr) ||
+        !l.fresh(ary->sym()) ||
+        (l.last_use(ary->sym()) != i)) {
+        return s.ptr();
+    }
+    //The other arguments must not see the storage being overwritten
+    int index = 0;
+    for(auto j = a.args().begin(); j != a.args().end(); j++, index++) {
+        if (index == op) {
+            continue;
+        }
+        detail::binding_finder bf;
+        boost::apply_visitor(bf, *j);
+        for(auto k = bf.read().begin(); k != bf.read().end(); k++) {
+            if ((*k == v) || (*k == ary->sym()) ||
+                l.holds(*k, ary->sym())) {
+                return s.ptr();
+            }
+        }
+    }
+    vector<shared_ptr<const expression> > args;
+    for(auto j = a.args().begin(); j != a.args().end(); j++) {
+        args.push_back(j->ptr());
+    }
+    args.push_back(ary->ptr());
+    return make_node<const bind>(
+        b.lhs().ptr(),
+        make_node<const apply>(
+            make_node<const name>(a.fn().id() + "_in_place"),
+            make_node<const tuple>(std::move(args))));
+}
+
+shared_ptr<const suite> recycle::release(const suite& n) {
+    liveness l(n);
+    //Statements after which each cuarray is released
+    vector<vector<shared_ptr<const name> > > releases(l.size());
+    int index = 0;
+    for(auto i = n.begin(); i != n.end(); i++, index++) {
+        if (!detail::isinstance<bind>(*i)) {
+            continue;
+        }
+        const bind& b = boost::get<const bind&>(*i);
+        if (!detail::isinstance<name>(b.lhs())) {
+            continue;
+        }
+        //Releasing a cuarray only drops a reference, so one which
+        //shares its storage with others may be released as well
+        const name& lhs = boost::get<const name&>(b.lhs());
+        if (!detail::isinstance<ctype::cuarray_t>(lhs.ctype()) ||
+            (l.definition(lhs.sym()) != index)) {
+            continue;
+        }
+        //Unused results are removed by prune, and returned ones
+        //must outlive the entry point.  Storage still held when the
+        //entry point returns is released anyway.
+        int last = l.last_use(lhs.sym());
+        if ((last == -1) || detail::isinstance<ret>(*(n.begin() + last))) {
+            continue;
+        }
+        int after = std::max(last, index);
+        if (returns_after(n, after)) {
+            continue;
+        }
+        releases[after].push_back(lhs.ptr());
+    }
+    bool match = true;
+    vector<shared_ptr<const statement> > stmts;
+    index = 0;
+    for(auto i = n.begin(); i != n.end(); i++, index++) {
+        stmts.push_back(i->ptr());
+        for(auto j = releases[index].begin(); j != releases[index].end(); j++) {
+            match = false;
+            stmts.push_back(
+                make_node<const call>(
+                    make_node<const apply>(
+                        make_node<const name>("release"),
+                        make_node<const tuple>(
+                            make_vector<shared_ptr<const expression> >(*j)))));
+        }
+    }
+    if (match) {
+        return n.ptr();
+    }
+    return make_node<const suite>(std::move(stmts));
+}
+
+recycle::result_type recycle::operator()(const procedure& n) {
+    if (n.id().id() != m_entry_point) {
+        return n.ptr();
+    }
+    m_body = &n.stmts();
+    result_type result = this->rewriter<recycle>::operator()(n);
+    m_body = nullptr;
+    return result;
+}
+
+recycle::result_type recycle::operator()(const suite& n) {
+    if (&n != m_body) {
+        return this->rewriter<recycle>::operator()(n);
+    }
+    //A result computed in place takes over storage which is dead
+    //from then on, so liveness from before the rewrites stays valid
+    liveness l(n);
+    bool match = true;
+    vector<shared_ptr<const statement> > stmts;
+    for(int i = 0; i < int(l.size()); i++) {
+        shared_ptr<const statement> s = in_place(l, n, i);
+        match = match && (s == (n.begin() + i)->ptr());
+        stmts.push_back(s);
+    }
+    if (match) {
+        return release(n);
+    }
+    return release(*make_node<const suite>(std::move(stmts)));
+}
+
+}
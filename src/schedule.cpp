@@ -0,0 +1,306 @@
+#include "schedule.hpp"
+#include "utility/initializers.hpp"
+#include "utility/name_supply.hpp"
+#include "utility/up_get.hpp"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <unordered_map>
+
+using std::shared_ptr;
+using std::static_pointer_cast;
+using std::vector;
+using std::string;
+using std::unordered_map;
+using std::unordered_set;
+using backend::utility::make_vector;
+
+namespace backend {
+
+namespace detail {
+
+//Primitives the prelude provides a _task function object for
+const char* const spawnable[] = {
+    "phase_boundary",
+    "sort",
+    "scan",
+    "rscan",
+    "exclusive_scan",
+    "exclusive_rscan",
+    "filter",
+    "permute",
+    "scatter",
+    "adjacent_difference",
+    "reduce",
+    "sum",
+    "reduce2",
+    "segmented_map1",
+    "segmented_scan",
+    "segmented_rscan",
+    "segmented_exclusive_scan",
+    "segmented_reduce",
+    "segmented_sum"
+};
+
+//Largest number of arguments spawn() accepts
+const int max_spawn_arity = 6;
+
+//Runtime calls which only affect the calling thread
+const char* const thread_local_calls[] = {
+    "reserve",
+    "begin_frame",
+    "pause_frame",
+    "resume_frame"
+};
+
+}
+
+schedule::schedule(const string& entry_point, bool enabled)
+    : m_entry_point(entry_point), m_enabled(enabled) {}
+
+//The function a statement calls, or the empty string
+static string called(const statement& s) {
+    if (detail::isinstance<call>(s)) {
+        return boost::get<const call&>(s).sub().fn().id();
+    }
+    if (detail::isinstance<bind>(s)) {
+        const bind& b = boost::get<const bind&>(s);
+        if (detail::isinstance<apply>(b.rhs())) {
+            return boost::get<const apply&>(b.rhs()).fn().id();
+        }
+    }
+    return string();
+}
+
+static bool in_place(const statement& s) {
+    return detail::isinstance<bind>(s) &&
+        (called(s).find("_in_place") != string::npos);
+}
+
+bool schedule::heavy(const statement& s) const {
+    if (!detail::isinstance<bind>(s)) {
+        return false;
+    }
+    const bind& b = boost::get<const bind&>(s);
+    if (!detail::isinstance<name>(b.lhs()) ||
+        !detail::isinstance<apply>(b.rhs())) {
+        return false;
+    }
+    if (detail::isinstance<ctype::monotype_t>(b.lhs().ctype()) &&
+        (detail::up_get<ctype::monotype_t>(b.lhs().ctype()).name() == "void")) {
+        return false;
+    }
+    const apply& a = boost::get<const apply&>(b.rhs());
+    if (a.args().arity() > detail::max_spawn_arity) {
+        return false;
+    }
+    const string& fn = a.fn().id();
+    return std::find(std::begin(detail::spawnable),
+                     std::end(detail::spawnable),
+                     fn) != std::end(detail::spawnable);
+}
+
+vector<shared_ptr<const statement> > schedule::reorder(const suite& n) const {
+    liveness l(n);
+    vector<const statement*> stmts;
+    for(auto i = n.begin(); i != n.end(); i++) {
+        stmts.push_back(&*i);
+    }
+    //Binds of names bound nowhere else, which allocate rather than
+    //update storage, can be moved past each other as long as
+    //dependences are respected
+    auto movable = [&](size_t i) {
+        if (!detail::isinstance<bind>(*stmts[i]) || in_place(*stmts[i])) {
+            return false;
+        }
+        const bind& b = boost::get<const bind&>(*stmts[i]);
+        return detail::isinstance<name>(b.lhs()) &&
+            (l.definition(boost::get<const name&>(b.lhs()).sym()) == int(i));
+    };
+    vector<shared_ptr<const statement> > result;
+    size_t i = 0;
+    while(i < stmts.size()) {
+        if (!movable(i)) {
+            result.push_back(stmts[i]->ptr());
+            i++;
+            continue;
+        }
+        size_t j = i;
+        while((j < stmts.size()) && movable(j)) {
+            j++;
+        }
+        //Each statement goes after the primitives it depends on,
+        //so those with the fewest primitives before them come first
+        unordered_map<symbol, size_t> definitions;
+        vector<int> depths;
+        vector<size_t> order;
+        for(size_t k = i; k < j; k++) {
+            int depth = 0;
+            const unordered_set<symbol>& reads = l.read(k);
+            for(auto r = reads.begin(); r != reads.end(); r++) {
+                auto d = definitions.find(*r);
+                if (d != definitions.end()) {
+                    depth = std::max(depth,
+                                     depths[d->second - i] +
+                                     (heavy(*stmts[d->second]) ? 1 : 0));
+                }
+            }
+            depths.push_back(depth);
+            order.push_back(k);
+            const bind& b = boost::get<const bind&>(*stmts[k]);
+            definitions[boost::get<const name&>(b.lhs()).sym()] = k;
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t x, size_t y) {
+                             return depths[x - i] < depths[y - i];
+                         });
+        for(auto k = order.begin(); k != order.end(); k++) {
+            result.push_back(stmts[*k]->ptr());
+        }
+        i = j;
+    }
+    return result;
+}
+
+schedule::result_type schedule::operator()(const procedure& n) {
+    if (!m_enabled || (n.id().id() != m_entry_point)) {
+        return n.ptr();
+    }
+    shared_ptr<const suite> body =
+        make_node<const suite>(reorder(n.stmts()));
+    liveness l(*body);
+    vector<const statement*> stmts;
+    for(auto i = body->begin(); i != body->end(); i++) {
+        stmts.push_back(&*i);
+    }
+    auto lhs = [&](size_t k) {
+        return boost::get<const name&>(
+            boost::get<const bind&>(*stmts[k]).lhs()).sym();
+    };
+    //Find where each primitive's result must be waited for
+    size_t size = stmts.size();
+    vector<size_t> join_at(size, size);
+    vector<size_t> pending;
+    for(size_t i = 0; i < size; i++) {
+        const statement& s = *stmts[i];
+        const string fn = called(s);
+        std::function<bool(size_t)> needs;
+        if (detail::isinstance<bind>(s) && !in_place(s)) {
+            needs = [&, i](size_t k) { return l.read(i).count(lhs(k)) != 0; };
+        } else if (detail::isinstance<call>(s) && (fn == "release")) {
+            //Wait for everything reading the storage being released
+            const tuple& args = boost::get<const call&>(s).sub().args();
+            symbol released =
+                boost::get<const name&>(*args.begin()).sym();
+            needs = [&, released](size_t k) {
+                const unordered_set<symbol>& reads = l.read(k);
+                for(auto r = reads.begin(); r != reads.end(); r++) {
+                    if ((*r == released) || l.holds(*r, released)) {
+                        return true;
+                    }
+                }
+                return false;
+            };
+        } else if (detail::isinstance<call>(s) &&
+                   (std::find(std::begin(detail::thread_local_calls),
+                              std::end(detail::thread_local_calls),
+                              fn) != std::end(detail::thread_local_calls))) {
+            needs = [](size_t) { return false; };
+        } else {
+            needs = [](size_t) { return true; };
+        }
+        vector<size_t> still_pending;
+        for(auto k = pending.begin(); k != pending.end(); k++) {
+            if (needs(*k)) {
+                join_at[*k] = i;
+            } else {
+                still_pending.push_back(*k);
+            }
+        }
+        pending.swap(still_pending);
+        if (heavy(s)) {
+            pending.push_back(i);
+        }
+    }
+    //Spawning only pays if another primitive starts meanwhile
+    vector<bool> spawned(size, false);
+    bool any = false;
+    for(size_t k = 0; k < size; k++) {
+        if (!heavy(*stmts[k])) {
+            continue;
+        }
+        for(size_t m = k + 1; m < join_at[k]; m++) {
+            if (heavy(*stmts[m])) {
+                spawned[k] = true;
+                any = true;
+                break;
+            }
+        }
+    }
+    if (!any) {
+        return n.ptr();
+    }
+    detail::name_supply supply("task");
+    vector<shared_ptr<const name> > futures(size);
+    vector<shared_ptr<const statement> > result;
+    auto joins = [&](size_t i) {
+        for(size_t k = 0; k < size; k++) {
+            if (spawned[k] && (join_at[k] == i)) {
+                const bind& b = boost::get<const bind&>(*stmts[k]);
+                result.push_back(
+                    make_node<const bind>(
+                        b.lhs().ptr(),
+                        make_node<const apply>(
+                            make_node<const name>("join"),
+                            make_node<const tuple>(
+                                make_vector<shared_ptr<const expression> >(
+                                    futures[k])))));
+            }
+        }
+    };
+    for(size_t i = 0; i < size; i++) {
+        joins(i);
+        if (!spawned[i]) {
+            result.push_back(stmts[i]->ptr());
+            continue;
+        }
+        const bind& b = boost::get<const bind&>(*stmts[i]);
+        const apply& a = boost::get<const apply&>(b.rhs());
+        futures[i] = make_node<const name>(
+            supply.next(),
+            b.lhs().type().ptr(),
+            make_node<const ctype::polytype_t>(
+                make_vector<shared_ptr<const ctype::type_t> >(
+                    b.lhs().ctype().ptr()),
+                make_node<const ctype::monotype_t>("future")));
+        vector<shared_ptr<const expression> > args;
+        args.push_back(
+            make_node<const apply>(
+                make_node<const templated_name>(
+                    a.fn().id() + "_task",
+                    make_node<const ctype::tuple_t>(
+                        make_vector<shared_ptr<const ctype::type_t> >(
+                            b.lhs().ctype().ptr()))),
+                make_node<const tuple>(
+                    make_vector<shared_ptr<const expression> >())));
+        for(auto j = a.args().begin(); j != a.args().end(); j++) {
+            args.push_back(j->ptr());
+        }
+        result.push_back(
+            make_node<const bind>(
+                futures[i],
+                make_node<const apply>(
+                    make_node<const name>("spawn"),
+                    make_node<const tuple>(std::move(args)))));
+    }
+    joins(size);
+    return make_node<const procedure>(
+        n.id().ptr(),
+        n.args().ptr(),
+        make_node<const suite>(std::move(result)),
+        n.type().ptr(),
+        n.ctype().ptr(),
+        n.place());
+}
+
+}
@@ -0,0 +1,204 @@
+#include "segment.hpp"
+#include "utility/isinstance.hpp"
+#include "utility/initializers.hpp"
+
+using std::shared_ptr;
+using std::static_pointer_cast;
+using std::vector;
+using std::string;
+using backend::utility::make_vector;
+
+namespace backend {
+
+namespace detail {
+
+//Primitives with a segmented version, and where they take the
+//sequence they map, scan or reduce
+const struct {
+    const char* fn;
+    int seq;
+    int arity;
+} segmentable[] = {
+    {"map1", 1, 2},
+    {"scan", 1, 2},
+    {"rscan", 1, 2},
+    {"exclusive_scan", 2, 3},
+    {"reduce", 1, 3},
+    {"sum", 0, 1}
+};
+
+//Finds the position of the sequence a primitive maps, scans or reduces,
+//or -1 if it has no segmented version
+int segmented_position(const string& fn, int arity) {
+    for(auto i = std::begin(segmentable); i != std::end(segmentable); i++) {
+        if ((fn == i->fn) && (arity == i->arity)) {
+            return i->seq;
+        }
+    }
+    return -1;
+}
+
+//The primitive a procedure applies to its argument, if that is all
+//it does and the primitive has a segmented version
+shared_ptr<const apply> segmentable_call(const procedure& p) {
+    shared_ptr<const apply> none;
+    if ((p.args().arity() != 1) ||
+        !detail::isinstance<name>(*p.args().begin())) {
+        return none;
+    }
+    const name& arg = boost::get<const name&>(*p.args().begin());
+    const suite& stmts = p.stmts();
+    //Either return prim(...), or result = prim(...); return result
+    const expression* call = nullptr;
+    if ((stmts.size() == 1) &&
+        detail::isinstance<ret>(*stmts.begin())) {
+        call = &boost::get<const ret&>(*stmts.begin()).val();
+    } else if ((stmts.size() == 2) &&
+               detail::isinstance<bind>(*stmts.begin()) &&
+               detail::isinstance<ret>(*(stmts.begin() + 1))) {
+        const bind& b = boost::get<const bind&>(*stmts.begin());
+        const ret& r = boost::get<const ret&>(*(stmts.begin() + 1));
+        if (detail::isinstance<name>(b.lhs()) &&
+            detail::isinstance<name>(r.val()) &&
+            (boost::get<const name&>(b.lhs()).sym() ==
+             boost::get<const name&>(r.val()).sym())) {
+            call = &b.rhs();
+        }
+    }
+    if (!call || !detail::isinstance<apply>(*call)) {
+        return none;
+    }
+    const apply& a = boost::get<const apply&>(*call);
+    int seq = segmented_position(a.fn().id(), a.args().arity());
+    if (seq < 0) {
+        return none;
+    }
+    //The sequence must be the argument, the function a named
+    //function and the prefix a literal
+    int position = 0;
+    for(auto i = a.args().begin(); i != a.args().end(); i++, position++) {
+        if (position == seq) {
+            if (!detail::isinstance<name>(*i) ||
+                (boost::get<const name&>(*i).sym() != arg.sym())) {
+                return none;
+            }
+        } else if (detail::isinstance<name>(*i)) {
+            if (boost::get<const name&>(*i).sym() == arg.sym()) {
+                return none;
+            }
+        } else if (!detail::isinstance<literal>(*i)) {
+            return none;
+        }
+    }
+    return static_pointer_cast<const apply>(a.ptr());
+}
+
+//The argument types of a primitive's function type
+const tuple_t* fn_args(const type_t& t) {
+    if (detail::isinstance<fn_t>(t)) {
+        return &boost::get<const fn_t&>(t).args();
+    }
+    if (detail::isinstance<polytype_t>(t)) {
+        const polytype_t& pt = boost::get<const polytype_t&>(t);
+        if (detail::isinstance<fn_t>(pt.monotype())) {
+            return &boost::get<const fn_t&>(pt.monotype()).args();
+        }
+    }
+    return nullptr;
+}
+
+}
+
+segment::segment() {}
+
+segment::result_type segment::operator()(const suite& n) {
+    for(auto i = n.begin(); i != n.end(); i++) {
+        if (detail::isinstance<procedure>(*i)) {
+            const procedure& p = boost::get<const procedure&>(*i);
+            shared_ptr<const apply> call = detail::segmentable_call(p);
+            if (call) {
+                m_segmentable[p.id().sym()] = call;
+            }
+        }
+    }
+    return this->rewriter<segment>::operator()(n);
+}
+
+segment::result_type segment::segmented(const bind& n) {
+    const apply& rhs = boost::get<const apply&>(n.rhs());
+    auto fn_arg = rhs.args().begin();
+    const name& fn = boost::get<const name&>(*fn_arg);
+    const name& xss = boost::get<const name&>(*(fn_arg + 1));
+
+    //The primitive and the types it is applied at
+    shared_ptr<const apply> call;
+    vector<shared_ptr<const expression> > args;
+    vector<shared_ptr<const type_t> > arg_types;
+    if (fn.id() == "sum") {
+        call = make_node<const apply>(
+            fn.ptr(),
+            make_node<const tuple>(
+                make_vector<shared_ptr<const expression> >(xss.ptr())));
+    } else {
+        auto found = m_segmentable.find(fn.sym());
+        if (found == m_segmentable.end()) {
+            return n.ptr();
+        }
+        call = found->second;
+    }
+    int seq = detail::segmented_position(call->fn().id(),
+                                         call->args().arity());
+    const tuple_t* call_types = detail::fn_args(call->fn().type());
+    if (!call_types && (fn.id() != "sum")) {
+        return n.ptr();
+    }
+    int position = 0;
+    for(auto i = call->args().begin();
+        i != call->args().end();
+        i++, position++) {
+        if (position == seq) {
+            args.push_back(xss.ptr());
+            arg_types.push_back(xss.type().ptr());
+        } else {
+            args.push_back(i->ptr());
+            arg_types.push_back((call_types->begin() + position)->ptr());
+        }
+    }
+    shared_ptr<const type_t> segmented_t =
+        make_node<const fn_t>(
+            make_node<const tuple_t>(std::move(arg_types)),
+            n.lhs().type().ptr());
+    return make_node<const bind>(
+        n.lhs().ptr(),
+        make_node<const apply>(
+            make_node<const name>(
+                "segmented_" + call->fn().id(),
+                segmented_t),
+            make_node<const tuple>(std::move(args))));
+}
+
+segment::result_type segment::operator()(const bind& n) {
+    if (!detail::isinstance<apply>(n.rhs())) {
+        return n.ptr();
+    }
+    const apply& rhs = boost::get<const apply&>(n.rhs());
+    if ((rhs.fn().id() != "map1") ||
+        (rhs.args().arity() != 2)) {
+        return n.ptr();
+    }
+    auto fn_arg = rhs.args().begin();
+    if (!detail::isinstance<name>(*fn_arg) ||
+        !detail::isinstance<name>(*(fn_arg + 1))) {
+        return n.ptr();
+    }
+    //Only maps over nested sequences have segments to process
+    const type_t& xss_t = (fn_arg + 1)->type();
+    if (!detail::isinstance<sequence_t>(xss_t) ||
+        !detail::isinstance<sequence_t>(
+            boost::get<const sequence_t&>(xss_t).sub())) {
+        return n.ptr();
+    }
+    return segmented(n);
+}
+
+}
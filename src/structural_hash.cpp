@@ -0,0 +1,165 @@
+#include "structural_hash.hpp"
+#include "type_printer.hpp"
+#include <sstream>
+
+namespace backend {
+
+namespace detail {
+const std::uint64_t fnv_offset_basis = 14695981039346656037ull;
+const std::uint64_t fnv_prime = 1099511628211ull;
+}
+
+structural_hasher::structural_hasher(const copperhead::system_variant& t,
+                                     std::string* serialization)
+    : m_h(detail::fnv_offset_basis), m_t(t), m_s(serialization) {}
+
+void structural_hasher::operator()(const literal &n) {
+    mix("Literal");
+    mix(n.id());
+    type(n.type());
+    ctype(n.ctype());
+}
+
+void structural_hasher::operator()(const name &n) {
+    mix("Name");
+    mix(n.id());
+    type(n.type());
+    ctype(n.ctype());
+}
+
+void structural_hasher::operator()(const tuple &n) {
+    mix("Tuple");
+    mix(std::uint64_t(n.arity()));
+    for(auto i = n.begin(); i != n.end(); i++) {
+        boost::apply_visitor(*this, *i);
+    }
+    type(n.type());
+    ctype(n.ctype());
+}
+
+void structural_hasher::operator()(const apply &n) {
+    mix("Apply");
+    (*this)(n.fn());
+    (*this)(n.args());
+}
+
+void structural_hasher::operator()(const lambda &n) {
+    mix("Lambda");
+    (*this)(n.args());
+    boost::apply_visitor(*this, n.body());
+    type(n.type());
+    ctype(n.ctype());
+}
+
+void structural_hasher::operator()(const closure &n) {
+    mix("Closure");
+    (*this)(n.args());
+    boost::apply_visitor(*this, n.body());
+    type(n.type());
+    ctype(n.ctype());
+}
+
+void structural_hasher::operator()(const subscript &n) {
+    mix("Subscript");
+    (*this)(n.src());
+    boost::apply_visitor(*this, n.idx());
+}
+
+void structural_hasher::operator()(const ret &n) {
+    mix("Return");
+    boost::apply_visitor(*this, n.val());
+}
+
+void structural_hasher::operator()(const bind &n) {
+    mix("Bind");
+    boost::apply_visitor(*this, n.lhs());
+    boost::apply_visitor(*this, n.rhs());
+}
+
+void structural_hasher::operator()(const call &n) {
+    mix("Call");
+    (*this)(n.sub());
+}
+
+void structural_hasher::operator()(const procedure &n) {
+    mix("Procedure");
+    (*this)(n.id());
+    (*this)(n.args());
+    (*this)(n.stmts());
+    type(n.type());
+    ctype(n.ctype());
+    mix(n.place());
+}
+
+void structural_hasher::operator()(const conditional &n) {
+    mix("Conditional");
+    boost::apply_visitor(*this, n.cond());
+    (*this)(n.then());
+    (*this)(n.orelse());
+}
+
+void structural_hasher::operator()(const suite &n) {
+    mix("Suite");
+    mix(std::uint64_t(n.size()));
+    for(auto i = n.begin(); i != n.end(); i++) {
+        boost::apply_visitor(*this, *i);
+    }
+}
+
+void structural_hasher::operator()(const node &n) {
+    mix("Node");
+    mix(std::uint64_t(n.which()));
+}
+
+void structural_hasher::operator()(const std::string &s) {
+    mix(s);
+}
+
+std::uint64_t structural_hasher::value() const {
+    return m_h;
+}
+
+void structural_hasher::mix(const std::string &s) {
+    //Prefix with the length so that adjacent strings can't run together
+    mix(std::uint64_t(s.size()));
+    for(auto i = s.begin(); i != s.end(); i++) {
+        m_h ^= (unsigned char)*i;
+        m_h *= detail::fnv_prime;
+    }
+    if (m_s) {
+        m_s->append(s);
+    }
+}
+
+void structural_hasher::mix(std::uint64_t v) {
+    for(int i = 0; i < 8; i++) {
+        m_h ^= (v >> (8 * i)) & 0xff;
+        m_h *= detail::fnv_prime;
+        if (m_s) {
+            m_s->push_back(char((v >> (8 * i)) & 0xff));
+        }
+    }
+}
+
+void structural_hasher::type(const type_t &t) {
+    std::ostringstream os;
+    repr_type_printer tp(os);
+    boost::apply_visitor(tp, t);
+    mix(os.str());
+}
+
+void structural_hasher::ctype(const ctype::type_t &t) {
+    std::ostringstream os;
+    ctype::ctype_printer tp(m_t, os);
+    boost::apply_visitor(tp, t);
+    mix(os.str());
+}
+
+std::uint64_t structural_hash(const node &n,
+                              const copperhead::system_variant& t) {
+    structural_hasher h(t);
+    boost::apply_visitor(h, n);
+    return h.value();
+}
+
+}
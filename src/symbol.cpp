@@ -0,0 +1,57 @@
+#include "symbol.hpp"
+#include <unordered_map>
+#include <mutex>
+
+namespace backend {
+
+namespace detail {
+
+//Identifiers are interned in one of several shards, chosen by the
+//hash of their text, so that passes running in parallel rarely
+//contend when they make names
+const unsigned int symbol_shard_count = 64;
+
+struct symbol_shard {
+    std::mutex m_mutex;
+    //Keys of an unordered_map are never moved by rehashing, so
+    //symbols can point at them directly
+    std::unordered_map<std::string, unsigned int> m_ids;
+};
+
+struct symbol_table {
+    symbol_shard m_shards[symbol_shard_count];
+};
+
+//Constructed on first use, since symbols may be made during static
+//initialization of other translation units
+symbol_table& global_symbols() {
+    static symbol_table table;
+    return table;
+}
+
+}
+
+symbol::symbol(const std::string& text) {
+    detail::symbol_table& table = detail::global_symbols();
+    unsigned int shard_index =
+        std::hash<std::string>()(text) % detail::symbol_shard_count;
+    detail::symbol_shard& shard = table.m_shards[shard_index];
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    //Ids are unique across shards: the low bits name the shard
+    auto i = shard.m_ids.insert(
+        std::make_pair(text,
+                       (unsigned int)shard.m_ids.size() *
+                       detail::symbol_shard_count + shard_index)).first;
+    m_id = i->second;
+    m_text = &i->first;
+}
+
+symbol::symbol(const char* text) {
+    *this = symbol(std::string(text));
+}
+
+std::ostream& operator<<(std::ostream& strm, const symbol& s) {
+    return strm << s.str();
+}
+
+}
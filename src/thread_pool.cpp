@@ -0,0 +1,92 @@
+#include "thread_pool.hpp"
+
+namespace backend {
+
+thread_pool::thread_pool(std::size_t threads)
+    : m_fn(nullptr), m_next(0), m_count(0), m_pending(0), m_stop(false) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    //The thread calling for_each does its share of the work
+    for(std::size_t i = 1; i < threads; i++) {
+        m_workers.push_back(std::thread(&thread_pool::work, this));
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for(auto i = m_workers.begin(); i != m_workers.end(); i++) {
+        i->join();
+    }
+}
+
+std::size_t thread_pool::size() const {
+    return m_workers.size() + 1;
+}
+
+void thread_pool::run(std::unique_lock<std::mutex>& lock) {
+    //Claims iterations until there are none left to claim
+    while(m_next < m_count) {
+        std::size_t i = m_next++;
+        const std::function<void(std::size_t)>& fn = *m_fn;
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            fn(i);
+        } catch(...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+        if (error && !m_error) {
+            m_error = error;
+        }
+        if (--m_pending == 0) {
+            m_done.notify_all();
+        }
+    }
+}
+
+void thread_pool::work() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true) {
+        while(!m_stop && m_next >= m_count) {
+            m_wake.wait(lock);
+        }
+        if (m_stop) {
+            return;
+        }
+        run(lock);
+    }
+}
+
+void thread_pool::for_each(std::size_t n,
+                           const std::function<void(std::size_t)>& fn) {
+    if (n == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> call(m_call);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_fn = &fn;
+    m_next = 0;
+    m_count = n;
+    m_pending = n;
+    m_error = std::exception_ptr();
+    m_wake.notify_all();
+    run(lock);
+    while(m_pending > 0) {
+        m_done.wait(lock);
+    }
+    m_fn = nullptr;
+    std::exception_ptr error = m_error;
+    m_error = std::exception_ptr();
+    lock.unlock();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}
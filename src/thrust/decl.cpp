@@ -24,7 +24,7 @@ namespace detail {
 typedef std::tuple<const char*, fn_info> named_info;
 
 void declare_maps(int max_arity,
-                  map<ident, fn_info>& fns,
+                  fn_map& fns,
                   map<string, string>& fn_includes) {
     vector<string> map_ids;
     for(int i = 1; i <= max_arity; i++) {
@@ -99,7 +99,7 @@ void declare_maps(int max_arity,
 }
 
 void declare_zips(int max_arity,
-                  map<ident, fn_info>& fns,
+                  fn_map& fns,
                   map<string, string>& fn_includes) {
     vector<string> zip_ids;
     for(int i = 1; i <= max_arity; i++) {
@@ -170,7 +170,7 @@ void declare_zips(int max_arity,
 }
 
 void declare_unzips(int max_arity,
-                  map<ident, fn_info>& fns,
+                  fn_map& fns,
                   map<string, string>& fn_includes) {
     vector<string> unzip_ids;
     for(int i = 1; i <= max_arity; i++) {
@@ -238,7 +238,7 @@ void declare_unzips(int max_arity,
                         
 }
 
-void declare_scans(map<ident, fn_info>& fns,
+void declare_scans(fn_map& fns,
                    map<string, string>& fn_includes) {
     shared_ptr<const monotype_t> t_a = make_shared<const monotype_t>("a");
     shared_ptr<const monotype_t> seq_t_a = make_shared<const sequence_t>(t_a);
@@ -266,7 +266,10 @@ void declare_scans(map<ident, fn_info>& fns,
                    make_pair("rscan", iteration_structure::independent),
                    fn_info(scan_t, scan_phase_t)));
     fn_includes.insert(make_pair("scan", "prelude/primitives/scan.h"));
+    fn_includes.insert(make_pair("scan_task", "prelude/primitives/scan.h"));
+    fn_includes.insert(make_pair("scan_in_place", "prelude/primitives/scan.h"));
     fn_includes.insert(make_pair("rscan", "prelude/primitives/scan.h"));
+    fn_includes.insert(make_pair("rscan_task", "prelude/primitives/scan.h"));
 
     shared_ptr<const polytype_t> exscan_t =
         make_shared<const polytype_t>(
@@ -286,11 +289,13 @@ void declare_scans(map<ident, fn_info>& fns,
                    make_pair("exclusive_rscan", iteration_structure::independent),
                    fn_info(exscan_t, exscan_phase_t)));
     fn_includes.insert(make_pair("exclusive_scan", "prelude/primitives/scan.h"));
+    fn_includes.insert(make_pair("exclusive_scan_task", "prelude/primitives/scan.h"));
     fn_includes.insert(make_pair("exclusive_rscan", "prelude/primitives/scan.h"));
+    fn_includes.insert(make_pair("exclusive_rscan_task", "prelude/primitives/scan.h"));
 
 }
 
-void declare_permutes(map<ident, fn_info>& fns,
+void declare_permutes(fn_map& fns,
                       map<string, string>& fn_includes) {
     shared_ptr<const monotype_t> t_a = make_shared<const monotype_t>("a");
     shared_ptr<const monotype_t> seq_t_a = make_shared<const sequence_t>(t_a);
@@ -310,6 +315,7 @@ void declare_permutes(map<ident, fn_info>& fns,
                    make_pair("permute", iteration_structure::independent),
                    fn_info(permute_t, permute_phase_t)));
     fn_includes.insert(make_pair("permute", "prelude/primitives/scatter.h"));
+    fn_includes.insert(make_pair("permute_task", "prelude/primitives/scatter.h"));
 
 
     shared_ptr<const polytype_t> scatter_t =
@@ -327,10 +333,12 @@ void declare_permutes(map<ident, fn_info>& fns,
                    make_pair("scatter", iteration_structure::independent),
                    fn_info(scatter_t, scatter_phase_t)));
     fn_includes.insert(make_pair("scatter", "prelude/primitives/scatter.h"));
+    fn_includes.insert(make_pair("scatter_task", "prelude/primitives/scatter.h"));
+    fn_includes.insert(make_pair("scatter_in_place", "prelude/primitives/scatter.h"));
         
 }
 
-void declare_special_sequences(map<ident, fn_info>& fns,
+void declare_special_sequences(fn_map& fns,
                                map<string, string>& fn_includes) {
     shared_ptr<const monotype_t> t_a = make_shared<const monotype_t>("a");
     shared_ptr<const monotype_t> seq_t_a = make_shared<const sequence_t>(t_a);
@@ -369,7 +377,7 @@ void declare_special_sequences(map<ident, fn_info>& fns,
            
 }
 
-void declare_transforms(map<ident, fn_info>& fns,
+void declare_transforms(fn_map& fns,
                         map<string, string>& fn_includes) {
     shared_ptr<const monotype_t> t_a = make_shared<const monotype_t>("a");
     shared_ptr<const monotype_t> seq_t_a = make_shared<const sequence_t>(t_a);
@@ -388,9 +396,10 @@ void declare_transforms(map<ident, fn_info>& fns,
                    make_pair("adjacent_difference", iteration_structure::independent),
                    fn_info(adj_t, adj_phase_t)));
     fn_includes.insert(make_pair("adjacent_difference", "prelude/primitives/adjacent_difference.h"));
+    fn_includes.insert(make_pair("adjacent_difference_task", "prelude/primitives/adjacent_difference.h"));
 }
 
-void declare_reductions(map<ident, fn_info>& fns,
+void declare_reductions(fn_map& fns,
                         map<string, string>& fn_includes) {
     shared_ptr<const monotype_t> t_a = make_shared<const monotype_t>("a");
     shared_ptr<const monotype_t> seq_t_a = make_shared<const sequence_t>(t_a);
@@ -417,6 +426,12 @@ void declare_reductions(map<ident, fn_info>& fns,
                    make_pair("reduce", iteration_structure::independent),
                    fn_info(reduce_t, reduce_phase_t)));
     fn_includes.insert(make_pair("reduce", "prelude/primitives/reduce.h"));
+    fn_includes.insert(make_pair("reduce_task", "prelude/primitives/reduce.h"));
+    //Fused sibling reductions, introduced by the fuse_reductions pass
+    fn_includes.insert(make_pair("reduce2", "prelude/primitives/reduce.h"));
+    fn_includes.insert(make_pair("reduce2_task", "prelude/primitives/reduce.h"));
+    fn_includes.insert(make_pair("reduce3", "prelude/primitives/reduce.h"));
+    fn_includes.insert(make_pair("reduce4", "prelude/primitives/reduce.h"));
     shared_ptr<const polytype_t> sum_t =
         make_shared<const polytype_t>(
             make_vector<shared_ptr<const monotype_t> >(t_a),
@@ -436,9 +451,121 @@ void declare_reductions(map<ident, fn_info>& fns,
                    make_pair("sum", iteration_structure::independent),
                    fn_info(sum_t, sum_phase_t)));
     fn_includes.insert(make_pair("sum", "prelude/primitives/reduce.h"));
+    fn_includes.insert(make_pair("sum_task", "prelude/primitives/reduce.h"));
 }
 
-void declare_sorts(map<ident, fn_info>& fns,
+void declare_segmented(fn_map& fns,
+                       map<string, string>& fn_includes) {
+    shared_ptr<const monotype_t> t_a = make_shared<const monotype_t>("a");
+    shared_ptr<const monotype_t> seq_t_a = make_shared<const sequence_t>(t_a);
+    shared_ptr<const monotype_t> seq_seq_t_a = make_shared<const sequence_t>(seq_t_a);
+    shared_ptr<const monotype_t> bin_fn_t =
+        make_shared<const fn_t>(
+            make_shared<const tuple_t>(
+                make_vector<shared_ptr<const type_t> >(t_a)(t_a)),
+            t_a);
+    shared_ptr<const monotype_t> t_b = make_shared<const monotype_t>("b");
+    shared_ptr<const monotype_t> seq_seq_t_b =
+        make_shared<const sequence_t>(make_shared<const sequence_t>(t_b));
+    shared_ptr<const polytype_t> map_t =
+        make_shared<const polytype_t>(
+            make_vector<shared_ptr<const monotype_t> >(t_a)(t_b),
+            make_shared<const fn_t>(
+                make_shared<const tuple_t>(
+                    make_vector<shared_ptr<const type_t> >
+                    (make_shared<const fn_t>(
+                        make_shared<const tuple_t>(
+                            make_vector<shared_ptr<const type_t> >(t_a)),
+                        t_b))
+                    (seq_seq_t_a)),
+                seq_seq_t_b));
+    shared_ptr<const phase_t> map_phase_t =
+        make_shared<const phase_t>(
+            make_vector<completion>(completion::invariant)(completion::local),
+            completion::total);
+    fns.insert(make_pair(
+                   make_pair("segmented_map1", iteration_structure::independent),
+                   fn_info(map_t, map_phase_t)));
+
+    shared_ptr<const polytype_t> scan_t =
+        make_shared<const polytype_t>(
+            make_vector<shared_ptr<const monotype_t> >(t_a),
+            make_shared<const fn_t>(
+                make_shared<const tuple_t>(
+                    make_vector<shared_ptr<const type_t> >(bin_fn_t)(seq_seq_t_a)),
+                seq_seq_t_a));
+    shared_ptr<const phase_t> scan_phase_t =
+        make_shared<const phase_t>(
+            make_vector<completion>(completion::invariant)(completion::local),
+            completion::total);
+    fns.insert(make_pair(
+                   make_pair("segmented_scan", iteration_structure::independent),
+                   fn_info(scan_t, scan_phase_t)));
+    fns.insert(make_pair(
+                   make_pair("segmented_rscan", iteration_structure::independent),
+                   fn_info(scan_t, scan_phase_t)));
+
+    shared_ptr<const polytype_t> exscan_t =
+        make_shared<const polytype_t>(
+            make_vector<shared_ptr<const monotype_t> >(t_a),
+            make_shared<const fn_t>(
+                make_shared<const tuple_t>(
+                    make_vector<shared_ptr<const type_t> >(bin_fn_t)(t_a)(seq_seq_t_a)),
+                seq_seq_t_a));
+    shared_ptr<const phase_t> exscan_phase_t =
+        make_shared<const phase_t>(
+            make_vector<completion>(completion::invariant)(completion::invariant)(completion::local),
+            completion::total);
+    fns.insert(make_pair(
+                   make_pair("segmented_exclusive_scan", iteration_structure::independent),
+                   fn_info(exscan_t, exscan_phase_t)));
+
+    shared_ptr<const polytype_t> reduce_t =
+        make_shared<const polytype_t>(
+            make_vector<shared_ptr<const monotype_t> >(t_a),
+            make_shared<const fn_t>(
+                make_shared<const tuple_t>(
+                    make_vector<shared_ptr<const type_t> >
+                    (bin_fn_t)(seq_seq_t_a)(t_a)),
+                seq_t_a));
+    shared_ptr<const phase_t> reduce_phase_t =
+        make_shared<const phase_t>(
+            make_vector<completion>
+            (completion::invariant)(completion::local)(completion::local),
+            completion::total);
+    fns.insert(make_pair(
+                   make_pair("segmented_reduce", iteration_structure::independent),
+                   fn_info(reduce_t, reduce_phase_t)));
+
+    shared_ptr<const polytype_t> sum_t =
+        make_shared<const polytype_t>(
+            make_vector<shared_ptr<const monotype_t> >(t_a),
+            make_shared<const fn_t>(
+                make_shared<const tuple_t>(
+                    make_vector<shared_ptr<const type_t> >
+                    (seq_seq_t_a)),
+                seq_t_a));
+    shared_ptr<const phase_t> sum_phase_t =
+        make_shared<const phase_t>(
+            make_vector<completion>
+            (completion::local),
+            completion::total);
+    fns.insert(make_pair(
+                   make_pair("segmented_sum", iteration_structure::independent),
+                   fn_info(sum_t, sum_phase_t)));
+
+    const char* segmented[] = {"segmented_map1",
+                               "segmented_scan", "segmented_rscan",
+                               "segmented_exclusive_scan",
+                               "segmented_reduce", "segmented_sum"};
+    for(auto i = std::begin(segmented); i != std::end(segmented); i++) {
+        fn_includes.insert(make_pair(*i, "prelude/primitives/segmented.h"));
+        fn_includes.insert(make_pair(string(*i) + "_task",
+                                     "prelude/primitives/segmented.h"));
+    }
+}
+
+void declare_sorts(fn_map& fns,
                    map<string, string>& fn_includes) {
     shared_ptr<const monotype_t> t_a = make_shared<const monotype_t>("a");
     shared_ptr<const polytype_t> cmp_t =
@@ -464,9 +591,11 @@ void declare_sorts(map<ident, fn_info>& fns,
                    make_pair("sort", iteration_structure::independent),
                    fn_info(sort_t, sort_phase_t)));
     fn_includes.insert(make_pair("sort", "prelude/primitives/sort.h"));
+    fn_includes.insert(make_pair("sort_task", "prelude/primitives/sort.h"));
+    fn_includes.insert(make_pair("sort_in_place", "prelude/primitives/sort.h"));
 }
 
-void declare_filter(map<ident, fn_info>& fns,
+void declare_filter(fn_map& fns,
                     map<string, string>& fn_includes) {
     shared_ptr<const monotype_t> t_a = make_shared<const monotype_t>("a");
     shared_ptr<const polytype_t> cmp_t =
@@ -492,6 +621,7 @@ void declare_filter(map<ident, fn_info>& fns,
                    make_pair("filter", iteration_structure::independent),
                    fn_info(filter_t, filter_phase_t)));
     fn_includes.insert(make_pair("filter", "prelude/primitives/filter.h"));
+    fn_includes.insert(make_pair("filter_task", "prelude/primitives/filter.h"));
 }
 
 }
@@ -501,7 +631,7 @@ void declare_filter(map<ident, fn_info>& fns,
 
 shared_ptr<library> get_thrust() {
     int max_arity = 10;
-    map<ident, fn_info> exported_fns;
+    fn_map exported_fns;
     map<string, string> fn_includes;
     thrust::detail::declare_maps(max_arity, exported_fns, fn_includes);
     thrust::detail::declare_scans(exported_fns, fn_includes);
@@ -509,6 +639,7 @@ shared_ptr<library> get_thrust() {
     thrust::detail::declare_special_sequences(exported_fns, fn_includes);
     thrust::detail::declare_transforms(exported_fns, fn_includes);
     thrust::detail::declare_reductions(exported_fns, fn_includes);
+    thrust::detail::declare_segmented(exported_fns, fn_includes);
     thrust::detail::declare_sorts(exported_fns, fn_includes);
     thrust::detail::declare_zips(max_arity, exported_fns, fn_includes);
     thrust::detail::declare_unzips(max_arity, exported_fns, fn_includes);
@@ -4,7 +4,6 @@
 using std::string;
 using std::stringstream;
 using std::shared_ptr;
-using std::make_shared;
 using std::static_pointer_cast;
 using std::vector;
 using std::map;
@@ -46,13 +45,13 @@ thrust_rewriter::result_type thrust_rewriter::map_rewrite(
                 ttc.push_back(i->ptr());
             }
             shared_ptr<const ctype::monotype_t> base =
-                make_shared<const ctype::monotype_t>(tn.id());
-            fn_t = make_shared<const ctype::polytype_t>(
+                make_node<const ctype::monotype_t>(tn.id());
+            fn_t = make_node<const ctype::polytype_t>(
                 std::move(ttc), base);
         } else {
             assert(detail::isinstance<name>(fn_inst.fn()));
             string fn_id = fn_inst.fn().id();
-            fn_t = make_shared<const ctype::monotype_t>(fn_id);
+            fn_t = make_node<const ctype::monotype_t>(fn_id);
         }
     } else {
         //We must be dealing with a closure
@@ -64,7 +63,7 @@ thrust_rewriter::result_type thrust_rewriter::map_rewrite(
         ss << "closure";
         string closure_t_name = ss.str();
         shared_ptr<const ctype::monotype_t> closure_mt =
-            make_shared<const ctype::monotype_t>(closure_t_name);
+            make_node<const ctype::monotype_t>(closure_t_name);
         vector<shared_ptr<const ctype::type_t> > cts;
         //By this point, the body of the closure is an
         //instantiated functor (which must be an apply node)
@@ -96,7 +95,7 @@ thrust_rewriter::result_type thrust_rewriter::map_rewrite(
             os << fnn.id();
         }
         cts.push_back(
-            make_shared<const ctype::monotype_t>(
+            make_node<const ctype::monotype_t>(
                 os.str()));
         
         vector<shared_ptr<const ctype::type_t> > tuple_sub_cts;
@@ -108,14 +107,14 @@ thrust_rewriter::result_type thrust_rewriter::map_rewrite(
             const name& arg_i_name = boost::get<const name&>(*i);
             
             tuple_sub_cts.push_back(
-                make_shared<const ctype::monotype_t>(
+                make_node<const ctype::monotype_t>(
                     detail::typify(arg_i_name.id())));
         }
         cts.push_back(
-            make_shared<const ctype::tuple_t>(
+            make_node<const ctype::tuple_t>(
                 std::move(tuple_sub_cts)));
         
-        fn_t = make_shared<const ctype::polytype_t>(
+        fn_t = make_node<const ctype::polytype_t>(
             std::move(cts),
             closure_mt);
     }
@@ -124,26 +123,26 @@ thrust_rewriter::result_type thrust_rewriter::map_rewrite(
         //Assert we're looking at a name
         assert(detail::isinstance<name>(*i));
         arg_types.push_back(
-            make_shared<const ctype::monotype_t>(
+            make_node<const ctype::monotype_t>(
                 detail::typify(boost::get<const name&>(*i).id())));
     }
     shared_ptr<const ctype::tuple_t> thrust_tupled =
-        make_shared<const ctype::tuple_t>(
+        make_node<const ctype::tuple_t>(
             std::move(arg_types));
     shared_ptr<const ctype::polytype_t> transform_t =
-        make_shared<const ctype::polytype_t>(
+        make_node<const ctype::polytype_t>(
             make_vector<shared_ptr<const ctype::type_t> >
             (fn_t)(thrust_tupled),
-            make_shared<const ctype::monotype_t>("transformed_sequence"));
+            make_node<const ctype::monotype_t>("transformed_sequence"));
     shared_ptr<const apply> n_rhs =
         static_pointer_cast<const apply>(n.rhs().ptr());
     //Can only handle names on the LHS
     assert(detail::isinstance<name>(n.lhs()));
     const name& lhs = boost::get<const name&>(n.lhs());
-    shared_ptr<const name> n_lhs = make_shared<const name>(lhs.id(),
-                                                           lhs.type().ptr(),
-                                                           transform_t);
-    auto result = make_shared<const bind>(n_lhs, n_rhs);
+    shared_ptr<const name> n_lhs = make_node<const name>(lhs.id(),
+                                                         lhs.type().ptr(),
+                                                         transform_t);
+    auto result = make_node<const bind>(n_lhs, n_rhs);
     return result;
         
 }
@@ -162,20 +161,20 @@ thrust_rewriter::result_type thrust_rewriter::indices_rewrite(const bind& n) {
     assert(detail::isinstance<ctype::sequence_t>(arg_t));
         
     shared_ptr<const ctype::polytype_t> index_t =
-        make_shared<const ctype::polytype_t>(
+        make_node<const ctype::polytype_t>(
             make_vector<shared_ptr<const ctype::type_t> >
-            (make_shared<const ctype::monotype_t>(copperhead::to_string(m_target))),
-            make_shared<const ctype::monotype_t>("index_sequence"));
+            (make_node<const ctype::monotype_t>(copperhead::to_string(m_target))),
+            make_node<const ctype::monotype_t>("index_sequence"));
     shared_ptr<const apply> n_rhs =
         static_pointer_cast<const apply>(n.rhs().ptr());
     //Can only handle names on the LHS
     assert(detail::isinstance<name>(n.lhs()));
     const name& lhs = boost::get<const name&>(n.lhs());
     shared_ptr<const name> n_lhs =
-        make_shared<const name>(lhs.id(),
-                                lhs.type().ptr(),
-                                index_t);
-    auto result = make_shared<const bind>(n_lhs, n_rhs);
+        make_node<const name>(lhs.id(),
+                              lhs.type().ptr(),
+                              index_t);
+    auto result = make_node<const bind>(n_lhs, n_rhs);
     return result;
 }
 
@@ -194,15 +193,15 @@ thrust_rewriter::result_type thrust_rewriter::replicate_rewrite(const bind& n) {
     //To do this, we add an additional argument: the tag
     auto ap_arg_iterator = ap_args.begin();
     shared_ptr<const expression> tag_arg =
-        make_shared<const apply>(
-            make_shared<const name>(
+        make_node<const apply>(
+            make_node<const name>(
                 copperhead::to_string(m_target)),
-            make_shared<const tuple>(
+            make_node<const tuple>(
                 make_vector<shared_ptr<const expression> >()));
     shared_ptr<const expression> arg1 = ap_arg_iterator->ptr();
     shared_ptr<const expression> arg2 = (ap_arg_iterator+1)->ptr();
     shared_ptr<const tuple> targeted_arguments =
-        make_shared<const tuple>(
+        make_node<const tuple>(
             make_vector<shared_ptr<const expression> >(tag_arg)(arg1)(arg2));
     
                     
@@ -212,24 +211,24 @@ thrust_rewriter::result_type thrust_rewriter::replicate_rewrite(const bind& n) {
     
     
     shared_ptr<const ctype::polytype_t> constant_t =
-        make_shared<const ctype::polytype_t>(
+        make_node<const ctype::polytype_t>(
             make_vector<shared_ptr<const ctype::type_t> >
-            (make_shared<const ctype::monotype_t>(copperhead::to_string(m_target)))
+            (make_node<const ctype::monotype_t>(copperhead::to_string(m_target)))
             (val_t),
-            make_shared<const ctype::monotype_t>("constant_sequence"));
+            make_node<const ctype::monotype_t>("constant_sequence"));
 
     shared_ptr<const apply> n_rhs =
-        make_shared<const apply>(rhs.fn().ptr(),
-                                 targeted_arguments);
+        make_node<const apply>(rhs.fn().ptr(),
+                               targeted_arguments);
             
     //Can only handle names on the LHS
     assert(detail::isinstance<name>(n.lhs()));
     const name& lhs = boost::get<const name&>(n.lhs());
     shared_ptr<const name> n_lhs =
-        make_shared<const name>(lhs.id(),
-                                lhs.type().ptr(),
-                                constant_t);
-    auto result = make_shared<const bind>(n_lhs, n_rhs);
+        make_node<const name>(lhs.id(),
+                              lhs.type().ptr(),
+                              constant_t);
+    auto result = make_node<const bind>(n_lhs, n_rhs);
     return result;
 }
 
@@ -247,24 +246,24 @@ thrust_rewriter::result_type thrust_rewriter::zip_rewrite(const bind& n) {
     vector<shared_ptr<const ctype::type_t> > arg_types;
     for(auto i = rhs.args().begin(), e = rhs.args().end(); i != e; i++) {
         arg_types.push_back(
-            make_shared<const ctype::monotype_t>(
+            make_node<const ctype::monotype_t>(
                 detail::typify(boost::get<const name&>(*i).id())));
     }
     shared_ptr<const ctype::polytype_t> thrust_tupled =
-        make_shared<const ctype::polytype_t>(
+        make_node<const ctype::polytype_t>(
             std::move(arg_types),
-            make_shared<const ctype::monotype_t>("thrust::tuple"));
+            make_node<const ctype::monotype_t>("thrust::tuple"));
     shared_ptr<const ctype::polytype_t> zip_t =
-        make_shared<const ctype::polytype_t>(
+        make_node<const ctype::polytype_t>(
             make_vector<shared_ptr<const ctype::type_t> >
             (thrust_tupled),
-            make_shared<const ctype::monotype_t>("zipped_sequence"));
+            make_node<const ctype::monotype_t>("zipped_sequence"));
             
     shared_ptr<const name> n_lhs =
-        make_shared<const name>(lhs.id(),
-                                lhs.type().ptr(),
-                                zip_t);
-    auto result = make_shared<const bind>(n_lhs, rhs.ptr());
+        make_node<const name>(lhs.id(),
+                              lhs.type().ptr(),
+                              zip_t);
+    auto result = make_node<const bind>(n_lhs, rhs.ptr());
     return result;
 }
 
@@ -283,7 +282,7 @@ thrust_rewriter::result_type thrust_rewriter::make_tuple_rewrite(const bind& n)
         if (detail::isinstance<name>(*i)) {
             const name& name_i = boost::get<const name&>(*i);
             typified.push_back(
-                make_shared<const ctype::monotype_t>(
+                make_node<const ctype::monotype_t>(
                     detail::typify(
                         name_i.id())));
         } else {
@@ -294,11 +293,11 @@ thrust_rewriter::result_type thrust_rewriter::make_tuple_rewrite(const bind& n)
 
     const name& lhs = boost::get<const name&>(n.lhs());
     shared_ptr<const name> n_lhs =
-        make_shared<const name>(lhs.id(),
-                                lhs.type().ptr(),
-                                make_shared<const ctype::tuple_t>(
-                                    move(typified)));
-    return make_shared<const bind>(
+        make_node<const name>(lhs.id(),
+                              lhs.type().ptr(),
+                              make_node<const ctype::tuple_t>(
+                                  move(typified)));
+    return make_node<const bind>(
         n_lhs, rhs.ptr());
 }
 
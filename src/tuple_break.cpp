@@ -2,7 +2,6 @@
 
 using std::vector;
 using std::shared_ptr;
-using std::make_shared;
 using std::static_pointer_cast;
 using std::string;
 using std::move;
@@ -33,11 +32,11 @@ tuple_break::result_type tuple_break::operator()(const bind& n) {
             i != lhs.end();
             i++, j++) {
             stmts.push_back(
-                make_shared<bind>(
+                make_node<bind>(
                     i->ptr(),
                     j->ptr()));
         }
-        return make_shared<suite>(move(stmts));
+        return make_node<suite>(move(stmts));
     } else if (lhs_tuple && !rhs_tuple) {
         //Unpacking a tuple
         const tuple& lhs = boost::get<const tuple&>(n.lhs());
@@ -46,12 +45,12 @@ tuple_break::result_type tuple_break::operator()(const bind& n) {
         if (detail::isinstance<apply>(n.rhs())) {
             //The RHS is a function call.  Call it, store the result,
             //then break it.  Here we call it and store the result.
-            shared_ptr<const name> result = make_shared<const name>(
+            shared_ptr<const name> result = make_node<const name>(
                 m_supply.next(),
                 lhs.type().ptr(),
                 lhs.ctype().ptr());
-            shared_ptr<const bind> call_stmt = make_shared<const bind>(result, 
-                                                                       n.rhs().ptr());
+            shared_ptr<const bind> call_stmt = make_node<const bind>(result, 
+                                                                     n.rhs().ptr());
             stmts.push_back(call_stmt);
             p_rhs = result;
         } else {
@@ -61,15 +60,15 @@ tuple_break::result_type tuple_break::operator()(const bind& n) {
         int number = 0;
         for(auto i = lhs.begin(); i != lhs.end(); i++, number++) {
             stmts.push_back(
-                make_shared<const bind>(
+                make_node<const bind>(
                     i->ptr(),
-                    make_shared<const apply>(
-                        make_shared<const name>(
+                    make_node<const apply>(
+                        make_node<const name>(
                             detail::snippet_get(number)),
-                        make_shared<const tuple>(
+                        make_node<const tuple>(
                             make_vector<shared_ptr<const expression> >(p_rhs)))));
         }
-        return make_shared<suite>(move(stmts));
+        return make_node<suite>(move(stmts));
     } else if (!lhs_tuple && rhs_tuple) {
         //Packing a tuple
         const tuple& rhs = boost::get<const tuple&>(n.rhs());
@@ -78,11 +77,11 @@ tuple_break::result_type tuple_break::operator()(const bind& n) {
         for(auto i = rhs.begin(); i != rhs.end(); i++) {
             args.push_back(i->ptr());
         }
-        return make_shared<bind>(
+        return make_node<bind>(
             n.lhs().ptr(),
-            make_shared<apply>(
-                make_shared<name>(detail::snippet_make_tuple()),
-                make_shared<tuple>(move(args))));
+            make_node<apply>(
+                make_node<name>(detail::snippet_make_tuple()),
+                make_node<tuple>(move(args))));
     } else {
         //No tuples in this bind, just return the original
         return n.ptr();
@@ -110,10 +109,10 @@ tuple_break::result_type tuple_break::operator()(const procedure& n) {
             i++) {
             stmts.push_back(i->ptr());
         }
-        return make_shared<const procedure>(
+        return make_node<const procedure>(
             n.id().ptr(),
-            make_shared<backend::tuple>(std::move(args)),
-            make_shared<backend::suite>(std::move(stmts)),
+            make_node<backend::tuple>(std::move(args)),
+            make_node<backend::suite>(std::move(stmts)),
             n.type().ptr(),
             n.ctype().ptr(),
             n.place());
@@ -2,7 +2,6 @@
 #include "utility/isinstance.hpp"
 
 using std::shared_ptr;
-using std::make_shared;
 using std::static_pointer_cast;
 using std::vector;
 using std::move;
@@ -29,7 +28,7 @@ cu_to_c::result_type cu_to_c::operator()(const monotype_t& mt) {
     } else if (mt.name() == "Void") {
         return ctype::void_mt;
     } else {
-        return result_type(new ctype::monotype_t(mt.name()));
+        return make_node<const ctype::monotype_t>(mt.name());
     }
 }
 
@@ -38,7 +37,7 @@ struct sequenceize
     
     template<typename T>
     result_type operator()(const T& t) const {
-        return make_shared<const ctype::sequence_t>(t.ptr());
+        return make_node<const ctype::sequence_t>(t.ptr());
     }
 
     result_type operator()(const ctype::tuple_t& t) const {
@@ -46,8 +45,8 @@ struct sequenceize
         for(auto i = t.begin(); i != t.end(); i++) {
             subs.push_back(boost::apply_visitor(*this, *i));
         }
-        return make_shared<const ctype::zipped_sequence_t>(
-            make_shared<const ctype::tuple_t>(
+        return make_node<const ctype::zipped_sequence_t>(
+            make_node<const ctype::tuple_t>(
                 move(subs)));
     }
     
@@ -61,14 +60,14 @@ cu_to_c::result_type cu_to_c::operator()(const sequence_t & st) {
         //Convert leaf subtypes to sequences
         return boost::apply_visitor(sequenceize(), *sub);
     }
-    return result_type(new ctype::sequence_t(sub));
+    return make_node<const ctype::sequence_t>(sub);
 }
 cu_to_c::result_type cu_to_c::operator()(const tuple_t& tt) {
     vector<result_type> subs;
     for(auto i = tt.begin(); i != tt.end(); i++) {
         subs.push_back(boost::apply_visitor(*this, *i));
     }
-    return result_type(new ctype::tuple_t(move(subs)));
+    return make_node<const ctype::tuple_t>(move(subs));
 }
 cu_to_c::result_type cu_to_c::operator()(const fn_t& ft) {
     shared_ptr<const ctype::tuple_t> args =
@@ -76,7 +75,7 @@ cu_to_c::result_type cu_to_c::operator()(const fn_t& ft) {
             boost::apply_visitor(*this, ft.args()));
     shared_ptr<const ctype::type_t> result =
         boost::apply_visitor(*this, ft.result());
-    result_type fn_result(new ctype::fn_t(args, result));
+    result_type fn_result(make_node<const ctype::fn_t>(args, result));
     return fn_result;
 }
 
@@ -88,7 +87,7 @@ cu_to_c::result_type cu_to_c::operator()(const polytype_t& p) {
         subs.push_back(boost::apply_visitor(*this, *i));
     }
     auto base = static_pointer_cast<const ctype::monotype_t>(boost::apply_visitor(*this, p.monotype()));
-    return result_type(new ctype::polytype_t(move(subs), base));
+    return make_node<const ctype::polytype_t>(move(subs), base);
 }
 
 }
@@ -107,7 +106,7 @@ type_convert::result_type type_convert::operator()(const procedure &p) {
     //Yes, I really want to make a ctype from a type. That's the point!
     shared_ptr<const ctype::type_t> ct = boost::apply_visitor(m_c, p.type());
 
-    shared_ptr<const node> result(new procedure(id, args, stmts, t, ct));
+    shared_ptr<const node> result(make_node<const procedure>(id, args, stmts, t, ct));
     return result;
 }
 type_convert::result_type type_convert::operator()(const name &p) {
@@ -115,7 +114,7 @@ type_convert::result_type type_convert::operator()(const name &p) {
         
     //Yes, I really want to make a ctype from a type. That's the point!
     shared_ptr<const ctype::type_t> ct = boost::apply_visitor(m_c, p.type());
-    result_type result(new name(p.id(), t, ct));
+    result_type result(make_node<const name>(p.id(), t, ct));
     return result;
 }
 
@@ -124,7 +123,7 @@ type_convert::result_type type_convert::operator()(const literal &p) {
         
     //Yes, I really want to make a ctype from a type. That's the point!
     shared_ptr<const ctype::type_t> ct = boost::apply_visitor(m_c, p.type());
-    result_type result(new literal(p.id(), t, ct));
+    result_type result(make_node<const literal>(p.id(), t, ct));
     return result;
 }
 
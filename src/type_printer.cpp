@@ -1,4 +1,6 @@
 #include "type_printer.hpp"
+#include "utility/isinstance.hpp"
+#include "utility/up_get.hpp"
 
 namespace backend
 {
@@ -54,9 +56,20 @@ void ctype_printer::operator()(const monotype_t &mt) {
     m_need_space.top() = (mt.name()[mt.name().size()-1] == '>');
 }
 void ctype_printer::operator()(const sequence_t &st) {
+    //Nested sequences are represented by their nesting depth:
+    //Seq(Seq(Float32)) is sequence<Tag, float, 1>
+    int depth = 0;
+    const type_t* leaf = &st.sub();
+    while (backend::detail::isinstance<sequence_t>(*leaf)) {
+        leaf = &backend::detail::up_get<const sequence_t&>(*leaf).sub();
+        depth++;
+    }
     m_os << st.name() << "<";
     m_os << copperhead::to_string(m_t) << ", ";
-    boost::apply_visitor(*this, st.sub());
+    boost::apply_visitor(*this, *leaf);
+    if (depth > 0) {
+        m_os << ", " << depth;
+    }
     m_os << ">";
     m_need_space.top() = true;
 }
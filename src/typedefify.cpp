@@ -2,7 +2,6 @@
 
 using std::vector;
 using std::shared_ptr;
-using std::make_shared;
 using std::static_pointer_cast;
 
 
@@ -37,17 +36,17 @@ typedefify::result_type typedefify::operator()(const bind &n) {
     const name& lhs = boost::get<const name&>(n.lhs());
         
     shared_ptr<const ctype::type_t> unique_type =
-        std::make_shared<const ctype::monotype_t>(
+        make_node<const ctype::monotype_t>(
             detail::typify(lhs.id()));
     shared_ptr<const expression> rhs =
         static_pointer_cast<const expression>(
             boost::apply_visitor(*this, n.rhs()));
     shared_ptr<const name> new_lhs =
-        std::make_shared<const name>(lhs.id(),
-                                     lhs.type().ptr(),
-                                     unique_type);
+        make_node<const name>(lhs.id(),
+                              lhs.type().ptr(),
+                              unique_type);
     m_typedef =
-        std::make_shared<const typedefn>(
+        make_node<const typedefn>(
             lhs.ctype().ptr(),
             unique_type);
     return result_type(
@@ -62,10 +61,10 @@ typedefify::result_type typedefify::operator()(const procedure &n) {
         assert(detail::isinstance<name>(*i));
         const name& arg_name = boost::get<const name&>(*i);
         shared_ptr<const ctype::type_t> unique_type =
-            std::make_shared<const ctype::monotype_t>(
+            make_node<const ctype::monotype_t>(
                 detail::typify(arg_name.id()));
         shared_ptr<const typedefn> arg_typedef =
-            std::make_shared<const typedefn>(
+            make_node<const typedefn>(
                 arg_name.ctype().ptr(),
                 unique_type);
         stmts.push_back(arg_typedef);
@@ -89,9 +88,9 @@ typedefify::result_type typedefify::operator()(const procedure &n) {
         static_pointer_cast<const tuple>(
             boost::apply_visitor(*this, args));
     shared_ptr<const suite> n_stmts =
-        std::make_shared<const suite>(std::move(stmts));
+        make_node<const suite>(std::move(stmts));
                 
-    return std::make_shared<const procedure>(
+    return make_node<const procedure>(
         n_name,
         n_args,
         n_stmts,
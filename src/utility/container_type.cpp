@@ -4,7 +4,6 @@
 #include <iostream>
 using std::shared_ptr;
 using std::vector;
-using std::make_shared;
 
 namespace backend {
 namespace detail {
@@ -12,7 +11,7 @@ namespace detail {
 shared_ptr<const ctype::type_t> container_type(const ctype::type_t& t) {
     if (detail::isinstance<ctype::sequence_t>(t)) {
         const ctype::sequence_t& seq = detail::up_get<ctype::sequence_t>(t);
-        return make_shared<const ctype::cuarray_t>(
+        return make_node<const ctype::cuarray_t>(
             seq.sub().ptr());
     } else if (!detail::isinstance<ctype::tuple_t>(t)) {
         return t.ptr();
@@ -28,7 +27,7 @@ shared_ptr<const ctype::type_t> container_type(const ctype::type_t& t) {
     if (match) {
         return t.ptr();
     }
-    return make_shared<const ctype::tuple_t>(move(sub_types));
+    return make_node<const ctype::tuple_t>(move(sub_types));
 }
 
 }
@@ -19,6 +19,18 @@ std::string wrap_proc_id(const std::string &in) {
     return "wrap" + in;
 }
 
+std::string async_proc_id(const std::string &in) {
+    return "async" + in;
+}
+
+std::string batch_proc_id(const std::string &in) {
+    return "batch" + in;
+}
+
+std::string body_proc_id(const std::string &in) {
+    return "body" + in;
+}
+
 std::string typify(const std::string &in) {
     return "T" + in;
 }
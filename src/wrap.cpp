@@ -4,22 +4,34 @@
 #include "type_printer.hpp"
 #include "utility/up_get.hpp"
 #include "utility/container_type.hpp"
+#include "liveness.hpp"
 
 using std::string;
 using std::vector;
 using std::shared_ptr;
-using std::make_shared;
 using std::static_pointer_cast;
 using std::move;
 using backend::utility::make_vector;
 
 namespace backend {
 
+namespace detail {
+//Entry points are started with boost::bind, which takes at most
+//this many arguments
+const size_t max_async_arity = 9;
+//The runtime's batch takes at most this many arguments
+const size_t max_batch_arity = 4;
+}
+
 wrap::wrap(const copperhead::system_variant& target,
-           const string& entry_point)
+           const string& entry_point,
+           bool async,
+           bool batch)
     : m_target(target),
       m_entry_point(entry_point),
-      m_wrapping(false) {}
+      m_wrapping(false),
+      m_async(async),
+      m_batch(batch) {}
 
 
 wrap::result_type wrap::operator()(const procedure &n) {
@@ -60,36 +72,36 @@ wrap::result_type wrap::operator()(const procedure &n) {
 
                 //Stick it in a tuple for the templated_name
                 shared_ptr<const ctype::tuple_t> p_tuple_impl_seq_ct =
-                    make_shared<const ctype::tuple_t>(
+                    make_node<const ctype::tuple_t>(
                         make_vector<shared_ptr<const ctype::type_t> >(p_impl_seq_ct));
                 //getter_name: make_sequence<sequence<tag, float> >
                 shared_ptr<const templated_name> p_getter_name =
-                    make_shared<const templated_name>(
+                    make_node<const templated_name>(
                         detail::make_sequence(),
                         p_tuple_impl_seq_ct);
                 
                 //Build arguments for extractor
                 shared_ptr<const tuple_t> p_wrapped_tuple_t =
-                    make_shared<const tuple_t>(
+                    make_node<const tuple_t>(
                         make_vector<shared_ptr<const type_t> >(arg.type().ptr()));
                 shared_ptr<const ctype::tuple_t> p_wrapped_tuple_ct =
-                    make_shared<const ctype::tuple_t>(
+                    make_node<const ctype::tuple_t>(
                         make_vector<shared_ptr<const ctype::type_t> >(arg.ctype().ptr()));
                 shared_ptr<const tuple> p_wrapped_name_tuple =
-                    make_shared<const tuple>(
+                    make_node<const tuple>(
                         make_vector<shared_ptr<const expression> >(p_wrapped_name)
-                        (make_shared<const apply>(
-                            make_shared<const name>(copperhead::to_string(m_target)),
-                            make_shared<const tuple>(make_vector<shared_ptr<const expression> >())))
-                        (make_shared<const literal>("false")),
+                        (make_node<const apply>(
+                            make_node<const name>(copperhead::to_string(m_target)),
+                            make_node<const tuple>(make_vector<shared_ptr<const expression> >())))
+                        (make_node<const literal>("false")),
                         p_wrapped_tuple_t, p_wrapped_tuple_ct);
                 shared_ptr<const apply> p_getter_apply =
-                    make_shared<const apply>(p_getter_name,
-                                             p_wrapped_name_tuple);
+                    make_node<const apply>(p_getter_name,
+                                           p_wrapped_name_tuple);
                 
                 //Bind extractor to arg id
                 shared_ptr<const bind> p_extraction =
-                    make_shared<const bind>(
+                    make_node<const bind>(
                         arg.ptr(),
                         p_getter_apply);
                 new_stmts.push_back(p_extraction);
@@ -125,41 +137,223 @@ wrap::result_type wrap::operator()(const procedure &n) {
             shared_ptr<const ctype::type_t> sub_res_t =
                 res_seq_t.sub().ptr();
                 
-            p_c_res_t = make_shared<const ctype::cuarray_t>(
+            p_c_res_t = make_node<const ctype::cuarray_t>(
                 sub_res_t);
         } else {
             p_c_res_t = previous_c_res_t.ptr();
         }
         
 
+        shared_ptr<const ctype::tuple_t> p_new_arg_ct =
+            make_node<const ctype::tuple_t>(
+                std::move(new_arg_p_cts));
         shared_ptr<const ctype::type_t> p_new_ct =
-            make_shared<const ctype::fn_t>(
-                make_shared<const ctype::tuple_t>(
-                    move(new_arg_p_cts)),
+            make_node<const ctype::fn_t>(
+                p_new_arg_ct,
                 p_c_res_t);
 
+        m_returned.clear();
+        vector<shared_ptr<const statement> > body_stmts;
         for(auto i = n.stmts().begin();
             i != n.stmts().end();
             i++) {
-            new_stmts.push_back(
+            body_stmts.push_back(
                 static_pointer_cast<const statement>(
                     boost::apply_visitor(*this, *i)));
         }
         m_wrapping = false;
-        
-        return make_shared<const procedure>(
-            n.id().ptr(),
-            make_shared<const tuple>(
-                move(new_args)),
-            make_shared<const suite>(
-                move(new_stmts)),
-            n.type().ptr(),
-            p_new_ct);
+        new_stmts.insert(new_stmts.end(),
+                         body_stmts.begin(), body_stmts.end());
+
+        shared_ptr<const tuple> p_new_args =
+            make_node<const tuple>(
+                std::move(new_args));
+        vector<shared_ptr<const statement> > procs;
+        procs.push_back(
+            make_node<const procedure>(
+                n.id().ptr(),
+                p_new_args,
+                make_node<const suite>(
+                    std::move(new_stmts)),
+                n.type().ptr(),
+                p_new_ct));
+        if (m_async) {
+            shared_ptr<const procedure> p_async =
+                async_wrapper(n, *p_new_args, p_new_arg_ct, p_c_res_t);
+            if (p_async) {
+                procs.push_back(p_async);
+            }
+        }
+        if (m_batch) {
+            shared_ptr<const suite> p_body =
+                make_node<const suite>(std::move(body_stmts));
+            vector<shared_ptr<const statement> > batched =
+                batch_wrapper(n, *p_new_args, p_new_arg_ct, *p_body,
+                              p_c_res_t);
+            procs.insert(procs.end(), batched.begin(), batched.end());
+        }
+        if (procs.size() == 1) {
+            return procs[0];
+        }
+        return make_node<const suite>(std::move(procs));
     } else {
         return this->rewriter::operator()(n);
     }
 }
 
+shared_ptr<const procedure> wrap::async_wrapper(
+    const procedure& n,
+    const tuple& args,
+    const shared_ptr<const ctype::tuple_t>& p_arg_ct,
+    const shared_ptr<const ctype::type_t>& p_res_t) {
+    if (size_t(args.arity()) > detail::max_async_arity) {
+        return shared_ptr<const procedure>();
+    }
+    //Result: future<sp_cuarray>
+    shared_ptr<const ctype::type_t> p_future_t =
+        make_node<const ctype::polytype_t>(
+            make_vector<shared_ptr<const ctype::type_t> >(p_res_t),
+            make_node<const ctype::monotype_t>("future"));
+    shared_ptr<const ctype::type_t> p_async_ct =
+        make_node<const ctype::fn_t>(
+            p_arg_ct,
+            p_future_t);
+
+    //Body: result = spawn(entry, args...); return result
+    vector<shared_ptr<const expression> > spawn_args;
+    spawn_args.push_back(n.id().ptr());
+    for(auto i = args.begin();
+        i != args.end();
+        i++) {
+        spawn_args.push_back(i->ptr());
+    }
+    shared_ptr<const name> p_result =
+        make_node<const name>(
+            "result",
+            n.type().ptr(),
+            p_future_t);
+    shared_ptr<const bind> p_spawn =
+        make_node<const bind>(
+            p_result,
+            make_node<const apply>(
+                make_node<const name>("spawn"),
+                make_node<const tuple>(
+                    std::move(spawn_args))));
+        
+    return make_node<const procedure>(
+        make_node<const name>(
+            detail::async_proc_id(n.id().id())),
+        args.ptr(),
+        make_node<const suite>(
+            make_vector<shared_ptr<const statement> >(p_spawn)
+            (make_node<const ret>(p_result))),
+        n.type().ptr(),
+        p_async_ct);
+}
+
+vector<shared_ptr<const statement> > wrap::batch_wrapper(
+    const procedure& n,
+    const tuple& args,
+    const shared_ptr<const ctype::tuple_t>& p_arg_ct,
+    const suite& body,
+    const shared_ptr<const ctype::type_t>& p_res_t) {
+    vector<shared_ptr<const statement> > result;
+    if (size_t(args.arity()) > detail::max_batch_arity) {
+        return result;
+    }
+    //Sequences of scalars are batched, scalars are shared
+    bool batched = false;
+    vector<shared_ptr<const ctype::type_t> > body_arg_cts;
+    for(auto i = n.args().begin();
+        i != n.args().end();
+        i++) {
+        const ctype::type_t& ct = i->ctype();
+        if (detail::isinstance<ctype::sequence_t>(ct)) {
+            const ctype::sequence_t& seq_t =
+                detail::up_get<const ctype::sequence_t&>(ct);
+            if (!detail::isinstance<ctype::monotype_t>(seq_t.sub())) {
+                return result;
+            }
+            batched = true;
+        } else if (!detail::isinstance<ctype::monotype_t>(ct)) {
+            return result;
+        }
+        body_arg_cts.push_back(ct.ptr());
+    }
+    if (!batched) {
+        return result;
+    }
+    //So is the result, whose elements are of type E
+    shared_ptr<const ctype::type_t> p_el_t;
+    if (detail::isinstance<ctype::cuarray_t>(*p_res_t)) {
+        p_el_t = detail::up_get<const ctype::cuarray_t&>(*p_res_t).sub().ptr();
+    } else {
+        p_el_t = p_res_t;
+    }
+    if (!detail::isinstance<ctype::monotype_t>(*p_el_t)) {
+        return result;
+    }
+    //The body must build every container it returns, rather than
+    //return the container of an argument
+    detail::binding_finder bf;
+    boost::apply_visitor(bf, body);
+    for(auto i = m_returned.begin(); i != m_returned.end(); i++) {
+        if (bf.bound().count(*i) == 0) {
+            return result;
+        }
+    }
+
+    //-------------Build Body--------------------------
+
+    //The entry point, taking views and returning containers
+    shared_ptr<const name> p_body_name =
+        make_node<const name>(
+            detail::body_proc_id(n.id().id()));
+    result.push_back(
+        make_node<const procedure>(
+            p_body_name,
+            n.args().ptr(),
+            body.ptr(),
+            n.type().ptr(),
+            make_node<const ctype::fn_t>(
+                make_node<const ctype::tuple_t>(
+                    std::move(body_arg_cts)),
+                p_res_t)));
+
+    //-------------Build Batched wrapper---------------
+
+    //Body: return batch<E>(body, args...)
+    vector<shared_ptr<const expression> > batch_args;
+    batch_args.push_back(p_body_name);
+    for(auto i = args.begin();
+        i != args.end();
+        i++) {
+        batch_args.push_back(i->ptr());
+    }
+    shared_ptr<const ret> p_batch =
+        make_node<const ret>(
+            make_node<const apply>(
+                make_node<const templated_name>(
+                    "batch",
+                    make_node<const ctype::tuple_t>(
+                        make_vector<shared_ptr<const ctype::type_t> >(
+                            p_el_t))),
+                make_node<const tuple>(
+                    std::move(batch_args))));
+    result.push_back(
+        make_node<const procedure>(
+            make_node<const name>(
+                detail::batch_proc_id(n.id().id())),
+            args.ptr(),
+            make_node<const suite>(
+                make_vector<shared_ptr<const statement> >(p_batch)),
+            n.type().ptr(),
+            make_node<const ctype::fn_t>(
+                p_arg_ct,
+                make_node<const ctype::cuarray_t>(p_el_t))));
+    return result;
+}
+
 wrap::result_type wrap::operator()(const ret& n) {
     if (m_wrapping && detail::isinstance<name, node>(n.val())) {
         const name& val =
@@ -167,11 +361,12 @@ wrap::result_type wrap::operator()(const ret& n) {
         bool needs_container = detail::container_type(val.ctype()) != val.ctype().ptr();
         if (needs_container) {
             shared_ptr<const name> array_wrapped =
-                make_shared<const name>(
+                make_node<const name>(
                     detail::wrap_array_id(val.id()),
                     val.type().ptr(),
                     val.ctype().ptr());
-            return result_type(new ret(array_wrapped));
+            m_returned.push_back(array_wrapped->sym());
+            return make_node<const ret>(array_wrapped);
         }
     }
     shared_ptr<const ret> rewritten =
@@ -0,0 +1,161 @@
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <atomic>
+#include "check.hpp"
+#include "prelude/prelude.h"
+#include "prelude/runtime/batch.hpp"
+
+using namespace testing;
+using namespace copperhead;
+
+typedef sequence<cpp_tag, int> int_sequence;
+typedef sequence<cpp_tag, int, 1> nested_sequence;
+
+//A nested cuarray with segments of the given lengths, holding
+//0, 1, 2 ... in order
+sp_cuarray segments(const std::vector<size_t>& lengths) {
+    size_t total = 0;
+    for(size_t i = 0; i < lengths.size(); i++) {
+        total += lengths[i];
+    }
+    sp_cuarray result = make_nested_cuarray<int>(lengths.size(), total);
+    nested_sequence s =
+        make_sequence<nested_sequence>(result, cpp_tag(), true);
+    size_t offset = 0;
+    for(size_t i = 0; i < lengths.size(); i++) {
+        s.m_d[i] = offset;
+        offset += lengths[i];
+    }
+    s.m_d[lengths.size()] = offset;
+    for(size_t i = 0; i < total; i++) {
+        s.m_s.m_d[i] = (int)i;
+    }
+    return result;
+}
+
+//Segments of lengths 0, 1, ... n-1
+sp_cuarray triangle(size_t n) {
+    std::vector<size_t> lengths;
+    for(size_t i = 0; i < n; i++) {
+        lengths.push_back(i);
+    }
+    return segments(lengths);
+}
+
+int total(int_sequence x, int k) {
+    int result = k;
+    for(size_t i = 0; i < x.size(); i++) {
+        result += x[i];
+    }
+    return result;
+}
+
+sp_cuarray doubled(int_sequence x) {
+    sp_cuarray result = make_cuarray<int>(x.size());
+    int_sequence y = make_sequence<int_sequence>(result, cpp_tag(), true);
+    for(size_t i = 0; i < x.size(); i++) {
+        y[i] = 2 * x[i];
+    }
+    return result;
+}
+
+int difference(int_sequence x, int_sequence y) {
+    return (int)x.size() - (int)y.size();
+}
+
+std::atomic<int> finished(0);
+
+//Throws for the empty segment, which comes first
+int fails_on_empty(int_sequence x) {
+    if (x.size() == 0) {
+        throw std::runtime_error("empty");
+    }
+    finished++;
+    return 0;
+}
+
+//Scalar results are gathered into a flat cuarray, in segment order.
+//Scalar arguments are passed to every invocation.
+void test_scalar_results() {
+    sp_cuarray a = triangle(100);
+    sp_cuarray r = batch<int>(&total, a, 1);
+    int_sequence s = make_sequence<int_sequence>(r, cpp_tag(), false);
+    CHECK(s.size() == 100);
+    bool same = true;
+    int offset = 0;
+    for(int i = 0; i < 100 && s.size() == 100; i++) {
+        //The sum of offset ... offset + i - 1, and 1
+        int expected = 1 + i * offset + i * (i - 1) / 2;
+        same = same && (s[i] == expected);
+        offset += i;
+    }
+    CHECK(same);
+}
+
+//Sequence results are gathered into a nested cuarray
+void test_nested_results() {
+    sp_cuarray a = triangle(50);
+    sp_cuarray r = batch<int>(&doubled, a);
+    nested_sequence s = make_sequence<nested_sequence>(r, cpp_tag(), false);
+    CHECK(s.size() == 50);
+    bool same = true;
+    int value = 0;
+    for(size_t i = 0; i < 50 && s.size() == 50; i++) {
+        int_sequence segment = s[i];
+        same = same && (segment.size() == i);
+        for(size_t j = 0; j < segment.size(); j++) {
+            same = same && (segment[j] == 2 * value++);
+        }
+    }
+    CHECK(same);
+}
+
+//Batched arguments must have as many segments as each other
+void test_mismatched_segments() {
+    bool threw = false;
+    try {
+        batch<int>(&difference, triangle(3), triangle(4));
+    } catch(std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    sp_cuarray r = batch<int>(&difference, triangle(4), triangle(4));
+    CHECK(r->size() == 4);
+}
+
+//No segments, no invocations
+void test_zero_segments() {
+    sp_cuarray a = segments(std::vector<size_t>());
+    sp_cuarray r = batch<int>(&total, a, 1);
+    CHECK(r->size() == 0);
+    sp_cuarray n = batch<int>(&doubled, a);
+    nested_sequence s = make_sequence<nested_sequence>(n, cpp_tag(), false);
+    CHECK(s.size() == 0);
+}
+
+//An invocation which throws fails the batch, once every other group
+//of invocations has finished
+void test_errors() {
+    bool threw = false;
+    size_t n = 1000;
+    try {
+        batch<int>(&fails_on_empty, triangle(n));
+    } catch(std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    //Only the first group, which holds the empty segment, stops early,
+    //and every other group has run to the end
+    size_t groups = std::min(n, 4 * detail::worker_count());
+    CHECK(finished == (int)(n - n / groups));
+}
+
+int main() {
+    test_scalar_results();
+    test_nested_results();
+    test_mismatched_segments();
+    test_zero_segments();
+    test_errors();
+    return report("batch_test");
+}
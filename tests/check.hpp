@@ -0,0 +1,51 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ */
+
+//Checking the results of a test
+
+#pragma once
+#include <string>
+#include <iostream>
+
+namespace testing {
+
+static int failures = 0;
+
+#define CHECK(cond) testing::check((cond), #cond, __FILE__, __LINE__)
+
+inline void check(bool ok, const char* what, const char* file, int line) {
+    if (!ok) {
+        std::cout << file << ":" << line << ": check failed: "
+                  << what << std::endl;
+        failures++;
+    }
+}
+
+inline int report(const char* test) {
+    if (failures) {
+        std::cout << test << ": " << failures << " failure(s)" << std::endl;
+        return 1;
+    }
+    std::cout << test << ": ok" << std::endl;
+    return 0;
+}
+
+inline bool contains(const std::string& text, const std::string& part) {
+    return text.find(part) != std::string::npos;
+}
+
+}
@@ -0,0 +1,120 @@
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+#include <dirent.h>
+#include "program.hpp"
+#include "compile_cache.hpp"
+
+using namespace testing;
+
+//f(a, b), which returns map2(op, a, b)
+shared_ptr<const suite> map_program(const string& op) {
+    return entry({let(sequence("c"), map2(op, "a", "b")),
+                  give(sequence("c"))});
+}
+
+string temporary_dir() {
+    char dir[] = "/tmp/copperhead_cacheXXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    //The cache creates missing directories itself
+    return string(dir) + "/cache";
+}
+
+//The names of the files in a directory
+vector<string> files(const string& dir) {
+    vector<string> result;
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) {
+        return result;
+    }
+    while(struct dirent* e = readdir(d)) {
+        string file(e->d_name);
+        if ((file != ".") && (file != "..")) {
+            result.push_back(file);
+        }
+    }
+    closedir(d);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void overwrite(const string& path, const string& contents) {
+    std::ofstream f(path.c_str(), std::ios::binary);
+    f << contents;
+}
+
+//Keys depend on the structure of the program and the entry point,
+//not on the identity of its nodes
+void test_keys() {
+    compile_cache cache(temporary_dir());
+    copperhead::system_variant t = copperhead::cpp_tag();
+    string key = cache.key(*map_program("op_add"), "f", t);
+    CHECK(key == cache.key(*map_program("op_add"), "f", t));
+    CHECK(key != cache.key(*map_program("op_sub"), "f", t));
+    CHECK(key != cache.key(*map_program("op_add"), "g", t));
+    string canonical = cache.canonical(*map_program("op_add"), "f", t);
+    CHECK(canonical == cache.canonical(*map_program("op_add"), "f", t));
+    CHECK(canonical != cache.canonical(*map_program("op_sub"), "f", t));
+    CHECK(key == cache.key(canonical));
+}
+
+//Artifacts are found under the serialization and suffix they were
+//stored with, and only their files are left in the directory
+void test_store_and_lookup() {
+    compile_cache cache(temporary_dir());
+    string contents;
+    CHECK(!cache.lookup("a program", ".cpp", contents));
+    CHECK(cache.store("a program", ".cpp", "int x;"));
+    CHECK(cache.lookup("a program", ".cpp", contents));
+    CHECK(contents == "int x;");
+    CHECK(!cache.lookup("a program", ".so", contents));
+    CHECK(!cache.lookup("another program", ".cpp", contents));
+    string key = cache.key("a program");
+    vector<string> stored = files(cache.dir());
+    CHECK(stored.size() == 2);
+    CHECK(stored.size() == 2 && stored[0] == key + ".cpp");
+    CHECK(stored.size() == 2 && stored[1] == key + ".key");
+}
+
+//A serialization whose key is owned by another, as when two keys
+//collide, neither finds nor replaces the other's artifacts
+void test_collisions() {
+    compile_cache cache(temporary_dir());
+    string contents;
+    CHECK(cache.store("a program", ".cpp", "int x;"));
+    string key = cache.key("a program");
+    overwrite(cache.path(key, ".key"), "a colliding program");
+    CHECK(!cache.lookup("a program", ".cpp", contents));
+    CHECK(!cache.store("a program", ".cpp", "int y;"));
+    //Once the key is free again, the serialization claims it
+    std::remove(cache.path(key, ".key").c_str());
+    CHECK(!cache.lookup("a program", ".cpp", contents));
+    CHECK(cache.store("a program", ".cpp", "int z;"));
+    CHECK(cache.lookup("a program", ".cpp", contents));
+    CHECK(contents == "int z;");
+}
+
+//The compiler returns the cached code for a program it has seen
+void test_compiler_uses_cache() {
+    auto cache = std::make_shared<compile_cache>(temporary_dir());
+    compiler comp("f", copperhead::cpp_tag());
+    comp.set_cache(cache);
+    shared_ptr<const suite> p = map_program("op_add");
+    string code = comp.code(*p);
+    string canonical = cache->canonical(*p, "f", copperhead::cpp_tag());
+    string stored;
+    CHECK(cache->lookup(canonical, ".cpp", stored));
+    CHECK(stored == code);
+    //Replace the entry, to tell a cache hit from a recompilation
+    CHECK(cache->store(canonical, ".cpp", "cached"));
+    CHECK(comp.code(*map_program("op_add")) == "cached");
+    CHECK(comp.code(*map_program("op_sub")) != "cached");
+}
+
+int main() {
+    test_keys();
+    test_store_and_lookup();
+    test_collisions();
+    test_compiler_uses_cache();
+    return report("compile_cache_test");
+}
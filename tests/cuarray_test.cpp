@@ -0,0 +1,241 @@
+#include <stdexcept>
+#include <vector>
+#include <boost/weak_ptr.hpp>
+#include "check.hpp"
+#include "prelude/runtime/make_cuarray.hpp"
+#include "prelude/runtime/make_sequence.hpp"
+#include "prelude/runtime/mempool.hpp"
+
+using namespace testing;
+using namespace copperhead;
+
+typedef sequence<cpp_tag, int> int_sequence;
+
+sp_cuarray iota(size_t n) {
+    sp_cuarray result = make_cuarray<int>(n);
+    int_sequence x = make_sequence<int_sequence>(result, cpp_tag(), true);
+    for(size_t i = 0; i < n; i++) {
+        x[i] = (int)i;
+    }
+    return result;
+}
+
+//Shrinking before the lazy allocation allocates only the smaller size
+void test_shrink_before_allocation() {
+    sp_cuarray a = make_cuarray<int>(100);
+    a->shrink(10);
+    CHECK(a->size() == 10);
+    mempool_stats before = get_stats(cpp_tag());
+    int_sequence x = make_sequence<int_sequence>(a, cpp_tag(), true);
+    CHECK(x.size() == 10);
+    CHECK(get_stats(cpp_tag()).requested_bytes - before.requested_bytes ==
+          10 * sizeof(int));
+    CHECK(a->get_chunks(cpp_tag(), false)[0]->size() == 10 * sizeof(int));
+}
+
+//Shrinking after the allocation keeps the storage and the elements
+//which remain
+void test_shrink_after_allocation() {
+    sp_cuarray a = iota(100);
+    int* p = make_sequence<int_sequence>(a, cpp_tag(), false).m_d;
+    a->shrink(10);
+    CHECK(a->size() == 10);
+    int_sequence x = make_sequence<int_sequence>(a, cpp_tag(), false);
+    CHECK(x.m_d == p);
+    CHECK(x.size() == 10);
+    bool same = true;
+    for(int i = 0; i < 10; i++) {
+        same = same && (x[i] == i);
+    }
+    CHECK(same);
+    //Shrinking to the same length does nothing
+    a->shrink(10);
+    CHECK(a->size() == 10);
+    a->shrink(0);
+    CHECK(a->size() == 0);
+}
+
+//Cuarrays only shrink, and only when flat
+void test_shrink_errors() {
+    sp_cuarray a = make_cuarray<int>(10);
+    bool threw = false;
+    try {
+        a->shrink(11);
+    } catch(std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(a->size() == 10);
+
+    sp_cuarray n = make_nested_cuarray<int>(2, 10);
+    threw = false;
+    try {
+        n->shrink(1);
+    } catch(std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+//Marks when the owner of an external buffer is released
+struct release_flag {
+    bool* m_released;
+    release_flag(bool* released) : m_released(released) {}
+    void operator()(void*) const {
+        *m_released = true;
+    }
+};
+
+//A cuarray made over an external buffer uses it in place, never
+//frees it, and holds keep until the cuarray is destroyed
+void test_external_buffer() {
+    std::vector<int> buffer(10);
+    for(int i = 0; i < 10; i++) {
+        buffer[i] = i;
+    }
+    bool released = false;
+    boost::shared_ptr<void> keep((void*)0, release_flag(&released));
+    boost::weak_ptr<void> watch(keep);
+    mempool_stats before = get_stats(cpp_tag());
+    sp_cuarray a = make_cuarray<int>(cpp_tag(), &buffer[0], 10, keep);
+    keep.reset();
+    CHECK(!released);
+    CHECK(!watch.expired());
+
+    int_sequence x = make_sequence<int_sequence>(a, cpp_tag(), true);
+    CHECK(x.m_d == &buffer[0]);
+    CHECK(x.size() == 10);
+    x[3] = 30;
+    CHECK(buffer[3] == 30);
+    mempool_stats used = get_stats(cpp_tag());
+    CHECK(used.requested_bytes == before.requested_bytes);
+    CHECK(used.live_bytes == before.live_bytes);
+
+    a.reset();
+    CHECK(released);
+    CHECK(watch.expired());
+    mempool_stats after = get_stats(cpp_tag());
+    CHECK(after.live_bytes == before.live_bytes);
+    CHECK(after.cached_bytes == before.cached_bytes);
+    CHECK(buffer[3] == 30);
+}
+
+range_set ranges(size_t b0, size_t e0) {
+    return range_set(1, std::make_pair(b0, e0));
+}
+
+range_set ranges(size_t b0, size_t e0, size_t b1, size_t e1) {
+    range_set result = ranges(b0, e0);
+    result.push_back(std::make_pair(b1, e1));
+    return result;
+}
+
+//Overlapping and adjacent ranges merge, others stay sorted and apart
+void test_add_range() {
+    range_set s;
+    detail::add_range(s, 20, 30);
+    detail::add_range(s, 0, 10);
+    CHECK(s == ranges(0, 10, 20, 30));
+    detail::add_range(s, 5, 5);
+    CHECK(s == ranges(0, 10, 20, 30));
+    detail::add_range(s, 10, 15);
+    CHECK(s == ranges(0, 15, 20, 30));
+    detail::add_range(s, 25, 40);
+    CHECK(s == ranges(0, 15, 20, 40));
+    detail::add_range(s, 12, 22);
+    CHECK(s == ranges(0, 40));
+}
+
+//Removing from the middle of a range splits it
+void test_remove_range() {
+    range_set s = ranges(0, 10, 20, 30);
+    detail::remove_range(s, 5, 25);
+    CHECK(s == ranges(0, 5, 25, 30));
+    detail::remove_range(s, 10, 20);
+    CHECK(s == ranges(0, 5, 25, 30));
+    detail::remove_range(s, 26, 28);
+    range_set split = ranges(0, 5, 25, 26);
+    split.push_back(std::make_pair(28, 30));
+    CHECK(s == split);
+    detail::remove_range(s, 0, 30);
+    CHECK(s.empty());
+}
+
+void test_intersect_range() {
+    range_set s = ranges(0, 10, 20, 30);
+    CHECK(detail::intersect_range(s, 5, 25) == ranges(5, 10, 20, 25));
+    CHECK(detail::intersect_range(s, 10, 20).empty());
+    CHECK(detail::intersect_range(s, 0, 30) == s);
+    CHECK(detail::intersect_range(s, 22, 24) == ranges(22, 24));
+}
+
+//A write to part of a cuarray leaves the rest of its copy in the other
+//memory space valid.  Reads of the valid part copy nothing, and a
+//later read of the whole copies only the part written.
+void test_partial_write() {
+#ifdef CUDA_SUPPORT
+    typedef sequence<cuda_tag, int> cuda_sequence;
+    sp_cuarray a = iota(100);
+    make_sequence<cuda_sequence>(a, cuda_tag(), false);
+    CHECK(a->m_d[cuda_tag()].second.empty());
+
+    int_sequence x = make_sequence<int_sequence>(a, cpp_tag(), true, 10, 20);
+    CHECK(x.size() == 10);
+    for(int i = 0; i < 10; i++) {
+        x[i] = 1000 + i;
+    }
+    CHECK(a->m_d[cuda_tag()].second == ranges(10, 20));
+    CHECK(a->m_d[cpp_tag()].second.empty());
+
+    //Only the prefix is needed, so nothing is copied
+    cuda_sequence p = make_sequence<cuda_sequence>(a, cuda_tag(), false, 0, 10);
+    CHECK(p.size() == 10);
+    CHECK(a->m_d[cuda_tag()].second == ranges(10, 20));
+
+    make_sequence<cuda_sequence>(a, cuda_tag(), false);
+    CHECK(a->m_d[cuda_tag()].second.empty());
+
+    //Writing the whole in the other space, and reading it back, shows
+    //what the other space holds
+    make_sequence<cuda_sequence>(a, cuda_tag(), true);
+    CHECK(a->m_d[cpp_tag()].second == ranges(0, 100));
+    int_sequence y = make_sequence<int_sequence>(a, cpp_tag(), false);
+    bool same = true;
+    for(int i = 0; i < 100; i++) {
+        int expected = ((i >= 10) && (i < 20)) ? 1000 + i - 10 : i;
+        same = same && (y[i] == expected);
+    }
+    CHECK(same);
+#endif
+}
+
+//Migrations large enough to be split into blocks, which are copied
+//in parallel, arrive whole, including a final partial block
+void test_large_migration() {
+#ifdef CUDA_SUPPORT
+    typedef sequence<cuda_tag, int> cuda_sequence;
+    size_t n = (1 << 20) + 7;
+    sp_cuarray a = iota(n);
+    make_sequence<cuda_sequence>(a, cuda_tag(), true);
+    CHECK(a->m_d[cpp_tag()].second == ranges(0, n));
+    int_sequence x = make_sequence<int_sequence>(a, cpp_tag(), false);
+    bool same = true;
+    for(size_t i = 0; i < n; i++) {
+        same = same && (x[i] == (int)i);
+    }
+    CHECK(same);
+#endif
+}
+
+int main() {
+    test_shrink_before_allocation();
+    test_shrink_after_allocation();
+    test_shrink_errors();
+    test_external_buffer();
+    test_add_range();
+    test_remove_range();
+    test_intersect_range();
+    test_partial_write();
+    test_large_migration();
+    return report("cuarray_test");
+}
@@ -0,0 +1,70 @@
+#include <vector>
+#include <algorithm>
+#include "check.hpp"
+
+//A small threshold, so both ways of filtering are tested on small
+//inputs
+#define COPPERHEAD_FILTER_COUNT_THRESHOLD 16
+#include "prelude/prelude.h"
+#include "prelude/primitives/filter.h"
+
+using namespace testing;
+using namespace copperhead;
+
+typedef sequence<cpp_tag, int> int_sequence;
+
+struct below {
+    typedef bool result_type;
+    int m_n;
+    below(int n) : m_n(n) {}
+    bool operator()(const int& x) const {
+        return x < m_n;
+    }
+};
+
+//Filters 0, 1, ... n-1, keeping the elements below k
+void check_filter(int n, int k) {
+    sp_cuarray x_ary = make_cuarray<int>(n);
+    int_sequence x = make_sequence<int_sequence>(x_ary, cpp_tag(), true);
+    for(int i = 0; i < n; i++) {
+        x[i] = i;
+    }
+    int kept = std::max(0, std::min(n, k));
+    mempool_stats before = get_stats(cpp_tag());
+    sp_cuarray r_ary = filter(below(k), x);
+    int_sequence r = make_sequence<int_sequence>(r_ary, cpp_tag(), false);
+    size_t requested = get_stats(cpp_tag()).requested_bytes -
+        before.requested_bytes;
+    CHECK(r.size() == (size_t)kept);
+    CHECK(r_ary->get_chunks(cpp_tag(), false)[0]->size() ==
+          kept * sizeof(int));
+    bool same = true;
+    for(int i = 0; i < kept; i++) {
+        same = same && (r[i] == i);
+    }
+    CHECK(same);
+    //Large inputs are counted first, and allocate only the result;
+    //small ones allocate as much as the input
+    if (n >= COPPERHEAD_FILTER_COUNT_THRESHOLD) {
+        CHECK(requested == kept * sizeof(int));
+    } else {
+        CHECK(requested == n * sizeof(int));
+    }
+}
+
+void test_filter() {
+    const int sizes[] = {0, 1, COPPERHEAD_FILTER_COUNT_THRESHOLD - 1,
+                         COPPERHEAD_FILTER_COUNT_THRESHOLD, 100};
+    for(int i = 0; i < 5; i++) {
+        int n = sizes[i];
+        //None, some and all of the elements
+        check_filter(n, 0);
+        check_filter(n, n / 2);
+        check_filter(n, n);
+    }
+}
+
+int main() {
+    test_filter();
+    return report("filter_test");
+}
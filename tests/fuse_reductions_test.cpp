@@ -0,0 +1,77 @@
+#include "program.hpp"
+
+using namespace testing;
+
+shared_ptr<const apply> reduce(const string& x,
+                               const shared_ptr<const expression>& p) {
+    return invoke(var("reduce", fn({op(), seq(int32_mt), int32_mt},
+                                   int32_mt)),
+                  {var("op_add", op()), sequence(x), p});
+}
+
+shared_ptr<const apply> reduce(const string& x) {
+    return reduce(x, lit("0", int32_mt));
+}
+
+shared_ptr<const apply> sum(const string& x) {
+    return invoke(var("sum", fn({seq(int32_mt)}, int32_mt)), {sequence(x)});
+}
+
+//f(a, b) computes s and t with the given body, and returns s + t
+string compile_sums(vector<shared_ptr<const statement> > body) {
+    body.push_back(
+        let(scalar("u"), invoke(var("op_add", op()),
+                                {scalar("s"), scalar("t")})));
+    body.push_back(give(scalar("u")));
+    string code = compile(std::move(body), int32_mt);
+    CHECK(compiles(code));
+    return code;
+}
+
+//sum(x) and sum(x*x) are computed in one sweep
+void test_sums() {
+    string code = compile_sums(
+        {let(sequence("c"), map2("op_mul", "a", "a")),
+         let(scalar("s"), sum("a")),
+         let(scalar("t"), sum("c"))});
+    CHECK(contains(code, "reduce2(fn_op_add<int >(), a, (int)0, "
+                   "fn_op_add<int >(), c, (int)0)"));
+    CHECK(!contains(code, "sum("));
+}
+
+//Every map is bound before the first reduction
+void test_maps_first() {
+    string code = compile_sums(
+        {let(sequence("c"), map2("op_add", "a", "b")),
+         let(sequence("q"), map2("op_mul", "a", "b")),
+         let(scalar("s"), reduce("c")),
+         let(scalar("t"), reduce("q"))});
+    CHECK(contains(code, "reduce2("));
+}
+
+//A map is bound between the reductions
+void test_map_between() {
+    string code = compile_sums(
+        {let(sequence("c"), map2("op_add", "a", "b")),
+         let(scalar("s"), reduce("c")),
+         let(sequence("q"), map2("op_mul", "a", "b")),
+         let(scalar("t"), reduce("q"))});
+    CHECK(contains(code, "reduce2("));
+}
+
+//A reduction which depends on another is not fused with it
+void test_dependent() {
+    string code = compile_sums(
+        {let(scalar("s"), reduce("a")),
+         let(sequence("c"), map2("op_add", "a", "b")),
+         let(scalar("t"), reduce("c", scalar("s")))});
+    CHECK(!contains(code, "reduce2("));
+}
+
+int main() {
+    test_sums();
+    test_maps_first();
+    test_map_between();
+    test_dependent();
+    return report("fuse_reductions_test");
+}
@@ -0,0 +1,123 @@
+#include "program.hpp"
+
+using namespace testing;
+
+shared_ptr<const name> indices(const string& id) {
+    return var(id, seq(int64_mt));
+}
+
+shared_ptr<const apply> scatter(const string& x, const string& i,
+                                const string& d) {
+    auto scatter = var("scatter", fn({seq(int32_mt), seq(int64_mt),
+                                      seq(int32_mt)}, seq(int32_mt)));
+    return invoke(scatter, {sequence(x), indices(i), sequence(d)});
+}
+
+shared_ptr<const apply> permute(const string& x, const string& i) {
+    auto permute = var("permute", fn({seq(int32_mt), seq(int64_mt)},
+                                     seq(int32_mt)));
+    return invoke(permute, {sequence(x), indices(i)});
+}
+
+//f(a, b, i), where i holds indices into a and b
+string compile_indexed(vector<shared_ptr<const statement> > body) {
+    return compile(*program(
+        {proc("f", {sequence("a"), sequence("b"), indices("i")},
+              std::move(body), seq(int32_mt))}));
+}
+
+//The data scattered is read straight from the map producing it
+void test_scatter_data() {
+    string code = compile_indexed(
+        {let(sequence("c"), map2("op_add", "a", "b")),
+         let(sequence("d"), scatter("c", "i", "b")),
+         give(sequence("d"))});
+    CHECK(contains(code, "Tc c = map2(fn_op_add<int >(), a, b);"));
+    CHECK(contains(code, "Taryd aryd = scatter(c, i, b);"));
+    CHECK(!contains(code, "phase_boundary("));
+    CHECK(compiles(code));
+}
+
+//The destination scattered into is copied straight from the map
+//producing it
+void test_scatter_destination() {
+    string code = compile_indexed(
+        {let(sequence("c"), map2("op_add", "a", "b")),
+         let(sequence("d"), scatter("a", "i", "c")),
+         give(sequence("d"))});
+    CHECK(contains(code, "Taryd aryd = scatter(a, i, c);"));
+    CHECK(!contains(code, "phase_boundary("));
+    CHECK(compiles(code));
+}
+
+void test_permute() {
+    string code = compile_indexed(
+        {let(sequence("c"), map2("op_add", "a", "b")),
+         let(sequence("d"), permute("c", "i")),
+         give(sequence("d"))});
+    CHECK(contains(code, "Taryd aryd = permute(c, i);"));
+    CHECK(!contains(code, "phase_boundary("));
+    CHECK(compiles(code));
+}
+
+void test_adjacent_difference() {
+    auto adjacent_difference = var("adjacent_difference",
+                                   fn({seq(int32_mt)}, seq(int32_mt)));
+    string code = compile(
+        {let(sequence("c"), map2("op_add", "a", "b")),
+         let(sequence("d"), invoke(adjacent_difference, {sequence("c")})),
+         give(sequence("d"))});
+    CHECK(contains(code, "Taryd aryd = adjacent_difference(c);"));
+    CHECK(!contains(code, "phase_boundary("));
+    CHECK(compiles(code));
+}
+
+//A map read by two primitives is materialized once for both
+void test_two_consumers() {
+    string code = compile_indexed(
+        {let(sequence("c"), map2("op_add", "a", "b")),
+         let(sequence("d"), permute("c", "i")),
+         let(sequence("e"), scatter("c", "i", "d")),
+         give(sequence("e"))});
+    CHECK(contains(code, "Tarycompc arycompc = phase_boundary(c);"));
+    CHECK(contains(code, "Taryd aryd = permute(compc, i);"));
+    CHECK(compiles(code));
+}
+
+//A producer which is rebound, as a loop rebinds the variables it
+//carries, is materialized where the boundary was.  Rebinding a map
+//is not valid C++ on its own, so the output is not compiled.
+void test_rebound_producer() {
+    string code = compile_indexed(
+        {let(sequence("c"), map2("op_add", "a", "b")),
+         let(sequence("c"), map2("op_mul", "c", "b")),
+         let(sequence("d"), permute("c", "i")),
+         give(sequence("d"))});
+    CHECK(contains(code, "Tarycompc arycompc = phase_boundary(c);"));
+    CHECK(contains(code, "Taryd aryd = permute(compc, i);"));
+}
+
+//A sort reorders its input in place, so the map it consumes is
+//still materialized first
+void test_sort_keeps_boundary() {
+    auto cmp = fn({int32_mt, int32_mt}, bool_mt);
+    auto sort = var("sort", fn({cmp, seq(int32_mt)}, seq(int32_mt)));
+    string code = compile(
+        {let(sequence("c"), map2("op_add", "a", "b")),
+         let(sequence("d"), invoke(sort, {var("cmp_lt", cmp),
+                                          sequence("c")})),
+         give(sequence("d"))});
+    CHECK(contains(code, "phase_boundary(c);"));
+    CHECK(compiles(code));
+}
+
+int main() {
+    test_scatter_data();
+    test_scatter_destination();
+    test_permute();
+    test_adjacent_difference();
+    test_two_consumers();
+    test_rebound_producer();
+    test_sort_keeps_boundary();
+    return report("fuse_test");
+}
@@ -0,0 +1,58 @@
+#include "program.hpp"
+#include "hash_cons.hpp"
+#include "cppnode.hpp"
+#include "ctype.hpp"
+
+using namespace testing;
+
+shared_ptr<const node> sequence_getter(
+    const shared_ptr<const ctype::type_t>& element) {
+    return std::make_shared<const templated_name>(
+        "make_sequence",
+        std::make_shared<const ctype::tuple_t>(
+            vector<shared_ptr<const ctype::type_t> >{
+                std::make_shared<const ctype::sequence_t>(element)}));
+}
+
+//Templated names which differ only in their template arguments
+//must not be shared
+void test_templated_names() {
+    hash_cons hc;
+    shared_ptr<const node> i = hc(*sequence_getter(ctype::int32_mt));
+    shared_ptr<const node> f = hc(*sequence_getter(ctype::float32_mt));
+    shared_ptr<const node> i2 = hc(*sequence_getter(ctype::int32_mt));
+    CHECK(i != f);
+    CHECK(i == i2);
+}
+
+//A procedure taking sequences of two element types keeps both
+void test_hash_consed_program() {
+    auto a = var("a", seq(int32_mt));
+    auto b = var("b", seq(float32_mt));
+    auto c = var("c", seq(int32_mt));
+    auto d = var("d", seq(float32_mt));
+    auto int_op = fn({int32_mt, int32_mt}, int32_mt);
+    auto float_op = fn({float32_mt, float32_mt}, float32_mt);
+    auto int_map = var("map2", fn({int_op, seq(int32_mt), seq(int32_mt)},
+                                  seq(int32_mt)));
+    auto float_map = var("map2", fn({float_op, seq(float32_mt), seq(float32_mt)},
+                                    seq(float32_mt)));
+    auto p = proc(
+        "f", {a, b},
+        {let(c, invoke(int_map, {var("op_add", int_op), a, a})),
+         let(d, invoke(float_map, {var("op_add", float_op), b, b})),
+         give(d)},
+        seq(float32_mt));
+    compiler comp("f", copperhead::cpp_tag());
+    comp.set_hash_consing(true);
+    string code = comp.code(*program({p}));
+    CHECK(contains(code, "make_sequence<sequence<cpp_tag, int> >(arya"));
+    CHECK(contains(code, "make_sequence<sequence<cpp_tag, float> >(aryb"));
+    CHECK(compiles(code));
+}
+
+int main() {
+    test_templated_names();
+    test_hash_consed_program();
+    return report("hash_cons_test");
+}
@@ -0,0 +1,109 @@
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include "program.hpp"
+#include "procedure_cache.hpp"
+
+using namespace testing;
+
+//combine(x, y) = op(x, y), mapped by the entry point f
+shared_ptr<const suite> two_procedures(const string& op_id) {
+    return program(
+        {proc("combine", {scalar("x"), scalar("y")},
+              {let(scalar("z"), invoke(var(op_id, op()),
+                                       {scalar("x"), scalar("y")})),
+               give(scalar("z"))},
+              int32_mt),
+         proc("f", {sequence("a"), sequence("b")},
+              {let(sequence("c"), map2("combine", "a", "b")),
+               give(sequence("c"))},
+              seq(int32_mt))});
+}
+
+//Recompiling reuses the lowered procedures, and produces what a
+//fresh compilation would
+void test_incremental() {
+    compiler comp("f", copperhead::cpp_tag());
+    comp.set_incremental(true);
+    string first = comp.code(*two_procedures("op_add"));
+    CHECK(first == compile(*two_procedures("op_add")));
+    CHECK(comp.procedures().size() > 0);
+
+    size_t hits = comp.procedures().hits();
+    string again = comp.code(*two_procedures("op_add"));
+    CHECK(again == first);
+    CHECK(comp.procedures().hits() > hits);
+
+    //Changing a callee recompiles it and its callers
+    string changed = comp.code(*two_procedures("op_mul"));
+    CHECK(changed == compile(*two_procedures("op_mul")));
+    CHECK(contains(changed, "op_mul"));
+    CHECK(compiles(changed));
+}
+
+//Allocating the AST from an arena does not change the result
+void test_arena() {
+    compiler comp("f", copperhead::cpp_tag());
+    comp.set_arena(true);
+    string code = comp.code(*two_procedures("op_add"));
+    CHECK(code == compile(*two_procedures("op_add")));
+    //Compiling again starts a fresh arena
+    CHECK(comp.code(*two_procedures("op_mul")) ==
+          compile(*two_procedures("op_mul")));
+    //Incremental compilations don't use the arena, but still agree
+    comp.set_incremental(true);
+    CHECK(comp.code(*two_procedures("op_add")) == code);
+    CHECK(comp.code(*two_procedures("op_add")) == code);
+}
+
+//Threads in the scope of one arena carve from blocks of their own,
+//and what they leave unused is handed to later scopes
+void test_arena_threads() {
+    auto arena = std::make_shared<ast_arena>(1024);
+    const int threads = 4;
+    const int objects = 100;
+    vector<vector<std::uintptr_t> > carved(threads);
+    vector<std::thread> workers;
+    for(int t = 0; t < threads; t++) {
+        workers.push_back(std::thread([&, t]() {
+                    arena_scope scope(arena.get());
+                    for(int i = 0; i < objects; i++) {
+                        carved[t].push_back(std::uintptr_t(
+                            make_node<std::uint64_t>(i).get()));
+                    }
+                }));
+    }
+    for(auto i = workers.begin(); i != workers.end(); i++) {
+        i->join();
+    }
+    vector<std::uintptr_t> all;
+    bool aligned = true;
+    for(int t = 0; t < threads; t++) {
+        for(auto i = carved[t].begin(); i != carved[t].end(); i++) {
+            aligned = aligned && (*i % alignof(std::uint64_t) == 0);
+            all.push_back(*i);
+        }
+    }
+    std::sort(all.begin(), all.end());
+    CHECK(aligned);
+    CHECK(std::unique(all.begin(), all.end()) == all.end());
+    CHECK(arena->allocated() > threads * objects * sizeof(std::uint64_t));
+    //A scope which leaves most of its block unused hands it on
+    {
+        arena_scope scope(arena.get());
+        make_node<std::uint64_t>(0);
+    }
+    size_t blocks = arena->blocks();
+    {
+        arena_scope scope(arena.get());
+        make_node<std::uint64_t>(0);
+    }
+    CHECK(arena->blocks() == blocks);
+}
+
+int main() {
+    test_incremental();
+    test_arena();
+    test_arena_threads();
+    return report("incremental_test");
+}
@@ -0,0 +1,88 @@
+#include <fstream>
+#include <cstdio>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "check.hpp"
+#include "prelude/runtime/mapped_file.hpp"
+
+using namespace testing;
+using namespace copperhead;
+
+//A read-only mapping may be written, but the file keeps its contents
+void test_read_only_mapping() {
+    char path[] = "/tmp/copperhead_mappedXXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+    {
+        std::ofstream out(path, std::ios::binary);
+        int values[4] = {1, 2, 3, 4};
+        out.write((const char*)values, sizeof(values));
+    }
+    {
+        boost::shared_ptr<void> mapping =
+            detail::map_file(path, sizeof(int), 2 * sizeof(int), false);
+        int* p = static_cast<int*>(mapping.get());
+        CHECK(p[0] == 2);
+        CHECK(p[1] == 3);
+        p[0] = 20;
+        CHECK(p[0] == 20);
+    }
+    {
+        std::ifstream in(path, std::ios::binary);
+        int values[4];
+        in.read((char*)values, sizeof(values));
+        CHECK(values[1] == 2);
+    }
+    unlink(path);
+}
+
+//A writable mapping carries writes through to the file
+void test_writable_mapping() {
+    char path[] = "/tmp/copperhead_mappedXXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+    {
+        boost::shared_ptr<void> mapping =
+            detail::map_file(path, 0, 2 * sizeof(int), true);
+        int* p = static_cast<int*>(mapping.get());
+        p[0] = 5;
+        p[1] = 6;
+    }
+    {
+        std::ifstream in(path, std::ios::binary);
+        int values[2] = {0, 0};
+        in.read((char*)values, sizeof(values));
+        CHECK(values[0] == 5);
+        CHECK(values[1] == 6);
+    }
+    unlink(path);
+}
+
+//A failed flush is reported
+void test_sync_failure() {
+    size_t page = sysconf(_SC_PAGESIZE);
+    void* p = mmap(0, page, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK(p != MAP_FAILED);
+    sp_cuarray a = make_cuarray<int>(cpp_tag(), static_cast<int*>(p),
+                                     page / sizeof(int));
+    sync(a);
+    munmap(p, page);
+    bool threw = false;
+    try {
+        sync(a);
+    } catch(std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+int main() {
+    test_read_only_mapping();
+    test_writable_mapping();
+    test_sync_failure();
+    return report("mapped_file_test");
+}
@@ -0,0 +1,101 @@
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include "prelude/runtime/mempool.hpp"
+
+using namespace testing;
+using namespace copperhead;
+
+//Blocks freed by another thread, which then exits, are still counted
+void test_counters_across_threads() {
+    mempool_stats before = get_stats(cpp_tag());
+    std::vector<void*> blocks;
+    for(int i = 0; i < 100; i++) {
+        blocks.push_back(copperhead::malloc(cpp_tag(), 1000));
+    }
+    mempool_stats allocated = get_stats(cpp_tag());
+    CHECK(allocated.live_bytes - before.live_bytes == 100 * 1024);
+    CHECK(allocated.requested_bytes - before.requested_bytes == 100 * 1000);
+    CHECK(allocated.hits + allocated.misses -
+          before.hits - before.misses == 100);
+    CHECK(allocated.histogram[9] - before.histogram[9] == 100);
+    CHECK(allocated.peak_live_bytes >= allocated.live_bytes);
+
+    std::thread other([&]() {
+            for(auto i = blocks.begin(); i != blocks.end(); i++) {
+                copperhead::free(cpp_tag(), *i);
+            }
+        });
+    other.join();
+    mempool_stats freed = get_stats(cpp_tag());
+    CHECK(freed.live_bytes == before.live_bytes);
+    CHECK(freed.requested_bytes == before.requested_bytes);
+    CHECK(freed.cached_bytes - before.cached_bytes == 100 * 1024);
+    CHECK(freed.peak_live_bytes >= allocated.live_bytes);
+
+    //The freed blocks serve the same size class
+    for(int i = 0; i < 100; i++) {
+        blocks[i] = copperhead::malloc(cpp_tag(), 1000);
+    }
+    mempool_stats reused = get_stats(cpp_tag());
+    CHECK(reused.hits - freed.hits == 100);
+    CHECK(reused.misses == freed.misses);
+    for(auto i = blocks.begin(); i != blocks.end(); i++) {
+        copperhead::free(cpp_tag(), *i);
+    }
+}
+
+//Requests are rounded up to size classes, four per power of two,
+//and a freed block serves any request of its class
+void test_size_classes() {
+    const size_t requests[] = {0, 1, 256, 257, 320, 321, 1000,
+                               ((size_t)1 << 20) + 1};
+    const size_t classes[] = {256, 256, 256, 320, 320, 384, 1024,
+                              5 * ((size_t)1 << 18)};
+    for(int i = 0; i < 8; i++) {
+        size_t live = get_stats(cpp_tag()).live_bytes;
+        void* p = copperhead::malloc(cpp_tag(), requests[i]);
+        CHECK(get_stats(cpp_tag()).live_bytes - live == classes[i]);
+        copperhead::free(cpp_tag(), p);
+    }
+    void* p = copperhead::malloc(cpp_tag(), 300);
+    copperhead::free(cpp_tag(), p);
+    mempool_stats before = get_stats(cpp_tag());
+    void* q = copperhead::malloc(cpp_tag(), 310);
+    CHECK(q == p);
+    CHECK(get_stats(cpp_tag()).hits - before.hits == 1);
+    copperhead::free(cpp_tag(), q);
+}
+
+//Trimming returns the least recently freed blocks first
+void test_trim() {
+    trim(cpp_tag(), 0);
+    CHECK(get_stats(cpp_tag()).cached_bytes == 0);
+    std::vector<void*> blocks;
+    for(int i = 0; i < 10; i++) {
+        blocks.push_back(copperhead::malloc(cpp_tag(), 1000));
+    }
+    void* young = copperhead::malloc(cpp_tag(), 1000);
+    for(auto i = blocks.begin(); i != blocks.end(); i++) {
+        copperhead::free(cpp_tag(), *i);
+    }
+    trim(cpp_tag(), 3 * 1024);
+    CHECK(get_stats(cpp_tag()).cached_bytes == 3 * 1024);
+
+    //young is freed after the last trim, so it outlives the others
+    copperhead::free(cpp_tag(), young);
+    trim(cpp_tag(), 1024);
+    CHECK(get_stats(cpp_tag()).cached_bytes == 1024);
+    void* reused = copperhead::malloc(cpp_tag(), 1000);
+    CHECK(reused == young);
+    copperhead::free(cpp_tag(), reused);
+    trim(cpp_tag(), 0);
+    CHECK(get_stats(cpp_tag()).cached_bytes == 0);
+}
+
+int main() {
+    test_counters_across_threads();
+    test_size_classes();
+    test_trim();
+    return report("mempool_test");
+}
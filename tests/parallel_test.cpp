@@ -0,0 +1,56 @@
+#include "program.hpp"
+
+using namespace testing;
+
+//n scalar procedures g0 ... gn-1, and an entry point f(a, b) which
+//maps each in turn over a running scan
+shared_ptr<const suite> many_procedures(int n) {
+    vector<shared_ptr<const statement> > procs;
+    vector<shared_ptr<const statement> > body;
+    string previous = "a";
+    for(int i = 0; i < n; i++) {
+        string g = "g" + std::to_string(i);
+        string c = "c" + std::to_string(i);
+        string s = "s" + std::to_string(i);
+        auto combine = var((i % 2) ? "op_add" : "op_mul", op());
+        procs.push_back(
+            proc(g, {scalar("x"), scalar("y")},
+                 {let(scalar("z"), invoke(combine,
+                                          {scalar("x"), scalar("y")})),
+                  give(scalar("z"))},
+                 int32_mt));
+        body.push_back(let(sequence(c), map2(g, previous, "b")));
+        body.push_back(let(sequence(s), scan(c)));
+        previous = s;
+    }
+    body.push_back(give(sequence(previous)));
+    procs.push_back(proc("f", {sequence("a"), sequence("b")},
+                         std::move(body), seq(int32_mt)));
+    return program(std::move(procs));
+}
+
+//Running passes on procedures in parallel produces exactly the code
+//a serial compilation does, whatever the number of threads
+void test_parallel_matches_serial() {
+    shared_ptr<const suite> p = many_procedures(16);
+    compiler serial("f", copperhead::cpp_tag());
+    serial.set_parallel(false);
+    string expected = serial.code(*p);
+    const std::size_t threads[] = {1, 2, 4, 0};
+    for(int i = 0; i < 4; i++) {
+        compiler parallel("f", copperhead::cpp_tag());
+        parallel.set_parallel(true, threads[i]);
+        //Repeated, so that differing schedules get a chance to show
+        bool same = true;
+        for(int j = 0; j < 5; j++) {
+            same = same && (parallel.code(*p) == expected);
+        }
+        CHECK(same);
+    }
+    CHECK(compiles(expected));
+}
+
+int main() {
+    test_parallel_matches_serial();
+    return report("parallel_test");
+}
@@ -0,0 +1,88 @@
+#include "program.hpp"
+
+using namespace testing;
+
+//The passes of a compilation, in the order they run
+const char* const pipeline[] = {
+    "backend::backend_translate",
+    "backend::segment",
+    "backend::tuple_break",
+    "backend::iterizer",
+    "backend::phase_analyze",
+    "backend::fuse",
+    "backend::type_convert",
+    "backend::functorize",
+    "backend::fuse_reductions",
+    "backend::thrust_rewriter",
+    "backend::dereference",
+    "backend::allocate",
+    "backend::wrap",
+    "backend::containerize",
+    "backend::recycle",
+    "backend::plan_memory",
+    "backend::schedule",
+    "backend::typedefify",
+    "backend::find_includes",
+    "backend::prune"};
+const size_t passes = sizeof(pipeline) / sizeof(pipeline[0]);
+
+//f(a, b), which returns a
+shared_ptr<const suite> identity() {
+    return entry({give(sequence("a"))});
+}
+
+//Each pass is profiled once, in pipeline order, and each starts
+//from what the pass before it produced
+void test_profiles() {
+    compiler comp("f", copperhead::cpp_tag());
+    comp.set_profiling(true);
+    comp.code(*identity());
+    const vector<pass_profile>& p = comp.profiles();
+    CHECK(p.size() == passes);
+    if (p.size() != passes) {
+        return;
+    }
+    bool ordered = true;
+    bool chained = true;
+    bool counted = true;
+    for(size_t i = 0; i < passes; i++) {
+        ordered = ordered && (p[i].name == pipeline[i]);
+        if (i > 0) {
+            chained = chained && (p[i].nodes_in == p[i-1].nodes_out);
+        }
+        counted = counted &&
+            (p[i].allocated + p[i].shared == p[i].nodes_out) &&
+            (p[i].seconds >= 0);
+    }
+    CHECK(ordered);
+    CHECK(chained);
+    CHECK(counted);
+    //The suite, the procedure, its name, its argument tuple, a and b,
+    //its body, the return and the a it returns
+    CHECK(p[0].nodes_in == 9);
+    //There is nothing to translate, so the first pass shares them all
+    CHECK(p[0].nodes_out == 9);
+    CHECK(p[0].shared == 9);
+    CHECK(p[0].allocated == 0);
+    //wrap adds a wrapper around f, and prune drops what isn't used
+    CHECK(p[12].nodes_out > p[12].nodes_in);
+    CHECK(p[passes-1].nodes_out < p[passes-1].nodes_in);
+
+    //Profiles are those of the most recent compilation only
+    comp.code(*identity());
+    CHECK(comp.profiles().size() == passes);
+    CHECK(comp.profiles()[0].nodes_in == 9);
+}
+
+void test_profiling_off() {
+    compiler comp("f", copperhead::cpp_tag());
+    comp.set_profiling(false);
+    comp.code(*identity());
+    CHECK(comp.profiles().empty());
+}
+
+int main() {
+    test_profiles();
+    test_profiling_off();
+    return report("pass_profile_test");
+}
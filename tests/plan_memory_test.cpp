@@ -0,0 +1,34 @@
+#include "program.hpp"
+
+using namespace testing;
+
+//A procedure whose temporaries are planned into a frame
+void test_planned_frame() {
+    auto a = var("a", seq(int32_mt));
+    auto b = var("b", seq(int32_mt));
+    auto c = var("c", seq(int32_mt));
+    auto d = var("d", seq(int32_mt));
+    auto op = fn({int32_mt, int32_mt}, int32_mt);
+    auto scan = var("scan", fn({op, seq(int32_mt)}, seq(int32_mt)));
+    auto map2 = var("map2", fn({op, seq(int32_mt), seq(int32_mt)},
+                               seq(int32_mt)));
+    auto p = proc(
+        "f", {a},
+        {let(b, invoke(scan, {var("op_add", op), a})),
+         let(c, invoke(scan, {var("op_add", op), b})),
+         let(d, invoke(map2, {var("op_add", op), b, c})),
+         give(d)},
+        seq(int32_mt));
+    compiler comp("f", copperhead::cpp_tag());
+    comp.set_memory_plan(true);
+    string code = comp.code(*program({p}));
+    CHECK(contains(code, "reserve<int >(frame0, arya);"));
+    CHECK(contains(code, "begin_frame(frame0, cpp_tag());"));
+    CHECK(!contains(code, "void cpp_tag()"));
+    CHECK(compiles(code));
+}
+
+int main() {
+    test_planned_frame();
+    return report("plan_memory_test");
+}
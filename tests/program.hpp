@@ -0,0 +1,213 @@
+/*
+ *   Copyright 2012      NVIDIA Corporation
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ */
+
+//Helpers shared by the tests: building small programs and compiling
+//them.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <unistd.h>
+#include "node.hpp"
+#include "expression.hpp"
+#include "statement.hpp"
+#include "monotype.hpp"
+#include "polytype.hpp"
+#include "compiler.hpp"
+#include "prelude/runtime/tags.h"
+#include "import/paths.hpp"
+#include "thrust/decl.hpp"
+#include "check.hpp"
+
+namespace testing {
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using namespace backend;
+
+//Types
+
+inline shared_ptr<const type_t> seq(const shared_ptr<const type_t>& t) {
+    return std::make_shared<const sequence_t>(t);
+}
+
+inline shared_ptr<const type_t> fn(
+    vector<shared_ptr<const type_t> > args,
+    const shared_ptr<const type_t>& result) {
+    return std::make_shared<const fn_t>(
+        std::make_shared<const tuple_t>(std::move(args)),
+        result);
+}
+
+//Expressions
+
+inline shared_ptr<const name> var(const string& id,
+                                  const shared_ptr<const type_t>& t) {
+    return std::make_shared<const name>(id, t);
+}
+
+inline shared_ptr<const literal> lit(const string& v,
+                                     const shared_ptr<const type_t>& t) {
+    return std::make_shared<const literal>(v, t);
+}
+
+inline shared_ptr<const apply> invoke(
+    const shared_ptr<const name>& f,
+    vector<shared_ptr<const expression> > args) {
+    return std::make_shared<const apply>(
+        f, std::make_shared<const tuple>(std::move(args)));
+}
+
+//Statements
+
+inline shared_ptr<const statement> let(
+    const shared_ptr<const name>& lhs,
+    const shared_ptr<const expression>& rhs) {
+    return std::make_shared<const bind>(lhs, rhs);
+}
+
+inline shared_ptr<const statement> give(
+    const shared_ptr<const expression>& v) {
+    return std::make_shared<const ret>(v);
+}
+
+//A procedure with the given arguments and body, whose type is built
+//from the types of its arguments and its result
+inline shared_ptr<const procedure> proc(
+    const string& id,
+    vector<shared_ptr<const name> > args,
+    vector<shared_ptr<const statement> > body,
+    const shared_ptr<const type_t>& result) {
+    vector<shared_ptr<const expression> > arg_exprs;
+    vector<shared_ptr<const type_t> > arg_types;
+    for(auto i = args.begin(); i != args.end(); i++) {
+        arg_exprs.push_back(*i);
+        arg_types.push_back((*i)->type().ptr());
+    }
+    shared_ptr<const type_t> t = fn(std::move(arg_types), result);
+    return std::make_shared<const procedure>(
+        var(id, t),
+        std::make_shared<const tuple>(std::move(arg_exprs)),
+        std::make_shared<const suite>(std::move(body)),
+        t);
+}
+
+inline shared_ptr<const suite> program(
+    vector<shared_ptr<const statement> > procs) {
+    return std::make_shared<const suite>(std::move(procs));
+}
+
+//Common names and primitives, over ints
+
+//The type of a binary operator on ints
+inline shared_ptr<const type_t> op() {
+    return fn({int32_mt, int32_mt}, int32_mt);
+}
+
+inline shared_ptr<const name> scalar(const string& id) {
+    return var(id, int32_mt);
+}
+
+inline shared_ptr<const name> sequence(const string& id) {
+    return var(id, seq(int32_mt));
+}
+
+inline shared_ptr<const name> nested(const string& id) {
+    return var(id, seq(seq(int32_mt)));
+}
+
+//map2(f, x, y), where f is a binary operator
+inline shared_ptr<const apply> map2(const string& f,
+                                    const string& x, const string& y) {
+    return invoke(var("map2", fn({op(), seq(int32_mt), seq(int32_mt)},
+                                 seq(int32_mt))),
+                  {var(f, op()), sequence(x), sequence(y)});
+}
+
+//scan(op_add, x)
+inline shared_ptr<const apply> scan(const string& x) {
+    return invoke(var("scan", fn({op(), seq(int32_mt)}, seq(int32_mt))),
+                  {var("op_add", op()), sequence(x)});
+}
+
+//A program whose entry point f(a, b) takes two sequences
+inline shared_ptr<const suite> entry(
+    vector<shared_ptr<const statement> > body,
+    const shared_ptr<const type_t>& result = seq(int32_mt)) {
+    return program(
+        {proc("f", {sequence("a"), sequence("b")}, std::move(body),
+              result)});
+}
+
+//Compiling
+
+//Compiles a program with entry point f for the cpp backend
+inline string compile(const suite& p) {
+    compiler comp("f", copperhead::cpp_tag());
+    return comp.code(p);
+}
+
+inline string compile(
+    vector<shared_ptr<const statement> > body,
+    const shared_ptr<const type_t>& result = seq(int32_mt)) {
+    return compile(*entry(std::move(body), result));
+}
+
+//Checks that generated code is accepted by the C++ compiler, against
+//the prelude and Thrust found through the PRELUDE_PATH and
+//THRUST_PATH environment variables, as the compiler finds them.
+//The code is preceded by the runtime headers and namespace which the
+//frontend puts before it.
+//Returns true without checking when Thrust can not be found.
+inline bool compiles(const string& code) {
+    string prelude(backend::detail::get_path(PRELUDE_PATH));
+    string thrust(backend::detail::get_path(THRUST_PATH));
+    if (access((thrust + "/thrust/host_vector.h").c_str(), R_OK) != 0) {
+        std::cout << "(Thrust not found, generated code not compiled)"
+                  << std::endl;
+        return true;
+    }
+    char path[] = "/tmp/copperhead_testXXXXXX.cpp";
+    int fd = mkstemps(path, 4);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    {
+        std::ofstream out(path);
+        out << "#include <prelude/prelude.h>\n"
+            << "#include <prelude/runtime/make_cuarray.hpp>\n"
+            << "#include <prelude/runtime/make_sequence.hpp>\n"
+            << "using namespace copperhead;\n"
+            << code;
+    }
+    string cmd = "c++ -std=c++0x -fsyntax-only -I" + prelude +
+        " -I" + prelude + "/.. -I" + thrust + " " + path;
+    int status = std::system(cmd.c_str());
+    unlink(path);
+    if (status != 0) {
+        std::cout << code << std::endl;
+    }
+    return status == 0;
+}
+
+}
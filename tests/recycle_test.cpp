@@ -0,0 +1,40 @@
+#include "program.hpp"
+
+using namespace testing;
+
+//Temporaries which die right before the entry point returns are left
+//for the return to release
+void test_release_before_return() {
+    string code = compile(
+        {let(sequence("c"), scan("a")),
+         let(sequence("e"), scan("c")),
+         let(sequence("d"), map2("op_add", "c", "e")),
+         give(sequence("d"))});
+    CHECK(contains(code, "Tarycompd arycompd = phase_boundary(d);"));
+    CHECK(!contains(code, "release("));
+    CHECK(compiles(code));
+}
+
+//Temporaries which die before more work are released after their
+//last use
+void test_release_before_work() {
+    string code = compile(
+        {let(sequence("c"), scan("a")),
+         let(sequence("h"), scan("c")),
+         let(sequence("d"), map2("op_add", "c", "h")),
+         let(sequence("e"), scan("d")),
+         let(sequence("g"), scan("e")),
+         give(sequence("g"))});
+    CHECK(contains(code,
+                   "Tarye arye = scan(fn_op_add<int >(), d);\n"
+                   "    release(aryc);\n"
+                   "    release(aryh);\n"));
+    CHECK(contains(code, "scan_in_place(fn_op_add<int >(), e, arye);"));
+    CHECK(compiles(code));
+}
+
+int main() {
+    test_release_before_return();
+    test_release_before_work();
+    return report("recycle_test");
+}
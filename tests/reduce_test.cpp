@@ -0,0 +1,116 @@
+#include <vector>
+#include <algorithm>
+#include "check.hpp"
+#include "prelude/prelude.h"
+#include "prelude/primitives/reduce.h"
+
+using namespace testing;
+using namespace copperhead;
+
+sp_cuarray make_flat(const std::vector<int>& v) {
+    sp_cuarray result = make_cuarray<int>(v.size());
+    sequence<cpp_tag, int> x =
+        make_sequence<sequence<cpp_tag, int> >(result, cpp_tag(), true);
+    std::copy(v.begin(), v.end(), x.m_d);
+    return result;
+}
+
+//Fused reductions agree with separate ones
+void test_fused_reductions() {
+    std::vector<int> values;
+    for(int i = 1; i <= 100; i++) {
+        values.push_back(i);
+    }
+    sp_cuarray x_ary = make_flat(values);
+    std::reverse(values.begin(), values.end());
+    sp_cuarray y_ary = make_flat(values);
+    sequence<cpp_tag, int> x =
+        make_sequence<sequence<cpp_tag, int> >(x_ary, cpp_tag(), false);
+    sequence<cpp_tag, int> y =
+        make_sequence<sequence<cpp_tag, int> >(y_ary, cpp_tag(), false);
+
+    thrust::tuple<int, int> r2 =
+        reduce2(thrust::plus<int>(), x, 0,
+                thrust::maximum<int>(), y, 0);
+    CHECK(thrust::get<0>(r2) == 5050);
+    CHECK(thrust::get<0>(r2) == reduce(thrust::plus<int>(), x, 0));
+    CHECK(thrust::get<1>(r2) == 100);
+
+    thrust::tuple<int, int, int> r3 =
+        reduce3(thrust::plus<int>(), x, 0,
+                thrust::maximum<int>(), y, 0,
+                thrust::minimum<int>(), x, 1000);
+    CHECK(thrust::get<0>(r3) == 5050);
+    CHECK(thrust::get<1>(r3) == 100);
+    CHECK(thrust::get<2>(r3) == 1);
+
+    thrust::tuple<int, int, int, int> r4 =
+        reduce4(thrust::plus<int>(), x, 0,
+                thrust::maximum<int>(), y, 0,
+                thrust::minimum<int>(), x, 1000,
+                thrust::plus<int>(), y, 5);
+    CHECK(thrust::get<0>(r4) == 5050);
+    CHECK(thrust::get<1>(r4) == 100);
+    CHECK(thrust::get<2>(r4) == 1);
+    CHECK(thrust::get<3>(r4) == 5055);
+}
+
+//Reducing empty sequences gives the prefixes
+void test_empty() {
+    sp_cuarray e_ary = make_flat(std::vector<int>());
+    sequence<cpp_tag, int> e =
+        make_sequence<sequence<cpp_tag, int> >(e_ary, cpp_tag(), false);
+    thrust::tuple<int, int> r2 =
+        reduce2(thrust::plus<int>(), e, 3,
+                thrust::maximum<int>(), e, -7);
+    CHECK(thrust::get<0>(r2) == 3);
+    CHECK(thrust::get<1>(r2) == -7);
+}
+
+//The larger of x and y, but no more than cap
+struct capped_max {
+    typedef int result_type;
+    int operator()(const int& x, const int& y, const int& cap) const {
+        return std::min(std::max(x, y), cap);
+    }
+};
+
+//The combined reduction functions may be called through const
+//references, as Thrust calls them, and may combine closures
+void test_const_functions() {
+    thrust::plus<int> plus;
+    thrust::maximum<int> maximum;
+    const detail::reduce_fn2<thrust::plus<int>, thrust::maximum<int> > f2(
+        plus, maximum);
+    thrust::tuple<int, int> r2 = f2(thrust::make_tuple(1, 5),
+                                    thrust::make_tuple(2, 3));
+    CHECK(thrust::get<0>(r2) == 3);
+    CHECK(thrust::get<1>(r2) == 5);
+
+    std::vector<int> values;
+    for(int i = 1; i <= 100; i++) {
+        values.push_back(i);
+    }
+    sp_cuarray x_ary = make_flat(values);
+    sequence<cpp_tag, int> x =
+        make_sequence<sequence<cpp_tag, int> >(x_ary, cpp_tag(), false);
+    typedef closure<capped_max, thrust::tuple<int> > capped;
+    thrust::tuple<int, int> r =
+        reduce2(capped(capped_max(), thrust::make_tuple(50)), x, 0,
+                thrust::plus<int>(), x, 0);
+    CHECK(thrust::get<0>(r) == 50);
+    CHECK(thrust::get<1>(r) == 5050);
+
+    //The prelude's functors are only callable when not const
+    thrust::tuple<int, int> s =
+        reduce2(fn_op_add<int>(), x, 0, fn_op_add<int>(), x, 1);
+    CHECK(thrust::get<0>(s) == 5050);
+    CHECK(thrust::get<1>(s) == 5051);
+}
+
+int main() {
+    test_fused_reductions();
+    test_empty();
+    test_const_functions();
+    return report("reduce_test");
+}
@@ -0,0 +1,44 @@
+#include "program.hpp"
+
+using namespace testing;
+
+//Two independent scans, whose results are combined
+string compile(bool task_graph) {
+    compiler comp("f", copperhead::cpp_tag());
+    comp.set_task_graph(task_graph);
+    return comp.code(*entry(
+        {let(sequence("c"), map2("op_add", "a", "b")),
+         let(sequence("d"), scan("c")),
+         let(sequence("e"), scan("a")),
+         let(sequence("g"), map2("op_add", "d", "e")),
+         give(sequence("g"))}));
+}
+
+//The first scan runs on a worker while the second runs in the
+//caller, and is joined before its result is used
+void test_spawn_independent() {
+    string code = compile(true);
+    CHECK(contains(code,
+                   "Ttask0 task0 = spawn(scan_task<sp_cuarray >(), "
+                   "fn_op_add<int >(), c);"));
+    CHECK(contains(code, "Tarye arye = scan(fn_op_add<int >(), a);"));
+    size_t joined = code.find("Taryd aryd = join(task0);");
+    CHECK(joined != string::npos);
+    CHECK(joined < code.find("Td d = make_sequence"));
+    CHECK(compiles(code));
+}
+
+//Without the task graph, primitives run in program order
+void test_disabled() {
+    string code = compile(false);
+    CHECK(!contains(code, "spawn("));
+    CHECK(!contains(code, "join("));
+    CHECK(code.find("aryd = scan(") < code.find("arye = scan("));
+    CHECK(compiles(code));
+}
+
+int main() {
+    test_spawn_independent();
+    test_disabled();
+    return report("schedule_test");
+}
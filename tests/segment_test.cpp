@@ -0,0 +1,111 @@
+#include "program.hpp"
+
+using namespace testing;
+
+//map1(f, xss), where f takes a sequence and returns result
+shared_ptr<const statement> map1(const shared_ptr<const name>& lhs,
+                                 const string& f,
+                                 const shared_ptr<const type_t>& result) {
+    auto f_t = fn({seq(int32_mt)}, result);
+    auto map1 = var("map1", fn({f_t, seq(seq(int32_mt))}, lhs->type().ptr()));
+    return let(lhs, invoke(map1, {var(f, f_t), nested("xss")}));
+}
+
+//total(xs) = sum(xs)
+shared_ptr<const statement> total() {
+    auto sum = var("sum", fn({seq(int32_mt)}, int32_mt));
+    return proc("total", {sequence("xs")},
+                {let(scalar("s"), invoke(sum, {sequence("xs")})),
+                 give(scalar("s"))},
+                int32_mt);
+}
+
+//prefix(xs) = scan(op_add, xs)
+shared_ptr<const statement> prefix() {
+    auto scan = var("scan", fn({op(), seq(int32_mt)}, seq(int32_mt)));
+    return proc("prefix", {sequence("xs")},
+                {let(sequence("ys"), invoke(scan, {var("op_add", op()),
+                                                   sequence("xs")})),
+                 give(sequence("ys"))},
+                seq(int32_mt));
+}
+
+//Maps whose function reduces or scans its argument become
+//segmented primitives over the whole nested sequence.  The procedures
+//mapped are still emitted, and the prelude has no sum or scan of a
+//single segment for them to call, so the output is not compiled.
+void test_segmented_reduction_and_scan() {
+    string code = compile(*program(
+        {total(),
+         prefix(),
+         proc("f", {nested("xss")},
+              {map1(sequence("t"), "total", int32_mt),
+               map1(nested("u"), "prefix", seq(int32_mt)),
+               map1(sequence("v"), "sum", int32_mt),
+               give(nested("u"))},
+              seq(seq(int32_mt)))}));
+    CHECK(contains(code, "Taryt aryt = segmented_sum(xss);"));
+    CHECK(contains(code,
+                   "Taryu aryu = segmented_scan(fn_op_add<int >(), xss);"));
+    CHECK(contains(code, "Taryv aryv = segmented_sum(xss);"));
+    CHECK(!contains(code, "map1("));
+}
+
+//map(sum, xss) alone needs nothing but the segmented primitive
+void test_segmented_sum() {
+    string code = compile(*program(
+        {proc("f", {nested("xss")},
+              {map1(sequence("t"), "sum", int32_mt),
+               give(sequence("t"))},
+              seq(int32_mt))}));
+    CHECK(contains(code, "Taryt aryt = segmented_sum(xss);"));
+    CHECK(compiles(code));
+}
+
+//A function which only maps its argument maps the elements of every
+//segment at once.  The procedure mapped still returns a sequence,
+//which emitted procedures can not, so the output is not compiled.
+void test_segmented_map() {
+    auto neg_t = fn({int32_mt}, int32_mt);
+    auto map1 = var("map1", fn({neg_t, seq(int32_mt)}, seq(int32_mt)));
+    string code = compile(*program(
+        {proc("negate", {sequence("xs")},
+              {let(sequence("ys"), invoke(map1, {var("op_neg", neg_t),
+                                                 sequence("xs")})),
+               give(sequence("ys"))},
+              seq(int32_mt)),
+         proc("f", {nested("xss")},
+              {::map1(nested("u"), "negate", seq(int32_mt)),
+               give(nested("u"))},
+              seq(seq(int32_mt)))}));
+    CHECK(contains(code,
+                   "Taryu aryu = segmented_map1(fn_op_neg<int >(), xss);"));
+    CHECK(!contains(code, "map1(fn_negate"));
+}
+
+//A function which does more than apply one primitive is mapped
+//segment by segment.  It calls sum, so the output is not compiled.
+void test_unsegmentable() {
+    auto sum = var("sum", fn({seq(int32_mt)}, int32_mt));
+    auto op_add = var("op_add", op());
+    string code = compile(*program(
+        {proc("twice", {sequence("xs")},
+              {let(scalar("s"), invoke(sum, {sequence("xs")})),
+               let(scalar("t"), invoke(op_add, {scalar("s"), scalar("s")})),
+               give(scalar("t"))},
+              int32_mt),
+         proc("f", {nested("xss")},
+              {map1(sequence("t"), "twice", int32_mt),
+               give(sequence("t"))},
+              seq(int32_mt))}));
+    CHECK(contains(code, "Tt t = map1(fn_twice(), xss);"));
+    CHECK(!contains(code, "segmented_"));
+}
+
+int main() {
+    test_segmented_reduction_and_scan();
+    test_segmented_sum();
+    test_segmented_map();
+    test_unsegmentable();
+    return report("segment_test");
+}
@@ -0,0 +1,154 @@
+#include <vector>
+#include <algorithm>
+#include "check.hpp"
+#include "prelude/prelude.h"
+#include "prelude/primitives/segmented.h"
+
+using namespace testing;
+using namespace copperhead;
+
+typedef std::vector<std::vector<int> > segments;
+
+sp_cuarray make_nested(const segments& s) {
+    size_t total = 0;
+    for(size_t i = 0; i < s.size(); i++) {
+        total += s[i].size();
+    }
+    sp_cuarray result = make_nested_cuarray<int>(s.size(), total);
+    sequence<cpp_tag, int, 1> x =
+        make_sequence<sequence<cpp_tag, int, 1> >(result, cpp_tag(), true);
+    size_t offset = 0;
+    for(size_t i = 0; i < s.size(); i++) {
+        x.m_d[i] = offset;
+        std::copy(s[i].begin(), s[i].end(), x.m_s.m_d + offset);
+        offset += s[i].size();
+    }
+    x.m_d[s.size()] = offset;
+    return result;
+}
+
+std::vector<int> flat_contents(const sp_cuarray& a) {
+    sequence<cpp_tag, int> x =
+        make_sequence<sequence<cpp_tag, int> >(a, cpp_tag(), false);
+    return std::vector<int>(x.m_d, x.m_d + x.size());
+}
+
+segments nested_contents(const sp_cuarray& a) {
+    sequence<cpp_tag, int, 1> x =
+        make_sequence<sequence<cpp_tag, int, 1> >(a, cpp_tag(), false);
+    segments result;
+    for(size_t i = 0; i < x.size(); i++) {
+        result.push_back(std::vector<int>(x.m_s.m_d + x.m_d[i],
+                                          x.m_s.m_d + x.m_d[i + 1]));
+    }
+    return result;
+}
+
+//Empty segments around a segment far longer than the others
+segments skewed() {
+    segments s(5);
+    s[1].push_back(1);
+    s[1].push_back(2);
+    s[1].push_back(3);
+    s[3].assign(1000, 1);
+    return s;
+}
+
+//Runs merge_path_tile over segment ends d, and checks that every
+//element is keyed by the segment holding it
+void check_keys(const std::vector<size_t>& d) {
+    size_t n = d.size() - 1;
+    size_t l = d[n] - d[0];
+    std::vector<detail::segment_key> keys(l, n);
+    size_t tiles = (n + l + detail::merge_path_tile_size - 1) /
+        detail::merge_path_tile_size;
+    detail::merge_path_tile tile(&d[0], n, l, keys.empty() ? 0 : &keys[0]);
+    for(size_t t = 0; t < tiles; t++) {
+        tile(t);
+    }
+    size_t i = 0;
+    for(size_t j = 0; j < l; j++) {
+        while(d[i + 1] - d[0] <= j) {
+            i++;
+        }
+        CHECK(keys[j] == (detail::segment_key)i);
+    }
+}
+
+void test_merge_path_tile() {
+    //Skewed segments, spanning several tiles
+    size_t skewed_ends[] = {0, 1, 2, 1002};
+    check_keys(std::vector<size_t>(skewed_ends, skewed_ends + 4));
+    //Empty segments, first, last and in between
+    size_t empty_ends[] = {0, 0, 0, 3, 3, 3, 700, 700};
+    check_keys(std::vector<size_t>(empty_ends, empty_ends + 8));
+    //Segments which don't start at the first element
+    size_t offset_ends[] = {5, 5, 9, 9, 600};
+    check_keys(std::vector<size_t>(offset_ends, offset_ends + 5));
+    //No elements at all
+    size_t no_elements[] = {4, 4, 4};
+    check_keys(std::vector<size_t>(no_elements, no_elements + 3));
+}
+
+void test_segmented_reduce() {
+    sp_cuarray xss_ary = make_nested(skewed());
+    sequence<cpp_tag, int, 1> xss =
+        make_sequence<sequence<cpp_tag, int, 1> >(xss_ary, cpp_tag(), false);
+    std::vector<int> reduced =
+        flat_contents(segmented_reduce(thrust::plus<int>(), xss, 10));
+    int expected_reduced[] = {10, 16, 10, 1010, 10};
+    CHECK(reduced == std::vector<int>(expected_reduced, expected_reduced + 5));
+    std::vector<int> sums = flat_contents(segmented_sum(xss));
+    int expected_sums[] = {0, 6, 0, 1000, 0};
+    CHECK(sums == std::vector<int>(expected_sums, expected_sums + 5));
+}
+
+struct doubled {
+    typedef int result_type;
+    int operator()(const int& x) const {
+        return 2 * x;
+    }
+};
+
+//Mapping the elements keeps the shape of the segments
+void test_segmented_map1() {
+    sp_cuarray xss_ary = make_nested(skewed());
+    sequence<cpp_tag, int, 1> xss =
+        make_sequence<sequence<cpp_tag, int, 1> >(xss_ary, cpp_tag(), false);
+    segments mapped = nested_contents(segmented_map1(doubled(), xss));
+    CHECK(mapped.size() == 5);
+    CHECK(mapped[0].empty() && mapped[2].empty() && mapped[4].empty());
+    int expected[] = {2, 4, 6};
+    CHECK(mapped[1] == std::vector<int>(expected, expected + 3));
+    CHECK(mapped[3] == std::vector<int>(1000, 2));
+}
+
+void test_segmented_scans() {
+    sp_cuarray xss_ary = make_nested(skewed());
+    sequence<cpp_tag, int, 1> xss =
+        make_sequence<sequence<cpp_tag, int, 1> >(xss_ary, cpp_tag(), false);
+    segments scanned =
+        nested_contents(segmented_scan(thrust::plus<int>(), xss));
+    CHECK(scanned.size() == 5);
+    CHECK(scanned[0].empty() && scanned[2].empty() && scanned[4].empty());
+    int expected[] = {1, 3, 6};
+    CHECK(scanned[1] == std::vector<int>(expected, expected + 3));
+    CHECK(scanned[3].size() == 1000);
+    CHECK(scanned[3].front() == 1 && scanned[3].back() == 1000);
+
+    segments exclusive = nested_contents(
+        segmented_exclusive_scan(thrust::plus<int>(), 10, xss));
+    int expected_exclusive[] = {10, 11, 13};
+    CHECK(exclusive[1] ==
+          std::vector<int>(expected_exclusive, expected_exclusive + 3));
+    CHECK(exclusive[3].front() == 10 && exclusive[3].back() == 1009);
+    CHECK(exclusive[4].empty());
+}
+
+int main() {
+    test_merge_path_tile();
+    test_segmented_reduce();
+    test_segmented_map1();
+    test_segmented_scans();
+    return report("segmented_test");
+}
@@ -0,0 +1,44 @@
+#include <thread>
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include "check.hpp"
+#include "symbol.hpp"
+
+using namespace testing;
+using backend::symbol;
+
+//Threads interning the same identifiers agree on their ids, and
+//distinct identifiers get distinct ids
+void test_concurrent_interning() {
+    const int thread_count = 8;
+    const int name_count = 1000;
+    std::vector<std::vector<unsigned int> > ids(thread_count);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < thread_count; t++) {
+        threads.push_back(std::thread([&ids, t]() {
+                    for(int i = 0; i < name_count; i++) {
+                        symbol s("symbol_test_" + std::to_string(i));
+                        ids[t].push_back(s.id());
+                    }
+                }));
+    }
+    for(auto i = threads.begin(); i != threads.end(); i++) {
+        i->join();
+    }
+    for(int t = 1; t < thread_count; t++) {
+        CHECK(ids[t] == ids[0]);
+    }
+    std::unordered_set<unsigned int> distinct(ids[0].begin(), ids[0].end());
+    CHECK(distinct.size() == name_count);
+    symbol s("symbol_test_7");
+    CHECK(s.id() == ids[0][7]);
+    CHECK(s.str() == "symbol_test_7");
+    CHECK(s == symbol(std::string("symbol_test_7")));
+    CHECK(s != symbol("symbol_test_8"));
+}
+
+int main() {
+    test_concurrent_interning();
+    return report("symbol_test");
+}
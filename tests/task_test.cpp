@@ -0,0 +1,73 @@
+#include "check.hpp"
+#include "prelude/runtime/task.hpp"
+#include "prelude/runtime/frame.hpp"
+#include "prelude/runtime/make_cuarray.hpp"
+#include "prelude/runtime/make_sequence.hpp"
+#include "prelude/runtime/mempool.hpp"
+
+using namespace testing;
+using namespace copperhead;
+
+//Allocates a temporary of n ints and reports the frame it ran in
+struct temporary {
+    typedef frame* result_type;
+    frame* operator()(size_t n) const {
+        sp_cuarray a = make_cuarray<int>(n);
+        make_sequence<sequence<cpp_tag, int> >(a, cpp_tag(), true);
+        return detail::current_frame();
+    }
+};
+
+//Number of allocations the memory pool has served
+size_t allocations() {
+    mempool_stats s = get_stats(cpp_tag());
+    return s.hits + s.misses;
+}
+
+//Spawned computations carve their temporaries from the frame which
+//was current where they were spawned
+void test_spawn_in_frame() {
+    sp_frame f = make_frame();
+    f->reserve(4 * (1000 * sizeof(int) + detail::frame_alignment));
+    begin_frame(f, cpp_tag());
+    size_t before = allocations();
+    future<frame*> tasks[4];
+    for(int i = 0; i < 4; i++) {
+        tasks[i] = spawn(temporary(), 1000);
+    }
+    bool framed = true;
+    for(int i = 0; i < 4; i++) {
+        framed = framed && (join(tasks[i]) == f.get());
+    }
+    CHECK(framed);
+    CHECK(allocations() == before);
+    //The frame is exhausted, so more temporaries come from the pool
+    join(spawn(temporary(), 1000));
+    CHECK(allocations() > before);
+    pause_frame(f);
+}
+
+//Computations spawned outside any frame run outside any frame, even
+//when a thread waiting in a frame runs them
+void test_spawn_outside_frame() {
+    future<frame*> tasks[16];
+    for(int i = 0; i < 16; i++) {
+        tasks[i] = spawn(temporary(), 10);
+    }
+    sp_frame f = make_frame();
+    f->reserve(1000);
+    begin_frame(f, cpp_tag());
+    bool unframed = true;
+    for(int i = 0; i < 16; i++) {
+        unframed = unframed && (join(tasks[i]) == NULL);
+    }
+    CHECK(unframed);
+    CHECK(detail::current_frame() == f.get());
+    pause_frame(f);
+}
+
+int main() {
+    test_spawn_in_frame();
+    test_spawn_outside_frame();
+    return report("task_test");
+}
@@ -0,0 +1,60 @@
+#include "program.hpp"
+
+using namespace testing;
+
+//The asynchronous wrapper returns the future spawn gives it
+void test_async_wrapper() {
+    compiler comp("f", copperhead::cpp_tag());
+    comp.set_async(true);
+    string code = comp.code(
+        *entry({let(sequence("c"), map2("op_add", "a", "b")),
+                give(sequence("c"))}));
+    CHECK(contains(code, "future<sp_cuarray> asyncf(sp_cuarray arya, sp_cuarray aryb)"));
+    CHECK(contains(code, "typedef future<sp_cuarray> Tresult;"));
+    CHECK(contains(code, "Tresult result = spawn(f, arya, aryb);"));
+    CHECK(contains(code, "return result;"));
+    CHECK(!contains(code, "void spawn"));
+    CHECK(compiles(code));
+}
+
+//The batched wrapper maps the body over the segments of the sequence
+//arguments, and results are gathered by batch
+void test_batch_wrapper() {
+    compiler comp("f", copperhead::cpp_tag());
+    comp.set_batch(true);
+    string code = comp.code(
+        *entry({let(sequence("c"), map2("op_add", "a", "b")),
+                give(sequence("c"))}));
+    CHECK(contains(code, "sp_cuarray bodyf(sequence<cpp_tag, int> a, sequence<cpp_tag, int> b)"));
+    CHECK(contains(code, "sp_cuarray batchf(sp_cuarray arya, sp_cuarray aryb)"));
+    CHECK(contains(code, "return batch<int >(bodyf, arya, aryb);"));
+    CHECK(contains(code, "#include \"prelude/runtime/batch.hpp\""));
+    CHECK(compiles(code));
+}
+
+//Scalar arguments are passed to every invocation, and scalar results
+//are gathered into a flat cuarray
+void test_batch_scalars() {
+    compiler comp("f", copperhead::cpp_tag());
+    comp.set_batch(true);
+    auto reduce = var("reduce", fn({op(), seq(int32_mt), int32_mt},
+                                   int32_mt));
+    string code = comp.code(*program(
+        {proc("f", {sequence("a"), scalar("k")},
+              {let(scalar("s"), invoke(reduce, {var("op_add", op()),
+                                                sequence("a"),
+                                                scalar("k")})),
+               give(scalar("s"))},
+              int32_mt)}));
+    CHECK(contains(code, "int bodyf(sequence<cpp_tag, int> a, int k)"));
+    CHECK(contains(code, "sp_cuarray batchf(sp_cuarray arya, int k)"));
+    CHECK(contains(code, "return batch<int >(bodyf, arya, k);"));
+    CHECK(compiles(code));
+}
+
+int main() {
+    test_async_wrapper();
+    test_batch_wrapper();
+    test_batch_scalars();
+    return report("wrap_test");
+}